@@ -0,0 +1,185 @@
+#include "BenchmarkSuite.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+
+namespace
+{
+    std::string toJsonString(const std::string& str)
+    {
+        std::string json = "\"";
+        for (char c : str)
+        {
+            if (c == '"' || c == '\\')
+                json += '\\';
+            json += ((unsigned char) c < 0x20) ? ' ' : c;
+        }
+        json += '"';
+        return json;
+    }
+
+    std::string toJsonNumber(double value)
+    {
+        if (!std::isfinite(value))
+            return "null";
+
+        std::ostringstream str;
+        str << std::setprecision(10) << value;
+        return str.str();
+    }
+}
+
+/******************************************************************************
+ * BenchmarkResult
+ ******************************************************************************/
+
+double BenchmarkResult::getQuantile(double quantile) const
+{
+    if (milliseconds.empty())
+        return 0;
+
+    // Nearest rank on a sorted copy
+    std::vector<double> sorted = milliseconds;
+    std::sort(sorted.begin(), sorted.end());
+
+    size_t rank = (size_t) std::ceil(quantile * sorted.size());
+    return sorted[std::clamp(rank, (size_t) 1, sorted.size()) - 1];
+}
+
+double BenchmarkResult::getMean() const
+{
+    return milliseconds.empty() ? 0 : getTotal() / milliseconds.size();
+}
+
+double BenchmarkResult::getTotal() const
+{
+    return std::accumulate(milliseconds.begin(), milliseconds.end(), 0.0);
+}
+
+double BenchmarkResult::getThroughput() const
+{
+    double total = getTotal();
+    return total > 0 ? numItems / (total / 1000) : 0;
+}
+
+/******************************************************************************
+ * BenchmarkSuite
+ ******************************************************************************/
+
+bool BenchmarkSuite::isSelected(const std::string& name) const
+{
+    return _filter.empty() || name.find(_filter) != std::string::npos;
+}
+
+const BenchmarkResult& BenchmarkSuite::run(const std::string& name, const std::string& unit, int iterations, const Iteration& iteration, int warmupIterations)
+{
+    return run(name, unit, iterations, nullptr, iteration, warmupIterations);
+}
+
+const BenchmarkResult& BenchmarkSuite::run(const std::string& name, const std::string& unit, int iterations, const Setup& setup, const Iteration& iteration, int warmupIterations)
+{
+    BenchmarkResult result;
+    result.name = name;
+    result.unit = unit;
+    result.milliseconds.reserve(iterations);
+
+    std::cout << "Running " << name << "..." << std::endl;
+
+    for (int i = 0; i < warmupIterations; i++)
+    {
+        if (setup) setup(i);
+        iteration(i);
+    }
+
+    for (int i = 0; i < iterations; i++)
+    {
+        if (setup) setup(warmupIterations + i);
+
+        auto start = std::chrono::steady_clock::now();
+        double numItems = iteration(warmupIterations + i);
+        auto end = std::chrono::steady_clock::now();
+
+        result.milliseconds.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        result.numItems += numItems;
+    }
+
+    _results.push_back(std::move(result));
+    return _results.back();
+}
+
+void BenchmarkSuite::addMetadata(const std::string& key, const std::string& value)
+{
+    _metadata.emplace_back(key, toJsonString(value));
+}
+
+void BenchmarkSuite::addMetadata(const std::string& key, double value)
+{
+    _metadata.emplace_back(key, toJsonNumber(value));
+}
+
+void BenchmarkSuite::printSummary() const
+{
+    std::cout << std::left << std::setw(44) << "Benchmark" << std::right
+        << std::setw(8) << "Iters" << std::setw(12) << "Mean ms" << std::setw(12) << "p50 ms"
+        << std::setw(12) << "p90 ms" << std::setw(12) << "p99 ms" << std::setw(16) << "Items/s" << std::endl;
+
+    std::cout << std::fixed << std::setprecision(3);
+    for (const BenchmarkResult& result : _results)
+    {
+        std::cout << std::left << std::setw(44) << result.name << std::right
+            << std::setw(8) << result.milliseconds.size() << std::setw(12) << result.getMean() << std::setw(12) << result.getQuantile(0.5)
+            << std::setw(12) << result.getQuantile(0.9) << std::setw(12) << result.getQuantile(0.99)
+            << std::setw(16) << std::setprecision(0) << result.getThroughput() << std::setprecision(3) << " " << result.unit << std::endl;
+    }
+    std::cout << std::defaultfloat << std::setprecision(6);
+}
+
+bool BenchmarkSuite::writeJson(const std::string& fileName) const
+{
+    std::ofstream file(fileName);
+    if (!file)
+    {
+        std::cout << "Cannot open file for writing benchmark results!" << std::endl;
+        return false;
+    }
+
+    file << "{\n  \"metadata\": {";
+    for (size_t i = 0; i < _metadata.size(); i++)
+        file << (i == 0 ? "\n" : ",\n") << "    " << toJsonString(_metadata[i].first) << ": " << _metadata[i].second;
+    file << "\n  },\n  \"benchmarks\": [";
+
+    for (size_t r = 0; r < _results.size(); r++)
+    {
+        const BenchmarkResult& result = _results[r];
+
+        file << (r == 0 ? "\n" : ",\n") << "    {\n";
+        file << "      \"name\": " << toJsonString(result.name) << ",\n";
+        file << "      \"unit\": " << toJsonString(result.unit) << ",\n";
+        file << "      \"iterations\": " << result.milliseconds.size() << ",\n";
+        file << "      \"items\": " << toJsonNumber(result.numItems) << ",\n";
+        file << "      \"throughput_per_second\": " << toJsonNumber(result.getThroughput()) << ",\n";
+        file << "      \"mean_ms\": " << toJsonNumber(result.getMean()) << ",\n";
+        file << "      \"min_ms\": " << toJsonNumber(result.getQuantile(0)) << ",\n";
+        file << "      \"p50_ms\": " << toJsonNumber(result.getQuantile(0.5)) << ",\n";
+        file << "      \"p90_ms\": " << toJsonNumber(result.getQuantile(0.9)) << ",\n";
+        file << "      \"p99_ms\": " << toJsonNumber(result.getQuantile(0.99)) << ",\n";
+        file << "      \"max_ms\": " << toJsonNumber(result.getQuantile(1)) << "\n";
+        file << "    }";
+    }
+    file << "\n  ]\n}\n";
+
+    if (!file)
+    {
+        std::cout << "Failed writing benchmark results to file!" << std::endl;
+        return false;
+    }
+
+    std::cout << "Benchmark results written to file: " << fileName << std::endl;
+    return true;
+}
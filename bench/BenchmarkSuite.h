@@ -0,0 +1,63 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct BenchmarkResult
+{
+    std::string         name;
+    std::string         unit;               /** What an item is, e.g. "points" or "nodes" */
+    std::vector<double> milliseconds;       /** Latency of every measured iteration */
+    double              numItems = 0;       /** Items processed over all measured iterations */
+
+    double getQuantile(double quantile) const;
+    double getMean() const;
+    double getTotal() const;
+
+    /** Items per second over all measured iterations */
+    double getThroughput() const;
+};
+
+/**
+ * Runs benchmarks and collects per-iteration latencies.
+ *
+ * Results are printed as a table and written as JSON, together with key-value metadata about
+ * the machine and the dataset, so runs can be compared across versions and machines.
+ */
+class BenchmarkSuite
+{
+public:
+    /** Returns the number of items processed by the iteration */
+    using Iteration = std::function<double(int iteration)>;
+
+    /** Prepares the inputs of an iteration, not measured */
+    using Setup = std::function<void(int iteration)>;
+
+    /**
+     * Run warmupIterations unmeasured iterations followed by the measured iterations.
+     * Iteration numbers continue after the warmup, so every call can use different inputs.
+     */
+    const BenchmarkResult& run(const std::string& name, const std::string& unit, int iterations, const Iteration& iteration, int warmupIterations = 0);
+    const BenchmarkResult& run(const std::string& name, const std::string& unit, int iterations, const Setup& setup, const Iteration& iteration, int warmupIterations = 0);
+
+    /** Only run benchmarks whose name contains the filter, empty runs all */
+    void setFilter(const std::string& filter) { _filter = filter; }
+    bool isSelected(const std::string& name) const;
+
+    void addMetadata(const std::string& key, const std::string& value);
+    void addMetadata(const std::string& key, double value);
+
+    const std::vector<BenchmarkResult>& getResults() const { return _results; }
+
+    void printSummary() const;
+
+    /** @return False if the file could not be written */
+    bool writeJson(const std::string& fileName) const;
+
+private:
+    std::string                                         _filter;
+    std::vector<BenchmarkResult>                        _results;
+    std::vector<std::pair<std::string, std::string>>    _metadata;  /** Values are stored as JSON literals */
+};
@@ -0,0 +1,468 @@
+#include "BenchmarkSuite.h"
+#include "SyntheticData.h"
+
+#include "DataMatrix.h"
+#include "Compute/DataTransformations.h"
+#include "Compute/KnnIndex.h"
+#include "Compute/KnnGraph.h"
+#include "Compute/FloodFill.h"
+#include "Compute/FloodWorkingSet.h"
+#include "Compute/Filters.h"
+#include "Compute/HistogramEngine.h"
+#include "Compute/LocalDimensionality.h"
+#include "Compute/TaskScheduler.h"
+#include "IO/KnnGraphIO.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace
+{
+    constexpr int NUM_FLOOD_WAVES = 10;
+    constexpr int NUM_FLOOD_NEIGHBOURS = 10;
+    constexpr int NUM_LARGE_NEIGHBOURS = 30;
+    constexpr int NUM_GRAPH_BINS = 30;
+    constexpr int NUM_RANKED_DIMENSIONS = 2;
+    constexpr float MIN_KNN_RECALL = 0.9f;     /** Approximate kNN builds below this recall aren't timed */
+
+#ifdef SPACEWALKER_NO_FAISS
+    constexpr const char* PRECISE_KNN_BACKEND = "brute force";
+#else
+    constexpr const char* PRECISE_KNN_BACKEND = "faiss";
+#endif
+
+    struct BenchSettings
+    {
+        SyntheticDataSettings   data;
+        SyntheticDataSettings   localDimensionalityData;    /** Smaller dataset, local dimensionality is cubic in the number of dimensions */
+        int                     iterations = 200;           /** Selections per hover stage */
+        int                     knnIterations = 3;
+        int                     threads = 0;                /** Thread budget of the scheduler, 0 keeps the default */
+        std::string             filter;
+        std::string             label;
+        std::string             output = "spacewalker_bench.json";
+    };
+
+    void printUsage()
+    {
+        std::cout << "Usage: SpaceWalkerBench [options]\n"
+            << "  --points N            Number of cells (default 20000)\n"
+            << "  --dims D              Number of genes (default 200)\n"
+            << "  --layout NAME         layered, clustered or uniform (default layered)\n"
+            << "  --regions N           Number of layers or clusters (default 6)\n"
+            << "  --sparsity S          Fraction of zero expression values (default 0.7)\n"
+            << "  --noise S             Expression noise (default 0.25)\n"
+            << "  --seed N              Random seed (default 1)\n"
+            << "  --iterations N        Selections per hover stage (default 200)\n"
+            << "  --knn-iterations N    Builds per kNN benchmark (default 3)\n"
+            << "  --ld-points N         Cells of the local dimensionality dataset (default 2000)\n"
+            << "  --ld-dims D           Genes of the local dimensionality dataset (default 50)\n"
+            << "  --threads N           Threads the compute loops run on (default all)\n"
+            << "  --filter TEXT         Only run benchmarks whose name contains TEXT\n"
+            << "  --label TEXT          Label stored with the results, e.g. a version\n"
+            << "  --output FILE         JSON results file (default spacewalker_bench.json)" << std::endl;
+    }
+
+    bool parseArguments(int argc, char* argv[], BenchSettings& settings)
+    {
+        settings.localDimensionalityData.numPoints = 2000;
+        settings.localDimensionalityData.numDimensions = 50;
+
+        for (int i = 1; i < argc; i++)
+        {
+            std::string argument = argv[i];
+            if (argument == "--help" || argument == "-h" || i + 1 >= argc)
+                return false;
+
+            std::string value = argv[++i];
+            if (argument == "--points")                 settings.data.numPoints = std::stoi(value);
+            else if (argument == "--dims")              settings.data.numDimensions = std::stoi(value);
+            else if (argument == "--regions")           settings.data.numRegions = std::stoi(value);
+            else if (argument == "--sparsity")          settings.data.sparsity = std::stof(value);
+            else if (argument == "--noise")             settings.data.noise = std::stof(value);
+            else if (argument == "--seed")              settings.data.seed = (std::uint32_t) std::stoul(value);
+            else if (argument == "--iterations")        settings.iterations = std::max(std::stoi(value), 1);
+            else if (argument == "--knn-iterations")    settings.knnIterations = std::max(std::stoi(value), 1);
+            else if (argument == "--ld-points")         settings.localDimensionalityData.numPoints = std::stoi(value);
+            else if (argument == "--ld-dims")           settings.localDimensionalityData.numDimensions = std::stoi(value);
+            else if (argument == "--threads")           settings.threads = std::stoi(value);
+            else if (argument == "--filter")            settings.filter = value;
+            else if (argument == "--label")             settings.label = value;
+            else if (argument == "--output")            settings.output = value;
+            else if (argument == "--layout")
+            {
+                if (!parseTissueLayout(value, settings.data.layout))
+                    return false;
+            }
+            else
+                return false;
+        }
+
+        // The local dimensionality dataset follows the same tissue, only smaller
+        SyntheticDataSettings& ldData = settings.localDimensionalityData;
+        ldData.layout = settings.data.layout;
+        ldData.numRegions = settings.data.numRegions;
+        ldData.sparsity = settings.data.sparsity;
+        ldData.noise = settings.data.noise;
+        ldData.seed = settings.data.seed;
+
+        return settings.data.numPoints > NUM_LARGE_NEIGHBOURS && settings.data.numDimensions > NUM_RANKED_DIMENSIONS;
+    }
+
+    /**
+     * Seeds of a cursor dragged over the tissue: mostly steps to a kNN neighbour of the previous
+     * seed, with the occasional jump, like the hover pipeline sees them.
+     */
+    std::vector<int> createHoverPath(const KnnGraph& knnGraph, int numPoints, int length, std::uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> unit(0, 1);
+
+        std::vector<int> path(length);
+        int current = (int) (rng() % numPoints);
+        for (int i = 0; i < length; i++)
+        {
+            path[i] = current;
+
+            const std::vector<nint>& neighbours = knnGraph.getNeighbours()[current];
+            if (unit(rng) < 0.05f || neighbours.empty())
+                current = (int) (rng() % numPoints);
+            else
+                current = neighbours[rng() % neighbours.size()];
+        }
+        return path;
+    }
+
+    float computeProjectionSize(const DataMatrix& projection)
+    {
+        float rangeX = projection.col(0).maxCoeff() - projection.col(0).minCoeff();
+        float rangeY = projection.col(1).maxCoeff() - projection.col(1).minCoeff();
+        return std::max(rangeX, rangeY);
+    }
+
+    const char* toString(knn::Metric metric)
+    {
+        switch (metric)
+        {
+        case knn::Metric::EUCLIDEAN: return "euclidean";
+        case knn::Metric::MANHATTAN: return "manhattan";
+        case knn::Metric::COSINE: return "cosine";
+        case knn::Metric::ANGULAR: return "angular";
+        }
+        return "";
+    }
+
+    void buildKnnGraph(const DataMatrix& data, bool precise, knn::Metric metric, KnnGraph& graph)
+    {
+        knn::Index index;
+        index.setPreciseKnn(precise);
+        index.create((int) data.cols(), metric);
+        index.addData(data);
+
+        graph.build(data, index, NUM_LARGE_NEIGHBOURS);
+    }
+
+    /** Fraction of the neighbours in the exact graph that the graph also found */
+    float computeRecall(const KnnGraph& graph, const KnnGraph& exactGraph)
+    {
+        size_t numFound = 0;
+        size_t numExact = 0;
+        for (size_t i = 0; i < exactGraph.getNeighbours().size(); i++)
+        {
+            const std::vector<nint>& neighbours = graph.getNeighbours()[i];
+            for (nint neighbour : exactGraph.getNeighbours()[i])
+            {
+                if (std::find(neighbours.begin(), neighbours.end(), neighbour) != neighbours.end())
+                    numFound++;
+            }
+            numExact += exactGraph.getNeighbours()[i].size();
+        }
+        return numExact > 0 ? (float) numFound / numExact : 1;
+    }
+
+    void addMetadata(BenchmarkSuite& suite, const BenchSettings& settings)
+    {
+        char timestamp[32];
+        std::time_t now = std::time(nullptr);
+        std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+        suite.addMetadata("label", settings.label);
+        suite.addMetadata("timestamp", timestamp);
+        suite.addMetadata("hardware_threads", (double) std::thread::hardware_concurrency());
+        suite.addMetadata("scheduler_threads", (double) tasks::getNumSlots());
+#ifdef _OPENMP
+        suite.addMetadata("openmp_threads", (double) omp_get_max_threads());
+#else
+        suite.addMetadata("openmp_threads", 1);
+#endif
+#if defined(_MSC_VER)
+        suite.addMetadata("compiler", "MSVC " + std::to_string(_MSC_VER));
+#elif defined(__VERSION__)
+        suite.addMetadata("compiler", __VERSION__);
+#endif
+#ifdef NDEBUG
+        suite.addMetadata("build", "release");
+#else
+        suite.addMetadata("build", "debug");
+#endif
+        suite.addMetadata("points", settings.data.numPoints);
+        suite.addMetadata("dimensions", settings.data.numDimensions);
+        suite.addMetadata("layout", toString(settings.data.layout));
+        suite.addMetadata("regions", settings.data.numRegions);
+        suite.addMetadata("sparsity", settings.data.sparsity);
+        suite.addMetadata("noise", settings.data.noise);
+        suite.addMetadata("seed", settings.data.seed);
+        suite.addMetadata("local_dimensionality_points", settings.localDimensionalityData.numPoints);
+        suite.addMetadata("local_dimensionality_dimensions", settings.localDimensionalityData.numDimensions);
+        suite.addMetadata("flood_waves", NUM_FLOOD_WAVES);
+        suite.addMetadata("flood_neighbours", NUM_FLOOD_NEIGHBOURS);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    BenchSettings settings;
+    if (!parseArguments(argc, argv, settings))
+    {
+        printUsage();
+        return 1;
+    }
+
+    // The benchmarks run on the main thread, with background priority
+    if (settings.threads > 0)
+        tasks::Scheduler::global().setThreadBudget(tasks::Priority::BACKGROUND, settings.threads);
+    tasks::limitOpenMPThreads();
+
+    BenchmarkSuite suite;
+    suite.setFilter(settings.filter);
+    addMetadata(suite, settings);
+
+    std::cout << "Generating " << settings.data.numPoints << " cells with " << settings.data.numDimensions << " genes..." << std::endl;
+    SyntheticData synthetic;
+    generateSyntheticData(settings.data, synthetic);
+
+    int numPoints = settings.data.numPoints;
+    int iterations = settings.iterations;
+    int warmup = std::min(10, iterations);
+
+    /////////////////////
+    // Transformations //
+    /////////////////////
+    DataMatrix data = synthetic.data;
+    std::vector<float> variances;
+    std::vector<std::vector<float>> normalizedData;
+
+    // Always run, every later stage works on the transformed data
+    suite.run("Standardize data", "points", 1, [&](int)
+    {
+        standardizeData(data, variances);
+        return (double) numPoints;
+    });
+    suite.run("Normalize data", "points", 5, [&](int)
+    {
+        normalizeData(data, normalizedData);
+        return (double) numPoints;
+    });
+
+    /////////////////////
+    // kNN             //
+    /////////////////////
+    struct KnnBackend
+    {
+        bool        precise;
+        knn::Metric metric;
+    };
+    const KnnBackend knnBackends[] = {
+        { true, knn::Metric::EUCLIDEAN },
+        { true, knn::Metric::MANHATTAN },
+        { true, knn::Metric::COSINE },
+        { false, knn::Metric::ANGULAR }
+    };
+
+    for (const KnnBackend& backend : knnBackends)
+    {
+        std::string backendName = backend.precise ? PRECISE_KNN_BACKEND : "annoy";
+        std::string name = "kNN build " + backendName + " " + toString(backend.metric);
+        if (!suite.isSelected(name))
+            continue;
+
+        // An approximate graph that misses its neighbours would time a search that does no useful work,
+        // so it is checked against the exact graph first. Angular distances order neighbours like cosine.
+        if (!backend.precise)
+        {
+            KnnGraph graph;
+            KnnGraph exactGraph;
+            buildKnnGraph(data, false, backend.metric, graph);
+            buildKnnGraph(data, true, backend.metric == knn::Metric::ANGULAR ? knn::Metric::COSINE : backend.metric, exactGraph);
+
+            float recall = computeRecall(graph, exactGraph);
+            suite.addMetadata("knn_recall_annoy_" + std::string(toString(backend.metric)), recall);
+            if (recall < MIN_KNN_RECALL)
+            {
+                std::cout << "Skipping " << name << ", its recall of " << recall << " is below " << MIN_KNN_RECALL << std::endl;
+                continue;
+            }
+        }
+
+        suite.run(name, "points", settings.knnIterations, [&](int)
+        {
+            KnnGraph graph;
+            buildKnnGraph(data, backend.precise, backend.metric, graph);
+            return (double) numPoints;
+        });
+    }
+
+    // The graphs the plugin builds, always needed by the flood stages
+    KnnGraphBuild knnBuild;
+    suite.run("kNN graphs (plugin build)", "points", 1, [&](int)
+    {
+        buildKnnGraphs(data, false, knnBuild);
+        return (double) numPoints;
+    });
+    const KnnGraph& knnGraph = knnBuild.graph;
+
+    std::vector<int> hoverPath = createHoverPath(knnGraph, numPoints, warmup + iterations, settings.data.seed);
+
+    /////////////////////
+    // Hover stages    //
+    /////////////////////
+    FloodFill floodFill(NUM_FLOOD_WAVES);
+    FloodWorkingSet workingSet;
+    std::vector<int> dimRanking;
+
+    const auto computeFlood = [&](int i) { floodFill.compute(knnGraph, hoverPath[i]); };
+    const auto computeFloodAndGather = [&](int i)
+    {
+        floodFill.compute(knnGraph, hoverPath[i]);
+        workingSet.gather(floodFill, data, normalizedData);
+    };
+
+    if (suite.isSelected("Flood fill"))
+    {
+        suite.run("Flood fill", "nodes", iterations, [&](int i)
+        {
+            floodFill.compute(knnGraph, hoverPath[i]);
+            return (double) floodFill.getTotalNumNodes();
+        }, warmup);
+    }
+
+    if (suite.isSelected("Working set gather"))
+    {
+        suite.run("Working set gather", "nodes", iterations, computeFlood, [&](int)
+        {
+            workingSet.gather(floodFill, data, normalizedData);
+            return (double) workingSet.getNumNodes();
+        }, warmup);
+    }
+
+    if (suite.isSelected("Spatial peak filter"))
+    {
+        filters::SpatialPeakFilter spatialFilter;
+        spatialFilter.setTopK(NUM_RANKED_DIMENSIONS);
+        float projectionSize = computeProjectionSize(synthetic.projection);
+
+        suite.run("Spatial peak filter", "selections", iterations, [&](int i)
+        {
+            spatialFilter.computeDimensionRanking(hoverPath[i], data, variances, synthetic.projection, projectionSize, dimRanking);
+            return 1.0;
+        }, warmup);
+    }
+
+    if (suite.isSelected("HD flood peak filter"))
+    {
+        filters::HDFloodPeakFilter hdFilter;
+        hdFilter.setTopK(NUM_RANKED_DIMENSIONS);
+
+        suite.run("HD flood peak filter", "selections", iterations, computeFloodAndGather, [&](int)
+        {
+            hdFilter.computeDimensionRanking(workingSet, variances, dimRanking);
+            return 1.0;
+        }, warmup);
+    }
+
+    if (suite.isSelected("Graph histograms"))
+    {
+        HistogramEngine histograms;
+        histograms.setNumBins(NUM_GRAPH_BINS);
+
+        suite.run("Graph histograms", "nodes", iterations, computeFloodAndGather, [&](int)
+        {
+            histograms.compute(workingSet, normalizedData);
+            return (double) workingSet.getNumNodes();
+        }, warmup);
+    }
+
+    /////////////////////
+    // Local dimension //
+    /////////////////////
+    if (suite.isSelected("Local dimensionality"))
+    {
+        SyntheticData ldSynthetic;
+        generateSyntheticData(settings.localDimensionalityData, ldSynthetic);
+
+        std::vector<float> ldVariances;
+        standardizeData(ldSynthetic.data, ldVariances);
+
+        knn::Index ldIndex;
+        ldIndex.create((int) ldSynthetic.data.cols(), knn::Metric::EUCLIDEAN);
+        ldIndex.addData(ldSynthetic.data);
+        KnnGraph ldGraph;
+        ldGraph.build(ldSynthetic.data, ldIndex, NUM_LARGE_NEIGHBOURS);
+
+        std::vector<float> localDimensionality;
+        int ldPoints = settings.localDimensionalityData.numPoints;
+
+        suite.run("Local dimensionality HD", "points", 3, [&](int)
+        {
+            hdps::compute::computeHDLocalDimensionality(ldSynthetic.data, ldGraph, localDimensionality);
+            return (double) ldPoints;
+        });
+        suite.run("Local dimensionality spatial", "points", 3, [&](int)
+        {
+            hdps::compute::computeSpatialLocalDimensionality(ldSynthetic.data, ldSynthetic.projection, localDimensionality);
+            return (double) ldPoints;
+        });
+    }
+
+    /////////////////////
+    // I/O             //
+    /////////////////////
+    if (suite.isSelected("kNN graph"))
+    {
+        const std::string fileName = "spacewalker_bench.knn";
+        const KnnGraph& largeGraph = knnBuild.largeGraph;
+        double numEdges = (double) numPoints * largeGraph.getNumNeighbours();
+
+        suite.run("kNN graph write", "edges", 3, [&](int)
+        {
+            KnnGraphExporter::write(largeGraph, fileName);
+            return numEdges;
+        });
+
+        KnnGraph readGraph;
+        suite.run("kNN graph read", "edges", 3, [&](int)
+        {
+            readGraph.readFromFile(fileName);
+            return numEdges;
+        });
+
+        if (readGraph.getNeighbours() != largeGraph.getNeighbours())
+            std::cout << "!!! kNN graph read back from file differs from the written graph" << std::endl;
+
+        std::remove(fileName.c_str());
+    }
+
+    suite.printSummary();
+    return suite.writeJson(settings.output) ? 0 : 1;
+}
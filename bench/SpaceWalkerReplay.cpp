@@ -0,0 +1,127 @@
+#include "AllocationHooks.h"
+
+#include "Tracing.h"
+#include "Compute/HoverReplay.h"
+#include "Compute/TaskScheduler.h"
+#include "IO/HoverRecordingIO.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct ReplaySettings
+    {
+        std::string recording;
+        std::string events;                 /** Optional text file of selections or cursor positions */
+        std::string csv;
+        std::string trace;
+        int         repetitions = 1;
+        int         threads = 0;            /** Thread budget of interactive loops, 0 keeps the default */
+        bool        useCache = false;
+        bool        useRankingAtlas = false;
+    };
+
+    void printUsage()
+    {
+        std::cout << "Usage: SpaceWalkerReplay <recording.swhr> [options]\n"
+            << "  --events FILE         Replay the selections or cursor path in FILE instead of the recorded events\n"
+            << "  --repeat N            Replay the events N times (default 1)\n"
+            << "  --threads N           Threads the hover loops run on (default all)\n"
+            << "  --cache               Look stages up in a selection cache like the plugin does\n"
+            << "  --atlas               Look rankings up in a ranking atlas, built before the events it serves\n"
+            << "  --csv FILE            Write the latency and allocations of every event\n"
+            << "  --trace FILE          Record the stages and write them as Chrome trace JSON" << std::endl;
+    }
+
+    bool parseArguments(int argc, char* argv[], ReplaySettings& settings)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string argument = argv[i];
+            if (argument == "--help" || argument == "-h")
+                return false;
+            else if (argument == "--cache")
+                settings.useCache = true;
+            else if (argument == "--atlas")
+                settings.useRankingAtlas = true;
+            else if (argument.rfind("--", 0) != 0)
+                settings.recording = argument;
+            else if (i + 1 >= argc)
+                return false;
+            else if (argument == "--events")
+                settings.events = argv[++i];
+            else if (argument == "--repeat")
+                settings.repetitions = std::max(std::stoi(argv[++i]), 1);
+            else if (argument == "--threads")
+                settings.threads = std::stoi(argv[++i]);
+            else if (argument == "--csv")
+                settings.csv = argv[++i];
+            else if (argument == "--trace")
+                settings.trace = argv[++i];
+            else
+                return false;
+        }
+        return !settings.recording.empty();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    ReplaySettings settings;
+    if (!parseArguments(argc, argv, settings))
+    {
+        printUsage();
+        return 1;
+    }
+
+    HoverRecording recording;
+    if (!HoverRecordingImporter::read(settings.recording, recording))
+        return 1;
+
+    if (!settings.events.empty())
+    {
+        // Replayed with the settings the session started with
+        HoverEvent prototype = recording.events.empty() ? HoverEvent() : recording.events.front();
+        if (!HoverRecordingImporter::readEvents(settings.events, prototype, recording.events))
+            return 1;
+    }
+
+    if (recording.events.empty())
+    {
+        std::cout << "No hover events to replay" << std::endl;
+        return 1;
+    }
+
+    tracing::setEnabled(!settings.trace.empty());
+
+    if (settings.threads > 0)
+        tasks::Scheduler::global().setThreadBudget(tasks::Priority::INTERACTIVE, settings.threads);
+
+    HoverReplay replay(recording);
+    replay.setUseCache(settings.useCache);
+    replay.setUseRankingAtlas(settings.useRankingAtlas);
+
+    std::vector<HoverEventStats> stats;
+    for (int r = 0; r < settings.repetitions; r++)
+    {
+        std::vector<HoverEventStats> repetitionStats;
+        replay.run(repetitionStats);
+        stats.insert(stats.end(), repetitionStats.begin(), repetitionStats.end());
+    }
+
+    HoverReplay::printSummary(stats);
+
+    if (!settings.trace.empty())
+    {
+        tracing::printStageStatistics();
+        tracing::exportChromeTrace(settings.trace);
+    }
+
+    if (!settings.csv.empty() && !HoverReplay::writeCsv(stats, settings.csv))
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include "SyntheticData.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace
+{
+    constexpr float TISSUE_SIZE = 1000;
+    constexpr float PI = 3.14159265f;
+
+    enum class GenePattern
+    {
+        LINEAR_GRADIENT,
+        RADIAL_GRADIENT,
+        REGION,
+        UNSTRUCTURED
+    };
+
+    void generatePositions(const SyntheticDataSettings& settings, std::mt19937& rng, SyntheticData& synthetic)
+    {
+        std::uniform_real_distribution<float> uniform(0, TISSUE_SIZE);
+        std::uniform_real_distribution<float> unit(0, 1);
+        std::normal_distribution<float> normal(0, 1);
+
+        int numRegions = std::max(settings.numRegions, 1);
+
+        synthetic.projection.resize(settings.numPoints, 2);
+        synthetic.regions.resize(settings.numPoints);
+
+        // Cluster centers and spreads, only used by the clustered layout
+        std::vector<float> centerX(numRegions), centerY(numRegions), spread(numRegions);
+        for (int r = 0; r < numRegions; r++)
+        {
+            centerX[r] = uniform(rng);
+            centerY[r] = uniform(rng);
+            spread[r] = TISSUE_SIZE * (0.03f + 0.07f * unit(rng));
+        }
+
+        float bandHeight = TISSUE_SIZE / numRegions;
+        float waveAmplitude = bandHeight * 0.3f;
+
+        for (int i = 0; i < settings.numPoints; i++)
+        {
+            float x = 0, y = 0;
+            int region = 0;
+
+            switch (settings.layout)
+            {
+            case TissueLayout::LAYERED:
+            {
+                x = uniform(rng);
+                y = uniform(rng);
+                float warpedY = y + waveAmplitude * std::sin(2 * PI * x / TISSUE_SIZE * 2);
+                region = std::clamp((int) (warpedY / bandHeight), 0, numRegions - 1);
+                break;
+            }
+            case TissueLayout::CLUSTERED:
+            {
+                region = (int) (rng() % numRegions);
+                x = std::clamp(centerX[region] + normal(rng) * spread[region], 0.0f, TISSUE_SIZE);
+                y = std::clamp(centerY[region] + normal(rng) * spread[region], 0.0f, TISSUE_SIZE);
+                break;
+            }
+            case TissueLayout::UNIFORM:
+            {
+                x = uniform(rng);
+                y = uniform(rng);
+                region = std::clamp((int) (y / bandHeight), 0, numRegions - 1);
+                break;
+            }
+            }
+
+            synthetic.projection(i, 0) = x;
+            synthetic.projection(i, 1) = y;
+            synthetic.regions[i] = region;
+        }
+    }
+}
+
+void generateSyntheticData(const SyntheticDataSettings& settings, SyntheticData& synthetic)
+{
+    std::mt19937 rng(settings.seed);
+    generatePositions(settings, rng, synthetic);
+
+    int numPoints = settings.numPoints;
+    int numRegions = std::max(settings.numRegions, 1);
+
+    synthetic.data.resize(numPoints, settings.numDimensions);
+
+    // Every gene draws from its own generator, so the result doesn't depend on the number of threads
+#pragma omp parallel for schedule(dynamic, 4)
+    for (int d = 0; d < settings.numDimensions; d++)
+    {
+        std::mt19937 geneRng(settings.seed * 7919u + (std::uint32_t) d + 1);
+        std::uniform_real_distribution<float> unit(0, 1);
+        std::normal_distribution<float> normal(0, 1);
+
+        // Roughly 40% linear gradients, 20% radial gradients, 30% regional and 10% unstructured genes
+        float patternDraw = unit(geneRng);
+        GenePattern pattern = patternDraw < 0.4f ? GenePattern::LINEAR_GRADIENT :
+                              patternDraw < 0.6f ? GenePattern::RADIAL_GRADIENT :
+                              patternDraw < 0.9f ? GenePattern::REGION : GenePattern::UNSTRUCTURED;
+
+        float angle = unit(geneRng) * 2 * PI;
+        float directionX = std::cos(angle), directionY = std::sin(angle);
+        float centerX = unit(geneRng) * TISSUE_SIZE, centerY = unit(geneRng) * TISSUE_SIZE;
+        float radius = TISSUE_SIZE * (0.1f + 0.3f * unit(geneRng));
+        int enrichedRegion = (int) (geneRng() % numRegions);
+
+        // Mean expression of highly and lowly expressed genes spans a few orders of magnitude
+        float baseExpression = std::exp(unit(geneRng) * 5);
+
+        for (int i = 0; i < numPoints; i++)
+        {
+            float x = synthetic.projection(i, 0);
+            float y = synthetic.projection(i, 1);
+
+            float signal = 0;
+            switch (pattern)
+            {
+            case GenePattern::LINEAR_GRADIENT:
+                signal = 0.5f + ((x - TISSUE_SIZE / 2) * directionX + (y - TISSUE_SIZE / 2) * directionY) / TISSUE_SIZE;
+                break;
+            case GenePattern::RADIAL_GRADIENT:
+            {
+                float dx = x - centerX, dy = y - centerY;
+                signal = std::exp(-(dx * dx + dy * dy) / (2 * radius * radius));
+                break;
+            }
+            case GenePattern::REGION:
+                signal = synthetic.regions[i] == enrichedRegion ? 1.0f : 0.1f;
+                break;
+            case GenePattern::UNSTRUCTURED:
+                signal = 0.5f;
+                break;
+            }
+
+            float value = 0;
+            if (unit(geneRng) >= settings.sparsity)
+                value = std::max(0.0f, baseExpression * std::clamp(signal, 0.0f, 1.0f) * (1 + settings.noise * normal(geneRng)));
+
+            synthetic.data(i, d) = value;
+        }
+    }
+}
+
+const char* toString(TissueLayout layout)
+{
+    switch (layout)
+    {
+    case TissueLayout::LAYERED: return "layered";
+    case TissueLayout::CLUSTERED: return "clustered";
+    case TissueLayout::UNIFORM: return "uniform";
+    }
+    return "";
+}
+
+bool parseTissueLayout(const std::string& name, TissueLayout& layout)
+{
+    for (TissueLayout candidate : { TissueLayout::LAYERED, TissueLayout::CLUSTERED, TissueLayout::UNIFORM })
+    {
+        if (name == toString(candidate))
+        {
+            layout = candidate;
+            return true;
+        }
+    }
+    return false;
+}
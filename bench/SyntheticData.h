@@ -0,0 +1,48 @@
+#pragma once
+
+#include "DataMatrix.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class TissueLayout
+{
+    LAYERED,    /** Horizontal bands with wavy boundaries, like cortical layers */
+    CLUSTERED,  /** Gaussian blobs of cells, like tumour nests or follicles */
+    UNIFORM     /** Cells spread uniformly without structure */
+};
+
+struct SyntheticDataSettings
+{
+    int             numPoints       = 20000;
+    int             numDimensions   = 200;
+    TissueLayout    layout          = TissueLayout::LAYERED;
+    int             numRegions      = 6;        /** Number of layers or clusters */
+    float           sparsity        = 0.7f;     /** Fraction of expression values dropped to zero */
+    float           noise           = 0.25f;    /** Standard deviation of the multiplicative expression noise */
+    std::uint32_t   seed            = 1;
+};
+
+/**
+ * Synthetic spatial transcriptomics dataset: cell positions on a 2D tissue-like layout and
+ * gene expression values that vary along spatial gradients.
+ *
+ * Every gene follows one of four patterns: a linear gradient in a random direction, a radial
+ * gradient around a random center, enrichment in one region, or no spatial structure. Values
+ * are non-negative, and a fraction of them is dropped to zero to mimic the sparsity of
+ * sequencing data. Generation is deterministic for a given seed on a given platform.
+ */
+struct SyntheticData
+{
+    DataMatrix          data;           /** numPoints x numDimensions expression values */
+    DataMatrix          projection;     /** numPoints x 2 cell positions in [0, 1000] */
+    std::vector<int>    regions;        /** Layer or cluster of every cell */
+};
+
+void generateSyntheticData(const SyntheticDataSettings& settings, SyntheticData& synthetic);
+
+const char* toString(TissueLayout layout);
+
+/** @return False if the name doesn't match a layout */
+bool parseTissueLayout(const std::string& name, TissueLayout& layout);
@@ -2,6 +2,7 @@
 
 #include "SpaceWalkerPlugin.h"
 #include "ScatterplotWidget.h"
+#include "Tracing.h"
 
 #include <QMenu>
 #include <QGroupBox>
@@ -12,7 +13,13 @@ ExportAction::ExportAction(QObject* parent, const QString& title) :
     WidgetAction(parent, "Export Settings"),
     _exportRankingsAction(this, "Export rankings"),
     _exportFloodnodesAction(this, "Export floodnodes"),
-    _importKnnGraphAction(this, "Import KNN Graph")
+    _importKnnGraphAction(this, "Import KNN Graph"),
+    _exportAsCsvAction(this, "Export as CSV", false),
+    _exportTopKAction(this, "Exported dimensions (0 = all)", 0, 1000, 0),
+    _deltaCompressAction(this, "Delta compress flood nodes", true),
+    _tracingAction(this, "Record traces", false),
+    _exportTraceAction(this, "Export trace"),
+    _recordHoverAction(this, "Record hover session", false)
 {
     setIcon(hdps::Application::getIconFont("FontAwesome").getIcon("file-export"));
 
@@ -30,6 +37,18 @@ void ExportAction::initialize(SpaceWalkerPlugin* spaceWalkerPlugin)
     connect(&_importKnnGraphAction, &TriggerAction::triggered, this, [spaceWalkerPlugin]() {
         spaceWalkerPlugin->importKnnGraph();
     });
+    connect(&_tracingAction, &ToggleAction::toggled, this, [](bool toggled) {
+        tracing::setEnabled(toggled);
+    });
+    connect(&_exportTraceAction, &TriggerAction::triggered, this, [spaceWalkerPlugin]() {
+        spaceWalkerPlugin->exportTrace();
+    });
+    connect(&_recordHoverAction, &ToggleAction::toggled, this, [spaceWalkerPlugin](bool toggled) {
+        if (toggled)
+            spaceWalkerPlugin->startHoverRecording();
+        else
+            spaceWalkerPlugin->stopHoverRecording();
+    });
 }
 
 QMenu* ExportAction::getContextMenu()
@@ -47,6 +66,12 @@ QMenu* ExportAction::getContextMenu()
     addActionToMenu(&_exportRankingsAction);
     addActionToMenu(&_exportFloodnodesAction);
     addActionToMenu(&_importKnnGraphAction);
+    addActionToMenu(&_exportAsCsvAction);
+    addActionToMenu(&_exportTopKAction);
+    addActionToMenu(&_deltaCompressAction);
+    addActionToMenu(&_tracingAction);
+    addActionToMenu(&_exportTraceAction);
+    addActionToMenu(&_recordHoverAction);
 
     return menu;
 }
@@ -67,6 +92,18 @@ ExportAction::Widget::Widget(QWidget* parent, ExportAction* exportAction, const
     layout->addWidget(exportAction->getExportFloodnodesAction().createWidget(this), 1, 1);
     layout->addWidget(exportAction->getImportKnnGraphAction().createLabelWidget(this), 2, 0);
     layout->addWidget(exportAction->getImportKnnGraphAction().createWidget(this), 2, 1);
+    layout->addWidget(exportAction->getExportAsCsvAction().createLabelWidget(this), 3, 0);
+    layout->addWidget(exportAction->getExportAsCsvAction().createWidget(this), 3, 1);
+    layout->addWidget(exportAction->getExportTopKAction().createLabelWidget(this), 4, 0);
+    layout->addWidget(exportAction->getExportTopKAction().createWidget(this), 4, 1);
+    layout->addWidget(exportAction->getDeltaCompressAction().createLabelWidget(this), 5, 0);
+    layout->addWidget(exportAction->getDeltaCompressAction().createWidget(this), 5, 1);
+    layout->addWidget(exportAction->getTracingAction().createLabelWidget(this), 6, 0);
+    layout->addWidget(exportAction->getTracingAction().createWidget(this), 6, 1);
+    layout->addWidget(exportAction->getExportTraceAction().createLabelWidget(this), 7, 0);
+    layout->addWidget(exportAction->getExportTraceAction().createWidget(this), 7, 1);
+    layout->addWidget(exportAction->getRecordHoverAction().createLabelWidget(this), 8, 0);
+    layout->addWidget(exportAction->getRecordHoverAction().createWidget(this), 8, 1);
 
     setLayout(layout);
 }
@@ -3,6 +3,8 @@
 #include <actions/WidgetAction.h>
 
 #include <actions/TriggerAction.h>
+#include <actions/ToggleAction.h>
+#include <actions/IntegralAction.h>
 
 using namespace hdps::gui;
 
@@ -39,11 +41,23 @@ public: // Action getters
     TriggerAction& getExportRankingsAction() { return _exportRankingsAction; }
     TriggerAction& getExportFloodnodesAction() { return _exportFloodnodesAction; }
     TriggerAction& getImportKnnGraphAction() { return _importKnnGraphAction; }
+    ToggleAction& getExportAsCsvAction() { return _exportAsCsvAction; }
+    IntegralAction& getExportTopKAction() { return _exportTopKAction; }
+    ToggleAction& getDeltaCompressAction() { return _deltaCompressAction; }
+    ToggleAction& getTracingAction() { return _tracingAction; }
+    TriggerAction& getExportTraceAction() { return _exportTraceAction; }
+    ToggleAction& getRecordHoverAction() { return _recordHoverAction; }
 
 protected:
     TriggerAction       _exportRankingsAction;
     TriggerAction       _exportFloodnodesAction;
     TriggerAction       _importKnnGraphAction;
+    ToggleAction        _exportAsCsvAction;         /** Write exports as CSV instead of the compact binary format */
+    IntegralAction      _exportTopKAction;          /** Number of ranked dimensions exported per point, 0 exports all */
+    ToggleAction        _deltaCompressAction;       /** Delta compress the nodes of binary flood node exports */
+    ToggleAction        _tracingAction;             /** Record the timings of the compute and render stages */
+    TriggerAction       _exportTraceAction;         /** Write the recorded stages as Chrome trace JSON */
+    ToggleAction        _recordHoverAction;         /** Record hover selections to replay them headless */
 };
 
 Q_DECLARE_METATYPE(ExportAction)
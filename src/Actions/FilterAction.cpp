@@ -14,8 +14,9 @@ FilterAction::FilterAction(QObject* parent, const QString& title) :
     _restrictToFloodAction(this, "Restrict to flood nodes", true),
     _innerFilterSizeAction(this, "Inner Filter Radius", 1, 10, 2.5f, 2),
     _outerFilterSizeAction(this, "Outer Filter Radius", 2, 20, 5, 2),
-    _hdInnerFilterSizeAction(this, "HD Inner Filter Size", 1, 10, 5)
+    _hdInnerFilterSizeAction(this, "HD Inner Filter Size", 1, 10, 5),
     //_hdOuterFilterSizeAction(this, "HD Outer Filter Size", 2, 10, 10)
+    _precomputeRankingsAction(this, "Precompute rankings", false)
 {
     setIcon(hdps::Application::getIconFont("FontAwesome").getIcon("bullseye"));
 
@@ -58,8 +59,16 @@ void FilterAction::initialize(SpaceWalkerPlugin* spaceWalkerPlugin)
         spaceWalkerPlugin->onPointSelection();
         });
 
-    connect(&_hdInnerFilterSizeAction, &IntegralAction::valueChanged, [&hdPeakFilter](int value) { hdPeakFilter.setInnerFilterSize(value); });
+    // The HD filter keeps per-wave sums of the current flood, so changing the split doesn't rescan the flood nodes
+    connect(&_hdInnerFilterSizeAction, &IntegralAction::valueChanged, [spaceWalkerPlugin, &hdPeakFilter](int value) {
+        hdPeakFilter.setInnerFilterSize(value);
+        spaceWalkerPlugin->onPointSelection();
+        });
     //connect(&_hdOuterFilterSizeAction, &IntegralAction::valueChanged, [&hdPeakFilter](int value) { hdPeakFilter.setOuterFilterSize(value); });
+
+    connect(&_precomputeRankingsAction, &ToggleAction::toggled, this, [spaceWalkerPlugin](bool toggled) {
+        spaceWalkerPlugin->setRankingAtlasEnabled(toggled);
+        });
 }
 
 QMenu* FilterAction::getContextMenu()
@@ -96,6 +105,8 @@ void FilterAction::fromVariantMap(const QVariantMap& variantMap)
     _outerFilterSizeAction.fromParentVariantMap(variantMap);
 
     _hdInnerFilterSizeAction.fromParentVariantMap(variantMap);
+
+    _precomputeRankingsAction.fromParentVariantMap(variantMap);
 }
 
 QVariantMap FilterAction::toVariantMap() const
@@ -107,6 +118,8 @@ QVariantMap FilterAction::toVariantMap() const
 
     _hdInnerFilterSizeAction.insertIntoVariantMap(variantMap);
 
+    _precomputeRankingsAction.insertIntoVariantMap(variantMap);
+
     return variantMap;
 }
 
@@ -140,5 +153,7 @@ FilterAction::Widget::Widget(QWidget* parent, FilterAction* filterAction, const
     //layout->addWidget(filterAction->getHDOuterFilterSizeAction().createLabelWidget(this), 5, 0);
     //layout->addWidget(filterAction->getHDOuterFilterSizeAction().createWidget(this), 5, 1);
 
+    layout->addWidget(filterAction->getPrecomputeRankingsAction().createWidget(this), 6, 0);
+
     setLayout(layout);
 }
@@ -65,6 +65,8 @@ public: // Action getters
     IntegralAction& getHDInnerFilterSizeAction() { return _hdInnerFilterSizeAction; }
     //IntegralAction& getHDOuterFilterSizeAction() { return _hdOuterFilterSizeAction; }
 
+    ToggleAction& getPrecomputeRankingsAction() { return _precomputeRankingsAction; }
+
 protected:
     SpaceWalkerPlugin*  _spaceWalkerPlugin;             /** Pointer to scatterplot plugin */
     TriggerAction       _spatialPeakFilterAction;
@@ -77,6 +79,8 @@ protected:
 
     IntegralAction      _hdInnerFilterSizeAction;
     //IntegralAction      _hdOuterFilterSizeAction;
+
+    ToggleAction        _precomputeRankingsAction;      /** Rank all points in the background, so hovering looks the rankings up */
 };
 
 Q_DECLARE_METATYPE(FilterAction)
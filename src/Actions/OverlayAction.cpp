@@ -10,9 +10,11 @@ OverlayAction::OverlayAction(QObject* parent, const QString& title) :
     WidgetAction(parent, "Overlay Settings"),
     _spaceWalkerPlugin(nullptr),
     _computeKnnGraphAction(this, "Compute Floods"),
+    _cancelKnnGraphAction(this, "Cancel"),
     _floodDecimal(this, "Flood nodes", 10, 500, 10),
     _floodStepsAction(this, "Flood steps", 2, 50, 10),
     _sharedDistAction(this, "Shared distances", false),
+    _graphBinsAction(this, "Graph bins", 5, 100, 30),
     _floodOverlayAction(this, "Flood Steps"),
     _dimensionOverlayAction(this, "Top Dimension Values"),
     _dimensionalityOverlayAction(this, "Local Dimensionality")
@@ -22,6 +24,9 @@ OverlayAction::OverlayAction(QObject* parent, const QString& title) :
 
     setConfigurationFlag(WidgetAction::ConfigurationFlag::ForceCollapsedInGroup);
 
+    _cancelKnnGraphAction.setToolTip("Cancel computing the floods");
+    _cancelKnnGraphAction.setEnabled(false);
+
     //_triggers << TriggersAction::Trigger("Flood Steps", "Color flood points by closeness to seed point in HD space");
     //_triggers << TriggersAction::Trigger("Top Dimension Values", "Color flood points by values of top ranked dimension");
     //_triggers << TriggersAction::Trigger("Local Dimensionality", "Color flood points by local intrinsic dimensionality");
@@ -49,10 +54,14 @@ void OverlayAction::initialize(SpaceWalkerPlugin* spaceWalkerPlugin)
 {
     connect(&_computeKnnGraphAction, &TriggerAction::triggered, this, [spaceWalkerPlugin](bool enabled)
     {
-        spaceWalkerPlugin->createKnnIndex();
         spaceWalkerPlugin->computeKnnGraph();
     });
 
+    connect(&_cancelKnnGraphAction, &TriggerAction::triggered, this, [spaceWalkerPlugin](bool enabled)
+    {
+        spaceWalkerPlugin->cancelKnnGraphBuild();
+    });
+
     connect(&_floodDecimal, &IntegralAction::valueChanged, this, [spaceWalkerPlugin](int32_t value)
     {
         spaceWalkerPlugin->rebuildKnnGraph(value);
@@ -69,6 +78,11 @@ void OverlayAction::initialize(SpaceWalkerPlugin* spaceWalkerPlugin)
         spaceWalkerPlugin->useSharedDistances(enabled);
     });
 
+    connect(&_graphBinsAction, &IntegralAction::valueChanged, this, [spaceWalkerPlugin](int32_t value)
+    {
+        spaceWalkerPlugin->setNumGraphBins(value);
+    });
+
     // Overlay buttons
     connect(&_floodOverlayAction, &TriggerAction::triggered, this, [spaceWalkerPlugin](bool enabled)
     {
@@ -103,10 +117,36 @@ QMenu* OverlayAction::getContextMenu()
     addActionToMenu(&_floodDecimal);
     addActionToMenu(&_floodStepsAction);
     addActionToMenu(&_sharedDistAction);
+    addActionToMenu(&_graphBinsAction);
 
     return menu;
 }
 
+void OverlayAction::setKnnGraphBuildRunning(bool running)
+{
+    _computeKnnGraphAction.setEnabled(!running);
+    _cancelKnnGraphAction.setEnabled(running);
+
+    _computeKnnGraphAction.setText(running ? "Computing Floods (0%)" : "Compute Floods");
+}
+
+void OverlayAction::setKnnGraphBuildProgress(float progress)
+{
+    _computeKnnGraphAction.setText(QString("Computing Floods (%1%)").arg((int) (progress * 100)));
+}
+
+void OverlayAction::setDataPreparationRunning(bool running)
+{
+    _computeKnnGraphAction.setEnabled(!running);
+
+    _computeKnnGraphAction.setText(running ? "Preparing Data (0%)" : "Compute Floods");
+}
+
+void OverlayAction::setDataPreparationProgress(float progress)
+{
+    _computeKnnGraphAction.setText(QString("Preparing Data (%1%)").arg((int) (progress * 100)));
+}
+
 void OverlayAction::fromVariantMap(const QVariantMap& variantMap)
 {
     WidgetAction::fromVariantMap(variantMap);
@@ -114,6 +154,7 @@ void OverlayAction::fromVariantMap(const QVariantMap& variantMap)
     _floodDecimal.fromParentVariantMap(variantMap);
     _floodStepsAction.fromParentVariantMap(variantMap);
     _sharedDistAction.fromParentVariantMap(variantMap);
+    _graphBinsAction.fromParentVariantMap(variantMap);
 
     _floodOverlayAction.fromParentVariantMap(variantMap);
     _dimensionOverlayAction.fromParentVariantMap(variantMap);
@@ -127,6 +168,7 @@ QVariantMap OverlayAction::toVariantMap() const
     _floodDecimal.insertIntoVariantMap(variantMap);
     _floodStepsAction.insertIntoVariantMap(variantMap);
     _sharedDistAction.insertIntoVariantMap(variantMap);
+    _graphBinsAction.insertIntoVariantMap(variantMap);
 
     _floodOverlayAction.insertIntoVariantMap(variantMap);
     _dimensionOverlayAction.insertIntoVariantMap(variantMap);
@@ -147,6 +189,7 @@ OverlayAction::Widget::Widget(QWidget* parent, OverlayAction* overlayAction, con
 
     layout->addWidget(overlayAction->getComputeKnnGraphAction().createLabelWidget(this), 0, 0);
     layout->addWidget(overlayAction->getComputeKnnGraphAction().createWidget(this), 0, 1);
+    layout->addWidget(overlayAction->getCancelKnnGraphAction().createWidget(this), 0, 2);
 
     layout->addWidget(overlayAction->getFloodDecimalAction().createLabelWidget(this), 1, 0);
     layout->addWidget(overlayAction->getFloodDecimalAction().createWidget(this), 1, 1);
@@ -157,10 +200,13 @@ OverlayAction::Widget::Widget(QWidget* parent, OverlayAction* overlayAction, con
     layout->addWidget(overlayAction->getSharedDistAction().createLabelWidget(this), 3, 0);
     layout->addWidget(overlayAction->getSharedDistAction().createWidget(this), 3, 1);
 
-    layout->addWidget(new QLabel("Color flood nodes by:", parent), 4, 0);
-    layout->addWidget(overlayAction->getFloodOverlayAction().createWidget(this), 5, 0);
-    layout->addWidget(overlayAction->getDimensionOverlayAction().createWidget(this), 5, 1);
-    layout->addWidget(overlayAction->getDimensionalityOverlayAction().createWidget(this), 5, 2);
+    layout->addWidget(overlayAction->getGraphBinsAction().createLabelWidget(this), 4, 0);
+    layout->addWidget(overlayAction->getGraphBinsAction().createWidget(this), 4, 1);
+
+    layout->addWidget(new QLabel("Color flood nodes by:", parent), 5, 0);
+    layout->addWidget(overlayAction->getFloodOverlayAction().createWidget(this), 6, 0);
+    layout->addWidget(overlayAction->getDimensionOverlayAction().createWidget(this), 6, 1);
+    layout->addWidget(overlayAction->getDimensionalityOverlayAction().createWidget(this), 6, 2);
 
     setLayout(layout);
 }
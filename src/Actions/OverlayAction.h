@@ -32,6 +32,18 @@ public:
 
     QMenu* getContextMenu();
 
+    /** Switch the compute button between starting a kNN build and showing its progress */
+    void setKnnGraphBuildRunning(bool running);
+
+    /** Show the progress of the running kNN build, progress in [0, 1] */
+    void setKnnGraphBuildProgress(float progress);
+
+    /** Disable the compute button while the data is prepared, floods need the prepared data */
+    void setDataPreparationRunning(bool running);
+
+    /** Show the progress of the data preparation, progress in [0, 1] */
+    void setDataPreparationProgress(float progress);
+
     /**
      *
      *
@@ -52,10 +64,12 @@ public: // Serialization
 
 public: // Action getters
     TriggerAction& getComputeKnnGraphAction() { return _computeKnnGraphAction; }
+    TriggerAction& getCancelKnnGraphAction() { return _cancelKnnGraphAction; }
 
     IntegralAction& getFloodDecimalAction() { return _floodDecimal; }
     IntegralAction& getFloodStepsAction() { return _floodStepsAction; }
     ToggleAction& getSharedDistAction() { return _sharedDistAction; }
+    IntegralAction& getGraphBinsAction() { return _graphBinsAction; }
 
     TriggerAction& getFloodOverlayAction() { return _floodOverlayAction; }
     TriggerAction& getDimensionOverlayAction() { return _dimensionOverlayAction; }
@@ -66,10 +80,12 @@ public: // Action getters
 private:
     SpaceWalkerPlugin*  _spaceWalkerPlugin;             /** Pointer to scatterplot plugin */
     TriggerAction       _computeKnnGraphAction;
+    TriggerAction       _cancelKnnGraphAction;
 
     IntegralAction      _floodDecimal;
     IntegralAction      _floodStepsAction;
     ToggleAction        _sharedDistAction;
+    IntegralAction      _graphBinsAction;
 
     TriggerAction       _floodOverlayAction;
     TriggerAction       _dimensionOverlayAction;
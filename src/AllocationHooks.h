@@ -0,0 +1,51 @@
+#pragma once
+
+/**
+ * Replaces the global operator new and delete to count allocations, see Allocations.h.
+ * Include in exactly one source file of an executable, never in a library.
+ */
+
+#include "Allocations.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace allocations
+{
+    namespace detail
+    {
+        inline void* countedAllocate(std::size_t size)
+        {
+            count(size);
+            return std::malloc(size == 0 ? 1 : size);
+        }
+
+        static const bool installed = (hooked.store(true), true);
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    void* ptr = allocations::detail::countedAllocate(size);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+    void* ptr = allocations::detail::countedAllocate(size);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocations::detail::countedAllocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocations::detail::countedAllocate(size); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
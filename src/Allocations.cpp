@@ -0,0 +1,19 @@
+#include "Allocations.h"
+
+namespace allocations
+{
+    namespace detail
+    {
+        std::atomic<bool>           hooked(false);
+        std::atomic<std::uint64_t>  allocations(0);
+        std::atomic<std::uint64_t>  bytes(0);
+    }
+
+    Counts getCounts()
+    {
+        Counts counts;
+        counts.allocations = detail::allocations.load(std::memory_order_relaxed);
+        counts.bytes = detail::bytes.load(std::memory_order_relaxed);
+        return counts;
+    }
+}
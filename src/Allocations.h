@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Counts of heap allocations made through operator new.
+ *
+ * Nothing is counted unless the executable replaces the global operator new by including
+ * AllocationHooks.h in one of its source files, the plugin doesn't. Allocations that bypass
+ * operator new, such as Eigen matrices and faiss buffers, are never counted.
+ *
+ *   allocations::Counts before = allocations::getCounts();
+ *   compute();
+ *   allocations::Counts made = allocations::getCounts() - before;
+ */
+namespace allocations
+{
+    struct Counts
+    {
+        std::uint64_t   allocations = 0;
+        std::uint64_t   bytes = 0;
+
+        Counts operator-(const Counts& other) const { return { allocations - other.allocations, bytes - other.bytes }; }
+    };
+
+    namespace detail
+    {
+        extern std::atomic<bool>            hooked;
+        extern std::atomic<std::uint64_t>   allocations;
+        extern std::atomic<std::uint64_t>   bytes;
+    }
+
+    /** Whether allocations are counted, false without the hooks */
+    inline bool isCounting() { return detail::hooked.load(std::memory_order_relaxed); }
+
+    /** Allocations of all threads since the start of the process */
+    Counts getCounts();
+
+    /** Called by the hooks on every allocation */
+    inline void count(std::size_t size)
+    {
+        detail::allocations.fetch_add(1, std::memory_order_relaxed);
+        detail::bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+}
@@ -1,5 +1,6 @@
 #include "CellRenderer.h"
 
+#include <algorithm>
 #include <limits>
 #define JC_VORONOI_IMPLEMENTATION
 #include <jc_voronoi.h>
@@ -116,6 +117,22 @@ namespace hdps
                 _positions[i * 3 + 2] = positions[id];
             }
 
+            // Inverse of _ids so scalar updates of single points only touch their own cells
+            _pointTriangleOffsets.assign(positions.size() + 1, 0);
+            for (int id : _ids)
+                _pointTriangleOffsets[id + 1]++;
+            for (int p = 0; p < positions.size(); p++)
+                _pointTriangleOffsets[p + 1] += _pointTriangleOffsets[p];
+
+            _pointTriangles.resize(_ids.size());
+            std::vector<int> fill(_pointTriangleOffsets.begin(), _pointTriangleOffsets.end() - 1);
+            for (int i = 0; i < _ids.size(); i++)
+                _pointTriangles[fill[_ids[i]]++] = i;
+
+            _pointScalars.clear();
+            _colorScalars.clear();
+            _dirtyTriangles.clear();
+
             _dirtyVertices = true;
         }
 
@@ -148,9 +165,54 @@ namespace hdps
                 _colorScalars[i * 3 + 2] = scalars[id];
             }
 
+            _pointScalars = scalars;
+            _dirtyTriangles.clear();
             _dirtyColorScalars = true;
         }
 
+        void CellArrayObject::updateScalars(const std::vector<int>& indices, const std::vector<float>& scalars)
+        {
+            // Without a full set of scalars there is nothing to update
+            if (_pointScalars.size() + 1 != _pointTriangleOffsets.size())
+                return;
+
+            bool recomputeRange = false;
+            for (int i = 0; i < indices.size(); i++)
+            {
+                int id = indices[i];
+                float oldScalar = _pointScalars[id];
+                float scalar = scalars[i];
+                _pointScalars[id] = scalar;
+
+                // The range only has to be recomputed if one of its bounds was overwritten
+                if ((oldScalar <= _colorScalarsRange.x && scalar > oldScalar) || (oldScalar >= _colorScalarsRange.y && scalar < oldScalar))
+                    recomputeRange = true;
+                _colorScalarsRange.x = std::min(_colorScalarsRange.x, scalar);
+                _colorScalarsRange.y = std::max(_colorScalarsRange.y, scalar);
+
+                for (int t = _pointTriangleOffsets[id]; t < _pointTriangleOffsets[id + 1]; t++)
+                {
+                    int triangle = _pointTriangles[t];
+                    _colorScalars[triangle * 3 + 0] = scalar;
+                    _colorScalars[triangle * 3 + 1] = scalar;
+                    _colorScalars[triangle * 3 + 2] = scalar;
+                    _dirtyTriangles.push_back(triangle);
+                }
+            }
+
+            if (recomputeRange)
+            {
+                auto minMax = std::minmax_element(_pointScalars.begin(), _pointScalars.end());
+                _colorScalarsRange.x = *minMax.first;
+                _colorScalarsRange.y = *minMax.second;
+            }
+
+            _colorScalarsRange.z = _colorScalarsRange.y - _colorScalarsRange.x;
+
+            if (_colorScalarsRange.z < 1e-07f)
+                _colorScalarsRange.z = 1e-07f;
+        }
+
         void CellArrayObject::setColors(const std::vector<Vector3f>& colors)
         {
             _colors = colors;
@@ -203,6 +265,27 @@ namespace hdps
                 qDebug() << "Uploading scalars";
 
                 _dirtyColorScalars = false;
+                _dirtyTriangles.clear();
+            }
+
+            if (!_dirtyTriangles.empty())
+            {
+                // Upload runs of consecutive changed triangles instead of the whole buffer
+                std::sort(_dirtyTriangles.begin(), _dirtyTriangles.end());
+                _dirtyTriangles.erase(std::unique(_dirtyTriangles.begin(), _dirtyTriangles.end()), _dirtyTriangles.end());
+
+                _colorScalarBuffer.bind();
+                for (int i = 0; i < _dirtyTriangles.size();)
+                {
+                    int first = _dirtyTriangles[i];
+                    int last = first;
+                    while (++i < _dirtyTriangles.size() && _dirtyTriangles[i] == last + 1)
+                        last++;
+
+                    glBufferSubData(GL_ARRAY_BUFFER, (GLintptr) first * 3 * sizeof(float), (GLsizeiptr) (last - first + 1) * 3 * sizeof(float), &_colorScalars[first * 3]);
+                }
+
+                _dirtyTriangles.clear();
             }
 
             if (!_triangles.empty())
@@ -228,6 +311,11 @@ namespace hdps
             _gpuPoints.setScalars(scalars);
         }
 
+        void CellRenderer::updateColorChannelScalars(const std::vector<int>& indices, const std::vector<float>& scalars)
+        {
+            _gpuPoints.updateScalars(indices, scalars);
+        }
+
         void CellRenderer::setColors(const std::vector<Vector3f>& colors)
         {
             _gpuPoints.setColors(colors);
@@ -39,6 +39,7 @@ namespace hdps
             void init();
             void setPositions(const std::vector<Vector2f>& positions);
             void setScalars(const std::vector<float>& scalars);
+            void updateScalars(const std::vector<int>& indices, const std::vector<float>& scalars);
             void setColors(const std::vector<Vector3f>& colors);
 
             void enableAttribute(uint index, bool enable);
@@ -72,9 +73,13 @@ namespace hdps
             std::vector<Vector3f>   _colors;
 
             std::vector<int>        _ids;
+            std::vector<int>        _pointTriangleOffsets;  /** Offsets of each point into _pointTriangles */
+            std::vector<int>        _pointTriangles;        /** Triangles of each point's cell */
 
             /** Scalar channels */
             std::vector<float>  _colorScalars;      /** Point color scalar channel */
+            std::vector<float>  _pointScalars;      /** Color scalar of each point, used to maintain the range */
+            std::vector<int>    _dirtyTriangles;    /** Triangles whose scalars changed since the last upload */
 
             /** Scalar ranges */
             Vector3f    _colorScalarsRange;     /** Scalar range of the point color scalars */
@@ -89,6 +94,7 @@ namespace hdps
         public:
             void setData(const std::vector<Vector2f>& points);
             void setColorChannelScalars(const std::vector<float>& scalars);
+            void updateColorChannelScalars(const std::vector<int>& indices, const std::vector<float>& scalars);
             void setColors(const std::vector<Vector3f>& colors);
 
             void setScalarEffect(const ScalarEffect effect);
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+
+/**
+ * Progress and cancellation state shared between a long running computation and the thread
+ * that observes it. The computation reports progress within the range of its current stage
+ * and checks isCancelled() at convenient points to stop early.
+ */
+class ComputeProgress
+{
+public:
+    ComputeProgress() :
+        _progress(0),
+        _cancelled(false),
+        _stageBegin(0),
+        _stageEnd(1)
+    {
+
+    }
+
+    void reset()
+    {
+        _progress = 0;
+        _cancelled = false;
+        _stageBegin = 0;
+        _stageEnd = 1;
+    }
+
+    /** Map the progress of the next stage to [begin, end] of the total progress */
+    void setStage(float begin, float end)
+    {
+        _stageBegin = begin;
+        _stageEnd = end;
+        _progress = begin;
+    }
+
+    /** Set progress within the current stage, fraction in [0, 1] */
+    void setStageProgress(float fraction)
+    {
+        _progress = _stageBegin + (_stageEnd - _stageBegin) * fraction;
+    }
+
+    /** Total progress in [0, 1] */
+    float getProgress() const { return _progress; }
+
+    void cancel() { _cancelled = true; }
+    bool isCancelled() const { return _cancelled; }
+
+private:
+    std::atomic<float>  _progress;
+    std::atomic<bool>   _cancelled;
+    float               _stageBegin;
+    float               _stageEnd;
+};
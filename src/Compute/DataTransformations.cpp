@@ -1,5 +1,7 @@
 #include "DataTransformations.h"
 
+#include "TaskScheduler.h"
+
 void standardizeData(DataMatrix& dataMatrix, std::vector<float>& variances)
 {
     int numPoints = dataMatrix.rows();
@@ -8,8 +10,7 @@ void standardizeData(DataMatrix& dataMatrix, std::vector<float>& variances)
     std::vector<float> means(numDimensions);
     variances.resize(numDimensions);
 
-#pragma omp parallel for
-    for (int d = 0; d < numDimensions; d++)
+    tasks::parallelFor(0, numDimensions, [&](int d)
     {
         // Compute mean
         float mean = dataMatrix.col(d).mean();
@@ -21,7 +22,7 @@ void standardizeData(DataMatrix& dataMatrix, std::vector<float>& variances)
         variances[d] = (dataMatrix.col(d).array() - mean).square().sum() / numPoints;
 
         // If variance is 0, then don't try to divide the data by it
-        if (variances[d] <= 0) continue;
+        if (variances[d] <= 0) return;
 
         // Standardize data
         float invStddev = 1.0f / sqrt(variances[d]);
@@ -31,7 +32,7 @@ void standardizeData(DataMatrix& dataMatrix, std::vector<float>& variances)
             dataMatrix(i, d) -= mean;
             dataMatrix(i, d) *= invStddev;
         }
-    }
+    });
 
     //// Print means and variances
     //for (int d = 0; d < numDimensions; d++)
@@ -43,8 +44,7 @@ void standardizeData(DataMatrix& dataMatrix, std::vector<float>& variances)
 void normalizeData(const DataMatrix& dataMatrix, std::vector<std::vector<float>>& normalizedData)
 {
     normalizedData.resize(dataMatrix.cols(), std::vector<float>(dataMatrix.rows()));
-#pragma omp parallel for
-    for (int d = 0; d < dataMatrix.cols(); d++)
+    tasks::parallelFor(0, (int) dataMatrix.cols(), [&](int d)
     {
         auto col = dataMatrix.col(d);
 
@@ -55,5 +55,48 @@ void normalizeData(const DataMatrix& dataMatrix, std::vector<std::vector<float>>
 
         for (int i = 0; i < dataMatrix.rows(); i++)
             normalizedData[d][i] = std::min(0.99999f, (col(i) - minVal) / range);
+    });
+}
+
+DimensionChange::DimensionChange(const std::vector<int>& oldDimensions, const std::vector<int>& newDimensions)
+{
+    sourceColumns.resize(newDimensions.size());
+
+    // Both are sorted, so the kept dimensions are found in a single pass
+    int oldColumn = 0;
+    for (int d = 0; d < (int) newDimensions.size(); d++)
+    {
+        while (oldColumn < (int) oldDimensions.size() && oldDimensions[oldColumn] < newDimensions[d])
+            oldColumn++;
+
+        if (oldColumn < (int) oldDimensions.size() && oldDimensions[oldColumn] == newDimensions[d])
+            sourceColumns[d] = oldColumn++;
+        else
+        {
+            sourceColumns[d] = -1;
+            addedDimensions.push_back(newDimensions[d]);
+        }
     }
 }
+
+void applyDimensionChange(const DimensionChange& change, DataMatrix& dataMatrix, const DataMatrix& addedColumns)
+{
+    DataMatrix newMatrix(dataMatrix.rows(), (Eigen::Index) change.sourceColumns.size());
+
+    // Columns are contiguous, so each is a single copy
+    tasks::parallelFor(0, (int) change.sourceColumns.size(), [&](int d)
+    {
+        int source = change.sourceColumns[d];
+        if (source >= 0)
+            newMatrix.col(d) = dataMatrix.col(source);
+    });
+
+    int added = 0;
+    for (int d = 0; d < (int) change.sourceColumns.size(); d++)
+    {
+        if (change.sourceColumns[d] < 0)
+            newMatrix.col(d) = addedColumns.col(added++);
+    }
+
+    dataMatrix = std::move(newMatrix);
+}
@@ -3,6 +3,40 @@
 #include "DataMatrix.h"
 
 #include <iostream>
+#include <utility>
+#include <vector>
 
 void standardizeData(DataMatrix& dataMatrix, std::vector<float>& variances);
 void normalizeData(const DataMatrix& dataMatrix, std::vector<std::vector<float>>& normalizedData);
+
+/**
+ * How the columns of data with one set of enabled dimensions map to the columns with another.
+ * Both sets are dimension indices in ascending order, as the columns are.
+ */
+struct DimensionChange
+{
+    DimensionChange() = default;
+    DimensionChange(const std::vector<int>& oldDimensions, const std::vector<int>& newDimensions);
+
+    std::vector<int>    sourceColumns;      /** Old column of each new column, -1 for added columns */
+    std::vector<int>    addedDimensions;    /** Dimensions of the added columns, in the order of the new columns */
+};
+
+/** Rearrange the columns to the new dimensions, the added columns are taken from addedColumns in order */
+void applyDimensionChange(const DimensionChange& change, DataMatrix& dataMatrix, const DataMatrix& addedColumns);
+
+/** Rearrange per-dimension values to the new dimensions, the added values are moved from addedValues in order */
+template<typename T>
+void applyDimensionChange(const DimensionChange& change, std::vector<T>& values, std::vector<T>& addedValues)
+{
+    std::vector<T> newValues(change.sourceColumns.size());
+
+    int added = 0;
+    for (int d = 0; d < (int) change.sourceColumns.size(); d++)
+    {
+        int source = change.sourceColumns[d];
+        newValues[d] = source >= 0 ? std::move(values[source]) : std::move(addedValues[added++]);
+    }
+
+    values = std::move(newValues);
+}
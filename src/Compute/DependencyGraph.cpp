@@ -0,0 +1,155 @@
+#include "DependencyGraph.h"
+
+#include "ComputeProgress.h"
+#include "Tracing.h"
+
+#include <algorithm>
+#include <future>
+
+namespace
+{
+    /** Compute a node and trace it as a stage of its own */
+    double timeMilliseconds(tracing::Stage& stage, const std::function<void()>& compute)
+    {
+        std::uint64_t begin = tracing::now();
+        compute();
+        std::uint64_t end = tracing::now();
+
+        if (tracing::isEnabled())
+            tracing::record(stage, begin, end);
+        return (end - begin) / 1e6;
+    }
+}
+
+DependencyGraph::NodeId DependencyGraph::addNode(const std::string& name, const std::vector<NodeId>& inputs, Compute compute, bool callingThreadOnly)
+{
+    NodeId id = (NodeId) _nodes.size();
+
+    Node node;
+    node.name = name;
+    node.inputs = inputs;
+    node.compute = std::move(compute);
+    node.callingThreadOnly = callingThreadOnly;
+    node.stage = &tracing::registerStage(name);
+    _nodes.push_back(std::move(node));
+
+    for (NodeId input : inputs)
+        _nodes[input].outputs.push_back(id);
+
+    return id;
+}
+
+void DependencyGraph::invalidate(NodeId node)
+{
+    std::vector<NodeId> stack = { node };
+    while (!stack.empty())
+    {
+        NodeId current = stack.back();
+        stack.pop_back();
+
+        // Dirty nodes have dirty outputs already
+        if (_nodes[current].dirty && current != node)
+            continue;
+
+        _nodes[current].dirty = true;
+        stack.insert(stack.end(), _nodes[current].outputs.begin(), _nodes[current].outputs.end());
+    }
+}
+
+void DependencyGraph::update(const std::vector<NodeId>& targets, ComputeProgress* progress)
+{
+    _lastComputeTimes.clear();
+
+    // Level of each dirty node that is needed, one more than the highest level of its dirty inputs.
+    // Nodes are added after their inputs, so ids are a topological order.
+    std::vector<int> levels(_nodes.size(), -1);
+    std::vector<NodeId> stack;
+    for (NodeId target : targets)
+    {
+        if (_nodes[target].dirty)
+            stack.push_back(target);
+    }
+
+    std::vector<bool> needed(_nodes.size(), false);
+    while (!stack.empty())
+    {
+        NodeId current = stack.back();
+        stack.pop_back();
+
+        if (needed[current])
+            continue;
+        needed[current] = true;
+
+        for (NodeId input : _nodes[current].inputs)
+        {
+            if (_nodes[input].dirty)
+                stack.push_back(input);
+        }
+    }
+
+    int numLevels = 0;
+    int numNeeded = 0;
+    for (NodeId id = 0; id < (NodeId) _nodes.size(); id++)
+    {
+        if (!needed[id])
+            continue;
+        numNeeded++;
+
+        int level = 0;
+        for (NodeId input : _nodes[id].inputs)
+        {
+            if (needed[input])
+                level = std::max(level, levels[input] + 1);
+        }
+        levels[id] = level;
+        numLevels = std::max(numLevels, level + 1);
+    }
+
+    int numComputed = 0;
+    for (int level = 0; level < numLevels; level++)
+    {
+        // Levels depend on the ones before, so stopping here leaves no artifact computed from dirty inputs
+        if (progress && progress->isCancelled())
+            break;
+
+        std::vector<NodeId> parallelNodes;
+        std::vector<NodeId> callingThreadNodes;
+        for (NodeId id = 0; id < (NodeId) _nodes.size(); id++)
+        {
+            if (levels[id] != level)
+                continue;
+
+            if (_nodes[id].callingThreadOnly)
+                callingThreadNodes.push_back(id);
+            else
+                parallelNodes.push_back(id);
+        }
+
+        // Run all but one of the parallel nodes on other threads while this thread does the rest
+        std::vector<std::future<double>> futures;
+        for (size_t i = 1; i < parallelNodes.size(); i++)
+        {
+            const Node& node = _nodes[parallelNodes[i]];
+            futures.push_back(std::async(std::launch::async, [&node]() { return timeMilliseconds(*node.stage, node.compute); }));
+        }
+
+        std::vector<ComputeTime> times;
+        if (!parallelNodes.empty())
+            times.push_back({ _nodes[parallelNodes[0]].name, timeMilliseconds(*_nodes[parallelNodes[0]].stage, _nodes[parallelNodes[0]].compute) });
+        for (NodeId id : callingThreadNodes)
+            times.push_back({ _nodes[id].name, timeMilliseconds(*_nodes[id].stage, _nodes[id].compute) });
+        for (size_t i = 0; i < futures.size(); i++)
+            times.push_back({ _nodes[parallelNodes[i + 1]].name, futures[i].get() });
+
+        for (NodeId id : parallelNodes)
+            _nodes[id].dirty = false;
+        for (NodeId id : callingThreadNodes)
+            _nodes[id].dirty = false;
+
+        _lastComputeTimes.insert(_lastComputeTimes.end(), times.begin(), times.end());
+
+        numComputed += (int) (parallelNodes.size() + callingThreadNodes.size());
+        if (progress)
+            progress->setStageProgress((float) numComputed / numNeeded);
+    }
+}
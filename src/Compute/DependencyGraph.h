@@ -0,0 +1,75 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * Lazily computed artifacts that declare which other artifacts they are derived from.
+ *
+ * Invalidating an artifact marks it and everything derived from it as dirty. Updating an artifact
+ * computes its dirty inputs first, each at most once. Dirty artifacts that don't depend on each
+ * other are computed in parallel, unless they have to run on the thread calling update().
+ * Not thread-safe, an update may run on a background thread as long as no other thread uses the
+ * graph until it returns.
+ */
+namespace tracing
+{
+    struct Stage;
+}
+
+class ComputeProgress;
+
+class DependencyGraph
+{
+public:
+    using NodeId = int;
+    using Compute = std::function<void()>;
+
+    /** How long an artifact took to compute in the last update */
+    struct ComputeTime
+    {
+        std::string name;
+        double      milliseconds;
+    };
+
+    /**
+     * Add an artifact, it starts out dirty
+     * @param inputs Artifacts it is derived from, they have to be added first
+     * @param callingThreadOnly Whether it has to be computed on the thread calling update(), e.g. because it touches widgets
+     */
+    NodeId addNode(const std::string& name, const std::vector<NodeId>& inputs, Compute compute, bool callingThreadOnly = false);
+
+    /** Mark an artifact and all artifacts derived from it as dirty */
+    void invalidate(NodeId node);
+
+    bool isDirty(NodeId node) const { return _nodes[node].dirty; }
+
+    /**
+     * Compute the dirty artifacts the given ones depend on, and the given ones themselves
+     * @param progress Optional, receives the fraction of computed artifacts and is checked for cancellation
+     * between artifacts that depend on each other, the artifacts that weren't computed stay dirty
+     */
+    void update(const std::vector<NodeId>& targets, ComputeProgress* progress = nullptr);
+    void update(NodeId target) { update(std::vector<NodeId>{ target }); }
+
+    const std::string& getName(NodeId node) const { return _nodes[node].name; }
+
+    /** Artifacts computed by the last update, in order of completion per level */
+    const std::vector<ComputeTime>& getLastComputeTimes() const { return _lastComputeTimes; }
+
+private:
+    struct Node
+    {
+        std::string         name;
+        std::vector<NodeId> inputs;
+        std::vector<NodeId> outputs;
+        Compute             compute;
+        bool                callingThreadOnly = false;
+        bool                dirty = true;
+        tracing::Stage*     stage = nullptr;
+    };
+
+    std::vector<Node>           _nodes;
+    std::vector<ComputeTime>    _lastComputeTimes;
+};
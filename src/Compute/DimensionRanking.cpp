@@ -0,0 +1,43 @@
+#include "DimensionRanking.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace filters
+{
+    DimensionRanker::DimensionRanker() :
+        _topK(FULL_RANKING)
+    {
+
+    }
+
+    void DimensionRanker::rank(std::vector<int>& dimRanking)
+    {
+        rank(dimRanking, _topK);
+    }
+
+    void DimensionRanker::rank(std::vector<int>& dimRanking, int topK)
+    {
+        const std::vector<float>& scores = _scores;
+        int numDimensions = (int) scores.size();
+        int k = (topK <= 0 || topK > numDimensions) ? numDimensions : topK;
+
+        _order.resize(numDimensions);
+        std::iota(_order.begin(), _order.end(), 0);
+
+        // Sort from high to low, equal scores keep their original order
+        auto compare = [&scores](int i1, int i2) {
+            return scores[i1] > scores[i2] || (scores[i1] == scores[i2] && i1 < i2);
+        };
+
+        if (k < numDimensions)
+        {
+            std::nth_element(_order.begin(), _order.begin() + k, _order.end(), compare);
+            std::sort(_order.begin(), _order.begin() + k, compare);
+        }
+        else
+            std::sort(_order.begin(), _order.end(), compare);
+
+        dimRanking.assign(_order.begin(), _order.begin() + k);
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+
+namespace filters
+{
+    /** Top-K value that requests the full ordering of all dimensions (used by exports) */
+    constexpr int FULL_RANKING = 0;
+
+    /**
+     * Dimension ranking engine
+     *
+     * Holds the scratch buffers that the filters need for ranking dimensions so that they
+     * persist between calls, and orders dimensions by score. Only the top K dimensions are
+     * sorted (nth_element + partial sort), ties are broken on the lower dimension index so
+     * the result matches a stable sort of the full order.
+     */
+    class DimensionRanker
+    {
+    public:
+        DimensionRanker();
+
+        int getTopK() const { return _topK; }
+        void setTopK(int topK) { _topK = topK; }
+
+        /** Per-dimension scores to rank on, filled in by the filters */
+        std::vector<float>& getScores() { return _scores; }
+        const std::vector<float>& getScores() const { return _scores; }
+
+        /** Scratch buffers for the near (0) and far (1) neighbourhoods of the filters */
+        std::vector<float>& getAverages(int i) { return _averages[i]; }
+        std::vector<int>& getIndices(int i) { return _indices[i]; }
+
+        /**
+         * Rank dimensions on the current scores from high to low
+         * @param dimRanking Output ranking, holds the top K dimensions, or all of them if K is FULL_RANKING
+         */
+        void rank(std::vector<int>& dimRanking);
+        void rank(std::vector<int>& dimRanking, int topK);
+
+    private:
+        int                 _topK;
+
+        std::vector<float>  _scores;
+        std::vector<float>  _averages[2];
+        std::vector<int>    _indices[2];
+        std::vector<int>    _order;
+    };
+}
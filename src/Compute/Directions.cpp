@@ -1,9 +1,8 @@
 #include "Directions.h"
 
 #include "FloodFill.h"
-#include "graphics/Vector2f.h"
 
-void computeDirection(DataMatrix& dataMatrix, DataMatrix& projMatrix, KnnGraph& knnGraph, int numSteps, std::vector<hdps::Vector2f>& directions)
+void computeDirection(DataMatrix& dataMatrix, DataMatrix& projMatrix, KnnGraph& knnGraph, int numSteps, std::vector<Eigen::Vector2f>& directions)
 {
     for (int p = 0; p < dataMatrix.rows(); p++)
     {
@@ -41,13 +40,13 @@ void computeDirection(DataMatrix& dataMatrix, DataMatrix& projMatrix, KnnGraph&
         // Normalize eigenvalues to make them represent percentages.
         Eigen::MatrixXf evecs = eig.eigenvectors();
         // Get the two major eigenvectors and omit the others.
-        hdps::Vector2f majorEigenVector;
+        Eigen::Vector2f majorEigenVector;
         if (eig.eigenvalues()(0) > eig.eigenvalues()(1))
-            majorEigenVector.set(evecs(0, 0), evecs(1, 0));
+            majorEigenVector = Eigen::Vector2f(evecs(0, 0), evecs(1, 0));
         else
-            majorEigenVector.set(evecs(0, 1), evecs(1, 1));
+            majorEigenVector = Eigen::Vector2f(evecs(0, 1), evecs(1, 1));
 
-        directions.push_back(hdps::Vector2f(projMatrix(p, 0), projMatrix(p, 1)));
+        directions.push_back(Eigen::Vector2f(projMatrix(p, 0), projMatrix(p, 1)));
         directions.push_back(majorEigenVector);
     }
 }
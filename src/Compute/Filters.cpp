@@ -1,10 +1,10 @@
 #include "Filters.h"
 
 #include "FloodFill.h"
+#include "FloodWorkingSet.h"
+#include "TaskScheduler.h"
 
-#include "graphics/Vector2f.h"
-#include "graphics/Vector3f.h"
-
+#include <algorithm>
 #include <numeric>
 #include <iostream>
 #include <fstream>
@@ -12,17 +12,16 @@
 #include <iomanip>
 #include <ctime>
 
-using namespace hdps;
-
-void findPointsInRadius(Vector2f center, float radius, const DataMatrix& projMatrix, std::vector<int>& indices)
+void findPointsInRadius(Eigen::Vector2f center, float radius, const DataMatrix& projMatrix, std::vector<int>& indices)
 {
     float radiusSqr = radius * radius;
+
+    indices.clear();
     for (int i = 0; i < projMatrix.rows(); i++)
     {
-        Vector2f pos(projMatrix(i, 0), projMatrix(i, 1));
+        Eigen::Vector2f pos(projMatrix(i, 0), projMatrix(i, 1));
 
-        Vector2f diff = center - pos;
-        float sqrLen = diff.x * diff.x + diff.y * diff.y;
+        float sqrLen = (center - pos).squaredNorm();
 
         if (sqrLen < radiusSqr)
         {
@@ -34,10 +33,12 @@ void findPointsInRadius(Vector2f center, float radius, const DataMatrix& projMat
 void computeDimensionAverage(const DataMatrix& data, const std::vector<int>& indices, std::vector<float>& averages)
 {
     int numDimensions = data.cols();
-    averages.resize(numDimensions, 0);
+    averages.assign(numDimensions, 0);
+
+    if (indices.empty())
+        return;
 
-#pragma omp parallel for
-    for (int d = 0; d < numDimensions; d++)
+    tasks::parallelFor(0, numDimensions, [&](int d)
     {
         for (const int& index : indices)
         {
@@ -45,7 +46,7 @@ void computeDimensionAverage(const DataMatrix& data, const std::vector<int>& ind
             averages[d] += v;
         }
         averages[d] /= indices.size();
-    }
+    });
 }
 
 void maskPoints(std::vector<int>& indices, const std::vector<int>& mask, std::vector<int>& intersection)
@@ -88,66 +89,37 @@ namespace filters
         int numDimensions = dataMatrix.cols();
 
         // Small and large circle averages
-        std::vector<std::vector<float>> averages(2);
-        std::vector<std::vector<int>> circleIndices(2);
+        std::vector<float>& innerAverages = _ranker.getAverages(0);
+        std::vector<float>& outerAverages = _ranker.getAverages(1);
 
-        Vector2f center = Vector2f(projMatrix(pointId, 0), projMatrix(pointId, 1));
+        Eigen::Vector2f center(projMatrix(pointId, 0), projMatrix(pointId, 1));
 
-        findPointsInRadius(center, _innerFilterRadius * projSize, projMatrix, circleIndices[0]);
-        computeDimensionAverage(dataMatrix, circleIndices[0], averages[0]);
-        findPointsInRadius(center, _outerFilterRadius * projSize, projMatrix, circleIndices[1]);
-        computeDimensionAverage(dataMatrix, circleIndices[1], averages[1]);
+        findPointsInRadius(center, _innerFilterRadius * projSize, projMatrix, _ranker.getIndices(0));
+        computeDimensionAverage(dataMatrix, _ranker.getIndices(0), innerAverages);
+        findPointsInRadius(center, _outerFilterRadius * projSize, projMatrix, _ranker.getIndices(1));
+        computeDimensionAverage(dataMatrix, _ranker.getIndices(1), outerAverages);
 
-        std::vector<float> diffAverages(numDimensions);
+        std::vector<float>& diffAverages = _ranker.getScores();
+        diffAverages.resize(numDimensions);
         for (int d = 0; d < numDimensions; d++)
         {
             diffAverages[d] = 0;
             if (variances[d] > 0)
-                diffAverages[d] = (averages[0][d] - averages[1][d]);// / variances[d];
+                diffAverages[d] = (innerAverages[d] - outerAverages[d]);// / variances[d];
         }
 
         // Sort averages from high to low
-        dimRanking.resize(numDimensions);
-        std::iota(dimRanking.begin(), dimRanking.end(), 0);
-
-        std::stable_sort(dimRanking.begin(), dimRanking.end(), [&diffAverages](size_t i1, size_t i2) {return diffAverages[i1] > diffAverages[i2]; });
+        _ranker.rank(dimRanking);
     }
 
     void SpatialPeakFilter::computeDimensionRanking(int pointId, const DataMatrix& dataMatrix, const std::vector<float>& variances, const DataMatrix& projMatrix, float projSize, std::vector<int>& dimRanking, const std::vector<int>& mask)
     {
-        int numDimensions = dataMatrix.cols();
-
-        // Small and large circle averages
-        std::vector<std::vector<float>> averages(2);
-        std::vector<std::vector<int>> circleIndices(2);
-
-        Vector2f center = Vector2f(projMatrix(pointId, 0), projMatrix(pointId, 1));
-
-        findPointsInRadius(center, _innerFilterRadius * projSize, projMatrix, circleIndices[0]);
         // Apply mask
         //std::vector<int> maskedIndicesInner;
         //maskPoints(circleIndices[0], mask, maskedIndicesInner);
-        computeDimensionAverage(dataMatrix, circleIndices[0], averages[0]);
-
-        findPointsInRadius(center, _outerFilterRadius * projSize, projMatrix, circleIndices[1]);
-        // Apply mask
         //std::vector<int> maskedIndicesOuter;
         //maskPoints(circleIndices[1], mask, maskedIndicesOuter);
-        computeDimensionAverage(dataMatrix, circleIndices[1], averages[1]);
-
-        std::vector<float> diffAverages(numDimensions);
-        for (int d = 0; d < numDimensions; d++)
-        {
-            diffAverages[d] = 0;
-            if (variances[d] > 0)
-                diffAverages[d] = (averages[0][d] - averages[1][d]);// / variances[d];
-        }
-
-        // Sort averages from high to low
-        dimRanking.resize(numDimensions);
-        std::iota(dimRanking.begin(), dimRanking.end(), 0);
-
-        std::stable_sort(dimRanking.begin(), dimRanking.end(), [&diffAverages](size_t i1, size_t i2) {return diffAverages[i1] > diffAverages[i2]; });
+        computeDimensionRanking(pointId, dataMatrix, variances, projMatrix, projSize, dimRanking);
     }
 
     HDFloodPeakFilter::HDFloodPeakFilter() :
@@ -168,40 +140,138 @@ namespace filters
     //}
 
     void HDFloodPeakFilter::computeDimensionRanking(int pointId, const DataMatrix& dataMatrix, const std::vector<float>& variances, const FloodFill& floodFill, std::vector<int>& dimRanking)
+    {
+        updateWaveSums(dataMatrix, floodFill);
+
+        computeSplitScores(_innerFilterSize, variances, _ranker.getScores());
+
+        // Sort averages from high to low
+        _ranker.rank(dimRanking);
+    }
+
+    void HDFloodPeakFilter::computeDimensionRanking(const FloodWorkingSet& workingSet, const std::vector<float>& variances, std::vector<int>& dimRanking)
+    {
+        updateWaveSums(workingSet);
+
+        computeSplitScores(_innerFilterSize, variances, _ranker.getScores());
+
+        // Sort averages from high to low
+        _ranker.rank(dimRanking);
+    }
+
+    void HDFloodPeakFilter::updateWaveSums(const DataMatrix& dataMatrix, const FloodFill& floodFill)
     {
         int numDimensions = dataMatrix.cols();
+        int numWaves = floodFill.getNumWaves();
+
+        _numActiveWaves = numWaves;
+
+        // The flood only shrinks without changing version, in which case the sums are still valid
+        if (_waveSumsVersion == floodFill.getVersion() && _waveSumsData == &dataMatrix && _numSummedDimensions == numDimensions && numWaves <= _numSummedWaves)
+            return;
+
+        const auto& waves = floodFill.getWaves();
 
-        std::vector<int> nearIndices;
-        std::vector<int> farIndices;
+        _waveCounts.assign(numWaves + 1, 0);
+        for (int w = 0; w < numWaves; w++)
+            _waveCounts[w + 1] = _waveCounts[w] + (int) waves[w].size();
 
-        for (int wave = 0; wave < _innerFilterSize; wave++)
+        _waveSums.assign((size_t) (numWaves + 1) * numDimensions, 0);
+
+        tasks::parallelFor(0, numDimensions, [&](int d)
         {
-            nearIndices.insert(nearIndices.end(), floodFill.getWaves()[wave].begin(), floodFill.getWaves()[wave].end());
-        }
-        for (int wave = _innerFilterSize; wave < floodFill.getNumWaves() - 1; wave++)
+            double sum = 0;
+            for (int w = 0; w < numWaves; w++)
+            {
+                for (const nint& node : waves[w])
+                    sum += dataMatrix(node, d);
+
+                _waveSums[(size_t) (w + 1) * numDimensions + d] = sum;
+            }
+        });
+
+        _numSummedWaves = numWaves;
+        _numSummedDimensions = numDimensions;
+        _waveSumsData = &dataMatrix;
+        _waveSumsVersion = floodFill.getVersion();
+    }
+
+    void HDFloodPeakFilter::updateWaveSums(const FloodWorkingSet& workingSet)
+    {
+        // Dimensions summed per thread, rows of the working set are contiguous so each block is a short linear read
+        constexpr int DIMENSION_BLOCK_SIZE = 64;
+
+        int numDimensions = workingSet.getNumDimensions();
+        int numWaves = workingSet.getNumWaves();
+
+        _numActiveWaves = numWaves;
+
+        if (_waveSumsVersion == workingSet.getFloodVersion() && _waveSumsData == workingSet.getData() && _numSummedDimensions == numDimensions && numWaves <= _numSummedWaves)
+            return;
+
+        const std::vector<int>& waveOffsets = workingSet.getWaveOffsets();
+
+        _waveCounts.assign(waveOffsets.begin(), waveOffsets.end());
+        _waveSums.assign((size_t) (numWaves + 1) * numDimensions, 0);
+
+        int numBlocks = (numDimensions + DIMENSION_BLOCK_SIZE - 1) / DIMENSION_BLOCK_SIZE;
+
+        tasks::parallelFor(0, numBlocks, [&](int b)
         {
-            farIndices.insert(farIndices.end(), floodFill.getWaves()[wave].begin(), floodFill.getWaves()[wave].end());
-        }
+            int blockStart = b * DIMENSION_BLOCK_SIZE;
+            int blockSize = std::min(DIMENSION_BLOCK_SIZE, numDimensions - blockStart);
+
+            double sums[DIMENSION_BLOCK_SIZE] = { 0 };
+            for (int w = 0; w < numWaves; w++)
+            {
+                for (int i = waveOffsets[w]; i < waveOffsets[w + 1]; i++)
+                {
+                    const float* values = workingSet.getValues(i) + blockStart;
+                    for (int d = 0; d < blockSize; d++)
+                        sums[d] += values[d];
+                }
+
+                double* prefix = _waveSums.data() + (size_t) (w + 1) * numDimensions + blockStart;
+                for (int d = 0; d < blockSize; d++)
+                    prefix[d] = sums[d];
+            }
+        });
+
+        _numSummedWaves = numWaves;
+        _numSummedDimensions = numDimensions;
+        _waveSumsData = workingSet.getData();
+        _waveSumsVersion = workingSet.getFloodVersion();
+    }
 
-        std::vector<float> nearAverages;
-        std::vector<float> farAverages;
+    void HDFloodPeakFilter::computeSplitScores(int innerFilterSize, const std::vector<float>& variances, std::vector<float>& scores) const
+    {
+        int numDimensions = _numSummedDimensions;
 
-        computeDimensionAverage(dataMatrix, nearIndices, nearAverages);
-        computeDimensionAverage(dataMatrix, farIndices, farAverages);
+        // Near waves are [0, inner), far waves are [inner, last) where the last wave is left out
+        int lastWave = std::max(std::min(_numActiveWaves, _numSummedWaves) - 1, 0);
+        int innerWave = std::min(std::max(innerFilterSize, 0), lastWave);
 
-        std::vector<float> diffAverages(numDimensions);
+        int numNear = _waveCounts.empty() ? 0 : _waveCounts[innerWave];
+        int numFar = _waveCounts.empty() ? 0 : _waveCounts[lastWave] - _waveCounts[innerWave];
+
+        const double* prefixZero = _waveSums.data();
+        const double* prefixInner = _waveSums.data() + (size_t) innerWave * numDimensions;
+        const double* prefixLast = _waveSums.data() + (size_t) lastWave * numDimensions;
+
+        double invNear = numNear > 0 ? 1.0 / numNear : 0;
+        double invFar = numFar > 0 ? 1.0 / numFar : 0;
+
+        scores.resize(numDimensions);
         for (int d = 0; d < numDimensions; d++)
         {
-            diffAverages[d] = 0;
+            scores[d] = 0;
             if (variances[d] > 0)
-                diffAverages[d] = (nearAverages[d] - farAverages[d]);// / variances[d];
+            {
+                double nearAverage = (prefixInner[d] - prefixZero[d]) * invNear;
+                double farAverage = (prefixLast[d] - prefixInner[d]) * invFar;
+                scores[d] = (float) (nearAverage - farAverage);// / variances[d];
+            }
         }
-
-        // Sort averages from high to low
-        dimRanking.resize(numDimensions);
-        std::iota(dimRanking.begin(), dimRanking.end(), 0);
-
-        std::stable_sort(dimRanking.begin(), dimRanking.end(), [&diffAverages](size_t i1, size_t i2) {return diffAverages[i1] > diffAverages[i2]; });
     }
 
 }
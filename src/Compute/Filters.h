@@ -1,14 +1,13 @@
 #pragma once
 
 #include "DataMatrix.h"
+#include "DimensionRanking.h"
 
+#include <cstdint>
 #include <vector>
-#include <QString>
-
-void writeFloodNodes(const std::vector<std::vector<int>>& floodNodes);
-void writeDimensionRanking(const std::vector<std::vector<int>>& ranking, const std::vector<QString>& names);
 
 class FloodFill;
+class FloodWorkingSet;
 
 namespace filters
 {
@@ -31,9 +30,15 @@ namespace filters
         void computeDimensionRanking(int pointId, const DataMatrix& dataMatrix, const std::vector<float>& variances, const DataMatrix& projMatrix, float projSize, std::vector<int>& dimRanking);
         void computeDimensionRanking(int pointId, const DataMatrix& dataMatrix, const std::vector<float>& variances, const DataMatrix& projMatrix, float projSize, std::vector<int>& dimRanking, const std::vector<int>& mask);
 
+        /** Number of dimensions to rank, FULL_RANKING orders all of them */
+        void setTopK(int topK) { _ranker.setTopK(topK); }
+        DimensionRanker& getRanker() { return _ranker; }
+
     private:
         float _innerFilterRadius;
         float _outerFilterRadius;
+
+        DimensionRanker _ranker;
     };
 
     class HDFloodPeakFilter
@@ -44,8 +49,43 @@ namespace filters
         void setInnerFilterSize(int size);
         //void setOuterFilterSize(int size);
 
+        int getInnerFilterSize() const { return _innerFilterSize; }
+
         void computeDimensionRanking(int pointId, const DataMatrix& dataMatrix, const std::vector<float>& variances, const FloodFill& floodFill, std::vector<int>& dimRanking);
+        void computeDimensionRanking(const FloodWorkingSet& workingSet, const std::vector<float>& variances, std::vector<int>& dimRanking);
+
+        /**
+         * Build the per-wave prefix sums of the given flood, does nothing if they are up-to-date.
+         * After this any near/far split can be scored with computeSplitScores without touching the data.
+         */
+        void updateWaveSums(const DataMatrix& dataMatrix, const FloodFill& floodFill);
+        void updateWaveSums(const FloodWorkingSet& workingSet);
+
+        /**
+         * Score dimensions on the difference between the average of the first innerFilterSize waves
+         * and the remaining waves (excluding the last one), using the prefix sums of the last flood.
+         */
+        void computeSplitScores(int innerFilterSize, const std::vector<float>& variances, std::vector<float>& scores) const;
+
+        /** Force the prefix sums to be rebuilt, e.g. when the data matrix has changed in place */
+        void invalidateWaveSums() { _waveSumsData = nullptr; }
+
+        /** Number of dimensions to rank, FULL_RANKING orders all of them */
+        void setTopK(int topK) { _ranker.setTopK(topK); }
+        DimensionRanker& getRanker() { return _ranker; }
+
     private:
         int _innerFilterSize;
+
+        DimensionRanker _ranker;
+
+        // Prefix sums over flood waves, row w holds the per-dimension sums of waves [0, w)
+        std::vector<double>     _waveSums;
+        std::vector<int>        _waveCounts;
+        int                     _numSummedWaves = 0;
+        int                     _numActiveWaves = 0;
+        int                     _numSummedDimensions = 0;
+        const DataMatrix*       _waveSumsData = nullptr;
+        std::uint64_t           _waveSumsVersion = 0;
     };
 }
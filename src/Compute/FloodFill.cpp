@@ -1,7 +1,19 @@
 #include "FloodFill.h"
 
+#include "MonotonicArena.h"
+
+#include <atomic>
+#include <cstring>
+
+namespace
+{
+    // Versions are unique across flood fill instances so cached results can't be mixed up
+    std::atomic<std::uint64_t> floodVersionCounter(0);
+}
+
 FloodFill::FloodFill(int numWaves) :
     _numWaves(numWaves),
+    _version(0),
     _lastKnnGraph(nullptr),
     _lastSelectedPoint(0),
     _lastNumWaves(numWaves)
@@ -15,64 +27,55 @@ void FloodFill::setNumWaves(int numWaves)
     recompute();
 }
 
-void FloodFill::compute(const KnnGraph& knnGraph, nint selectedPoint)
+void FloodFill::compute(const KnnGraph& knnGraph, nint selectedPoint, MonotonicArena* arena)
 {
-    int numNeighbours = knnGraph.getNumNeighbours();
     auto& neighbours = knnGraph.getNeighbours();
     nint numPoints = neighbours.size();
 
-    _waves.clear();
+    // Waves are cleared rather than destroyed so their capacity carries over to the next flood
     _waves.resize(_numWaves);
+    for (std::vector<nint>& wave : _waves)
+        wave.clear();
+
+    // One bit per node that has been visited during the process
+    size_t numVisitedWords = ((size_t) numPoints + 63) / 64;
+    std::vector<std::uint64_t> localVisited;
+    std::uint64_t* visitedNodes = nullptr;
+    if (arena != nullptr)
+        visitedNodes = arena->allocate<std::uint64_t>(numVisitedWords);
+    else
+    {
+        localVisited.resize(numVisitedWords);
+        visitedNodes = localVisited.data();
+    }
+    std::memset(visitedNodes, 0, numVisitedWords * sizeof(std::uint64_t));
 
-    // Set list of nodes to process next, skipping iteration 0 where we just process the seed node
-    std::vector<nint> currentNodes = neighbours[selectedPoint];
-
-    // List of nodes that become the new current nodes
-    std::vector<nint> newNodes;
-
-    // List of nodes that have been visited during the process
-    std::vector<bool> visitedNodes(numPoints, false);
-
-    // Set the seed node as having been visited as we skip iteration 0
-    visitedNodes[selectedPoint] = true;
+    const auto visit = [visitedNodes](nint node)
+    {
+        std::uint64_t bit = std::uint64_t(1) << (node & 63);
+        std::uint64_t& word = visitedNodes[node >> 6];
+        bool visited = (word & bit) != 0;
+        word |= bit;
+        return !visited;
+    };
+
+    // Wave 0 is just the seed node
+    visit(selectedPoint);
     _waves[0].push_back(selectedPoint);
 
-    // Start flooding in N waves, skipping iteration 0 where we would just process the seed node
+    // Every next wave holds the neighbours of the previous wave that hadn't been visited yet, in order
+    // of the previous wave and then of the neighbours, so the previous wave is the only frontier needed
     for (int w = 1; w < _numWaves; w++)
     {
-        // Reserve the maximum possible nodes that can be added in advance to save on resizing costs
-        _waves[w].reserve(currentNodes.size());
-
-        // Process list of current nodes, if they hadn't been visited yet, add them to the flood fill,
-        // otherwise skip further processing.
-        for (nint& currentNode : currentNodes)
+        std::vector<nint>& wave = _waves[w];
+        for (const nint& node : _waves[w - 1])
         {
-            if (!visitedNodes[currentNode])
+            for (const nint& neighbour : neighbours[node])
             {
-                visitedNodes[currentNode] = true;
-                _waves[w].push_back(currentNode);
+                if (visit(neighbour))
+                    wave.push_back(neighbour);
             }
-            // Node was visited before, stop further processing
-            else
-                currentNode = -1;
-        }
-        
-        if (w == _numWaves - 1)
-            continue;
-
-        // Add neighbours of just visited current nodes to new nodes
-        newNodes.clear();
-        newNodes.reserve(currentNodes.size() * numNeighbours);
-        for (const nint& node : currentNodes)
-        {
-            // Node was visited before, skip adding neighbours
-            if (node == -1) continue;
-
-            newNodes.insert(newNodes.end(), neighbours[node].begin(), neighbours[node].end());
         }
-
-        // New nodes become the current indices
-        currentNodes = newNodes;
     }
 
     // Compute flat vector of all nodes
@@ -80,6 +83,8 @@ void FloodFill::compute(const KnnGraph& knnGraph, nint selectedPoint)
     for (int w = 0; w < getNumWaves(); w++)
         _allNodes.insert(_allNodes.end(), _waves[w].begin(), _waves[w].end());
 
+    _version = ++floodVersionCounter;
+
     // Store input parameters for potential recomputation
     _lastKnnGraph = &knnGraph;
     _lastSelectedPoint = selectedPoint;
@@ -90,9 +95,16 @@ void FloodFill::recompute()
 {
     if (_numWaves == _lastNumWaves) return;
 
+    // Fewer waves are a prefix of the current flood, so the version stays the same
     if (_numWaves < _lastNumWaves)
     {
         _waves.resize(_numWaves);
+
+        _allNodes.clear();
+        for (int w = 0; w < getNumWaves(); w++)
+            _allNodes.insert(_allNodes.end(), _waves[w].begin(), _waves[w].end());
+
+        _lastNumWaves = _numWaves;
         return;
     }
 
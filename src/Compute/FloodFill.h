@@ -3,19 +3,34 @@
 #include "KnnGraph.h"
 #include "Types.h"
 
+#include <cstdint>
 #include <vector>
 
+class MonotonicArena;
+
 class FloodFill
 {
 public:
     FloodFill(int numWaves);
 
-    void compute(const KnnGraph& knnGraph, nint selectedPoint);
+    /**
+     * Flood the graph from the selected point. The waves keep their capacity between floods,
+     * so repeated floods of similar size don't allocate.
+     * @param arena Scratch memory for the visited nodes, allocated per flood if nullptr
+     */
+    void compute(const KnnGraph& knnGraph, nint selectedPoint, MonotonicArena* arena = nullptr);
     void recompute();
 
     void setNumWaves(int numWaves);
 
     int getNumWaves() const { return (int) _waves.size(); }
+
+    /** Number of waves the next flood is computed with */
+    int getTargetNumWaves() const { return _numWaves; }
+
+    /** Unique id of the last flood computation, changes whenever the flood nodes are recomputed */
+    std::uint64_t getVersion() const { return _version; }
+
     bigint getTotalNumNodes() const { return (bigint) _allNodes.size(); }
 
     std::vector<std::vector<nint>>& getWaves() { return _waves; }
@@ -29,6 +44,8 @@ private:
 
     std::vector<nint> _allNodes;
 
+    std::uint64_t _version;
+
     // Store knn graph for recomputation
     const KnnGraph* _lastKnnGraph;
     nint _lastSelectedPoint;
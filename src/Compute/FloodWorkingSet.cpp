@@ -0,0 +1,52 @@
+#include "FloodWorkingSet.h"
+
+#include "FloodFill.h"
+#include "TaskScheduler.h"
+
+FloodWorkingSet::FloodWorkingSet() :
+    _waveOffsets(1, 0),
+    _numDimensions(0),
+    _floodVersion(0),
+    _data(nullptr)
+{
+
+}
+
+void FloodWorkingSet::gather(const FloodFill& floodFill, const DataMatrix& dataMatrix, const std::vector<std::vector<float>>& normalizedData)
+{
+    int numDimensions = (int) dataMatrix.cols();
+    const auto& waves = floodFill.getWaves();
+
+    // A shrunk flood keeps its version, so the node count has to be compared as well
+    if (_data == &dataMatrix && _floodVersion == floodFill.getVersion() && _numDimensions == numDimensions && getNumNodes() == floodFill.getTotalNumNodes())
+        return;
+
+    _nodes = floodFill.getAllNodes();
+
+    _waveOffsets.resize(waves.size() + 1);
+    _waveOffsets[0] = 0;
+    for (size_t w = 0; w < waves.size(); w++)
+        _waveOffsets[w + 1] = _waveOffsets[w] + (int) waves[w].size();
+
+    int numNodes = getNumNodes();
+    _numDimensions = numDimensions;
+    _values.resize((size_t) numNodes * numDimensions);
+    _levels.resize((size_t) numNodes * numDimensions);
+
+    tasks::parallelFor(0, numNodes, [&](int i)
+    {
+        nint node = _nodes[i];
+        float* values = _values.data() + (size_t) i * numDimensions;
+        std::uint8_t* levels = _levels.data() + (size_t) i * numDimensions;
+
+        for (int d = 0; d < numDimensions; d++)
+        {
+            values[d] = dataMatrix(node, d);
+            // Normalized values are below 1, so the level stays below NUM_LEVELS
+            levels[d] = toLevel(normalizedData[d][node]);
+        }
+    });
+
+    _floodVersion = floodFill.getVersion();
+    _data = &dataMatrix;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "DataMatrix.h"
+#include "Types.h"
+
+#include <cstdint>
+#include <vector>
+
+class FloodFill;
+
+/**
+ * Data of the flood nodes of a single selection.
+ *
+ * The rows of the flood nodes are gathered once into a contiguous node-major block, both as
+ * floats from the data matrix and as normalized values quantized to NUM_LEVELS levels. Ranking,
+ * colouring and histograms then read this block instead of each gathering from the full data.
+ * Nodes are stored in flood order, so the nodes of a wave form a contiguous range.
+ */
+class FloodWorkingSet
+{
+public:
+    /** Quantization levels of the normalized values, matches the resolution of the color maps */
+    static constexpr int NUM_LEVELS = 256;
+
+    FloodWorkingSet();
+
+    /** Quantization level of a normalized value in [0, 1) */
+    static std::uint8_t toLevel(float normalizedValue) { return (std::uint8_t) (normalizedValue * NUM_LEVELS); }
+
+    /**
+     * Gather the data of the flood nodes, does nothing if the flood and data haven't changed.
+     * @param normalizedData Per-dimension values of the data matrix normalized to [0, 1)
+     */
+    void gather(const FloodFill& floodFill, const DataMatrix& dataMatrix, const std::vector<std::vector<float>>& normalizedData);
+
+    /** Force the next gather, e.g. when the data has changed in place */
+    void invalidate() { _data = nullptr; }
+
+    int getNumNodes() const { return (int) _nodes.size(); }
+    int getNumDimensions() const { return _numDimensions; }
+    int getNumWaves() const { return (int) _waveOffsets.size() - 1; }
+
+    /** Node indices in flood order */
+    const std::vector<nint>& getNodes() const { return _nodes; }
+
+    /** Range of node positions of each wave, numWaves + 1 entries */
+    const std::vector<int>& getWaveOffsets() const { return _waveOffsets; }
+
+    /** Data row of the i-th flood node */
+    const float* getValues(int i) const { return _values.data() + (size_t) i * _numDimensions; }
+
+    /** Quantized normalized row of the i-th flood node */
+    const std::uint8_t* getLevels(int i) const { return _levels.data() + (size_t) i * _numDimensions; }
+
+    /** Normalized value of the i-th flood node, at the center of its quantization level */
+    float getNormalizedValue(int i, int d) const { return (getLevels(i)[d] + 0.5f) * (1.0f / NUM_LEVELS); }
+
+    /** Version of the flood and data matrix the working set was gathered from */
+    std::uint64_t getFloodVersion() const { return _floodVersion; }
+    const DataMatrix* getData() const { return _data; }
+
+private:
+    std::vector<nint>           _nodes;
+    std::vector<int>            _waveOffsets;
+    std::vector<float>          _values;
+    std::vector<std::uint8_t>   _levels;
+    int                         _numDimensions;
+
+    std::uint64_t               _floodVersion;
+    const DataMatrix*           _data;
+};
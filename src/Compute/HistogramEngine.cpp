@@ -0,0 +1,168 @@
+#include "HistogramEngine.h"
+
+#include "FloodWorkingSet.h"
+#include "MonotonicArena.h"
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+    // Blocks of 256 nodes x 64 dimensions of levels fit in L1 together with the bins of the dimensions
+    constexpr int NODE_BLOCK_SIZE = 256;
+    constexpr int DIMENSION_BLOCK_SIZE = 64;
+
+    // Floods with fewer changed nodes than this fraction are updated incrementally
+    constexpr float MAX_INCREMENTAL_FRACTION = 0.5f;
+}
+
+HistogramEngine::HistogramEngine() :
+    _numBins(0),
+    _numDimensions(0)
+{
+    setNumBins(30);
+}
+
+void HistogramEngine::setNumBins(int numBins)
+{
+    numBins = std::max(1, std::min(numBins, FloodWorkingSet::NUM_LEVELS));
+
+    if (numBins == _numBins)
+        return;
+
+    _numBins = numBins;
+
+    _levelToBin.resize(FloodWorkingSet::NUM_LEVELS);
+    for (int level = 0; level < FloodWorkingSet::NUM_LEVELS; level++)
+        _levelToBin[level] = (std::uint8_t) (level * numBins / FloodWorkingSet::NUM_LEVELS);
+
+    reset();
+}
+
+void HistogramEngine::reset()
+{
+    _numDimensions = 0;
+    _counts.clear();
+    _countedNodes.clear();
+}
+
+void HistogramEngine::compute(const FloodWorkingSet& workingSet, const std::vector<std::vector<float>>& normalizedData, MonotonicArena* arena)
+{
+    const std::vector<nint>& nodes = workingSet.getNodes();
+
+    _sortedNodes.assign(nodes.begin(), nodes.end());
+    std::sort(_sortedNodes.begin(), _sortedNodes.end());
+
+    if (_numDimensions == workingSet.getNumDimensions() && !_counts.empty())
+    {
+        _addedNodes.clear();
+        _removedNodes.clear();
+        std::set_difference(_sortedNodes.begin(), _sortedNodes.end(), _countedNodes.begin(), _countedNodes.end(), std::back_inserter(_addedNodes));
+        std::set_difference(_countedNodes.begin(), _countedNodes.end(), _sortedNodes.begin(), _sortedNodes.end(), std::back_inserter(_removedNodes));
+
+        size_t numChanged = _addedNodes.size() + _removedNodes.size();
+        if (numChanged < MAX_INCREMENTAL_FRACTION * _sortedNodes.size())
+        {
+            updateCounts(_removedNodes, normalizedData, -1);
+            updateCounts(_addedNodes, normalizedData, 1);
+
+            _countedNodes.swap(_sortedNodes);
+            return;
+        }
+    }
+
+    computeFull(workingSet, arena);
+    _countedNodes.swap(_sortedNodes);
+}
+
+void HistogramEngine::computeFull(const FloodWorkingSet& workingSet, MonotonicArena* arena)
+{
+    int numDimensions = workingSet.getNumDimensions();
+    int numNodes = workingSet.getNumNodes();
+    int numBins = _numBins;
+    const std::uint8_t* levelToBin = _levelToBin.data();
+
+    _numDimensions = numDimensions;
+    _counts.assign((size_t) numDimensions * numBins, 0);
+
+    int numNodeBlocks = (numNodes + NODE_BLOCK_SIZE - 1) / NODE_BLOCK_SIZE;
+
+    // Private bins per slot, so threads never write to the same counters
+    int numSlots = tasks::getNumSlots();
+    size_t numCounts = (size_t) numDimensions * numBins;
+    std::vector<int> localScratch;
+    int* scratch = nullptr;
+    if (arena != nullptr)
+        scratch = arena->allocate<int>(numCounts * numSlots);
+    else
+    {
+        localScratch.resize(numCounts * numSlots);
+        scratch = localScratch.data();
+    }
+
+    // Bins are cleared by the first chunk of their slot, slots that get no chunk are skipped when merging
+    bool slotUsed[tasks::Scheduler::MAX_SLOTS] = {};
+
+    tasks::parallelForRanges(0, numNodeBlocks, 1, [&](int blockBegin, int blockEnd, int slot)
+    {
+        int* const localCounts = scratch + slot * numCounts;
+        if (!slotUsed[slot])
+        {
+            std::fill(localCounts, localCounts + numCounts, 0);
+            slotUsed[slot] = true;
+        }
+
+        for (int nb = blockBegin; nb < blockEnd; nb++)
+        {
+            int nodeStart = nb * NODE_BLOCK_SIZE;
+            int nodeEnd = std::min(nodeStart + NODE_BLOCK_SIZE, numNodes);
+
+            for (int dimStart = 0; dimStart < numDimensions; dimStart += DIMENSION_BLOCK_SIZE)
+            {
+                int dimEnd = std::min(dimStart + DIMENSION_BLOCK_SIZE, numDimensions);
+
+                for (int i = nodeStart; i < nodeEnd; i++)
+                {
+                    const std::uint8_t* levels = workingSet.getLevels(i);
+
+                    // Every dimension has its own bins, so the increments of one row never conflict
+                    for (int d = dimStart; d < dimEnd; d++)
+                        localCounts[(size_t) d * numBins + levelToBin[levels[d]]]++;
+                }
+            }
+        }
+    });
+
+    for (int slot = 0; slot < numSlots; slot++)
+    {
+        if (!slotUsed[slot])
+            continue;
+
+        const int* localCounts = scratch + slot * numCounts;
+        for (size_t c = 0; c < numCounts; c++)
+            _counts[c] += localCounts[c];
+    }
+}
+
+void HistogramEngine::updateCounts(const std::vector<nint>& nodes, const std::vector<std::vector<float>>& normalizedData, int delta)
+{
+    int numDimensions = _numDimensions;
+    int numBins = _numBins;
+
+    tasks::parallelFor(0, numDimensions, [&](int d)
+    {
+        int* const counts = _counts.data() + (size_t) d * numBins;
+        const float* const values = normalizedData[d].data();
+
+        for (const nint& node : nodes)
+            counts[_levelToBin[FloodWorkingSet::toLevel(values[node])]] += delta;
+    });
+}
+
+void HistogramEngine::copyTo(std::vector<std::vector<int>>& bins) const
+{
+    bins.resize(_numDimensions);
+    for (int d = 0; d < _numDimensions; d++)
+        bins[d].assign(_counts.begin() + (size_t) d * _numBins, _counts.begin() + (size_t) (d + 1) * _numBins);
+}
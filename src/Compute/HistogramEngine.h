@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Types.h"
+
+#include <cstdint>
+#include <vector>
+
+class FloodWorkingSet;
+class MonotonicArena;
+
+/**
+ * Per-dimension histograms of the normalized values of the flood nodes.
+ *
+ * Bins are looked up from the quantization levels of a FloodWorkingSet through a table, so no
+ * floating point work is done per value. The full computation walks blocks of nodes and blocks of
+ * dimensions with private bins per thread. When the flood changes only slightly, the counts of the
+ * previous flood are updated by removing and adding the nodes that differ.
+ */
+class HistogramEngine
+{
+public:
+    HistogramEngine();
+
+    void setNumBins(int numBins);
+    int getNumBins() const { return _numBins; }
+
+    /**
+     * Compute the histograms of the flood nodes in the working set
+     * @param normalizedData Normalized data the working set was gathered from, used to look up nodes that left the flood
+     * @param arena Scratch memory for the bins of the threads, allocated per computation if nullptr
+     */
+    void compute(const FloodWorkingSet& workingSet, const std::vector<std::vector<float>>& normalizedData, MonotonicArena* arena = nullptr);
+
+    /** Forget the counted nodes, required when the normalized data changes */
+    void reset();
+
+    int getNumDimensions() const { return _numDimensions; }
+
+    /** Counts of numDimensions x numBins, row-major */
+    const std::vector<int>& getCounts() const { return _counts; }
+
+    void copyTo(std::vector<std::vector<int>>& bins) const;
+
+private:
+    void computeFull(const FloodWorkingSet& workingSet, MonotonicArena* arena);
+    void updateCounts(const std::vector<nint>& nodes, const std::vector<std::vector<float>>& normalizedData, int delta);
+
+private:
+    int                         _numBins;
+    int                         _numDimensions;
+    std::vector<std::uint8_t>   _levelToBin;
+    std::vector<int>            _counts;
+
+    // Sorted nodes the counts were computed from, and scratch buffers for the difference with a new flood
+    std::vector<nint>           _countedNodes;
+    std::vector<nint>           _sortedNodes;
+    std::vector<nint>           _addedNodes;
+    std::vector<nint>           _removedNodes;
+};
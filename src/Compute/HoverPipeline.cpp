@@ -0,0 +1,238 @@
+#include "HoverPipeline.h"
+
+#include "KnnGraph.h"
+#include "RankingAtlas.h"
+
+#include <algorithm>
+#include <limits>
+
+void HoverColors::clear()
+{
+    indices.clear();
+    scalars.clear();
+    background = 0;
+}
+
+FloodKey HoverPipeline::makeFloodKey(const HoverSettings& settings, nint seedPoint)
+{
+    FloodKey key;
+    key.seedPoint = seedPoint;
+    key.graphVersion = settings.inputVersions.graph;
+    key.maskVersion = settings.inputVersions.mask;
+    key.numWaves = settings.numWaves;
+    return key;
+}
+
+RankingKey HoverPipeline::makeRankingKey(const HoverSettings& settings, const FloodKey& floodKey, nint selectedPoint)
+{
+    RankingKey key;
+    key.flood = floodKey;
+    key.selectedPoint = selectedPoint;
+    key.dataVersion = settings.inputVersions.data;
+    key.filterType = settings.filterType;
+    key.restrictToFlood = settings.restrictToFlood;
+    key.numRankedDimensions = settings.numRankedDimensions;
+    key.innerFilterRadius = settings.innerFilterRadius;
+    key.outerFilterRadius = settings.outerFilterRadius;
+    key.hdInnerFilterSize = settings.hdInnerFilterSize;
+    key.projectionSize = settings.projectionSize;
+    return key;
+}
+
+HistogramKey HoverPipeline::makeHistogramKey(const HoverSettings& settings, const FloodKey& floodKey)
+{
+    HistogramKey key;
+    key.flood = floodKey;
+    key.dataVersion = settings.inputVersions.data;
+    key.numBins = settings.numGraphBins;
+    return key;
+}
+
+FloodKey HoverPipeline::updateFlood(const HoverSettings& settings, const HoverInputs& inputs, nint seedPoint, SelectionCache* cache)
+{
+    cache = getCache(settings, cache);
+    _scratch.reset();
+
+    FloodKey floodKey = makeFloodKey(settings, seedPoint);
+    const FloodFill* cachedFlood = cache != nullptr ? cache->findFlood(floodKey) : nullptr;
+    if (cachedFlood != nullptr)
+    {
+        _floodFill = *cachedFlood;
+        _workingSet.gather(_floodFill, *inputs.baseData, *inputs.normalizedData);
+    }
+    else
+    {
+        computeFlood(settings, inputs, seedPoint, _floodFill, _workingSet);
+        if (cache != nullptr)
+            cache->insertFlood(floodKey, _floodFill, false);
+    }
+    return floodKey;
+}
+
+void HoverPipeline::updateRanking(const HoverSettings& settings, const HoverInputs& inputs, const FloodKey& floodKey, nint selectedPoint, SelectionCache* cache)
+{
+    // The atlas holds the ranking of every point for its settings, so it answers before the cache
+    const RankingAtlas* atlas = inputs.rankingAtlas;
+    if (atlas != nullptr && selectedPoint < atlas->getNumPoints() && atlas->matches(settings))
+    {
+        atlas->getRanking(selectedPoint, settings.numRankedDimensions, _dimRanking);
+        return;
+    }
+
+    cache = getCache(settings, cache);
+
+    RankingKey rankingKey = makeRankingKey(settings, floodKey, selectedPoint);
+    const std::vector<int>* cachedRanking = cache != nullptr ? cache->findRanking(rankingKey) : nullptr;
+    if (cachedRanking != nullptr)
+        _dimRanking = *cachedRanking;
+    else
+    {
+        computeRanking(settings, inputs, selectedPoint, _floodFill, _workingSet, _dimRanking);
+        if (cache != nullptr)
+            cache->insertRanking(rankingKey, _dimRanking);
+    }
+}
+
+void HoverPipeline::computeColors(const HoverSettings& settings, const HoverInputs& inputs, HoverColors& colors) const
+{
+    // Only flooded points are colored, the rest of the points keep the background value
+    colors.clear();
+
+    if (settings.graphAvailable)
+    {
+        switch (settings.overlayType)
+        {
+        case OverlayType::NONE:
+        {
+            for (int i = 0; i < _floodFill.getNumWaves(); i++)
+            {
+                for (int j = 0; j < (int) _floodFill.getWaves()[i].size(); j++)
+                {
+                    colors.indices.push_back(inputs.toOutputPoint(_floodFill.getWaves()[i][j]));
+                    colors.scalars.push_back(1 - (1.0f / _floodFill.getNumWaves()) * i);
+                }
+            }
+            break;
+        }
+        case OverlayType::DIM_VALUES:
+        {
+            for (int i = 0; i < _workingSet.getNumNodes(); i++)
+            {
+                colors.indices.push_back(inputs.toOutputPoint(_workingSet.getNodes()[i]));
+                colors.scalars.push_back(_workingSet.getNormalizedValue(i, _dimRanking[0]));
+            }
+            break;
+        }
+        case OverlayType::LOCAL_DIMENSIONALITY:
+        {
+            if (inputs.localHighDimensionality->empty()) break;
+
+            for (int i = 0; i < _floodFill.getTotalNumNodes(); i++)
+            {
+                int node = _floodFill.getAllNodes()[i];
+                colors.indices.push_back(inputs.toOutputPoint(node));
+                colors.scalars.push_back((*inputs.localHighDimensionality)[node]);
+            }
+            break;
+        }
+        case OverlayType::DIRECTIONS:
+            break;
+        }
+    }
+
+    // Normalize as if the background points were part of the scalars, so the full vector never has to be built
+    bool hasBackground = (int) colors.indices.size() < settings.numOutputPoints;
+    float scalarMin = hasBackground ? 0 : std::numeric_limits<float>::max();
+    float scalarMax = hasBackground ? 0 : -std::numeric_limits<float>::max();
+    for (const float& scalar : colors.scalars)
+    {
+        scalarMin = std::min(scalarMin, scalar);
+        scalarMax = std::max(scalarMax, scalar);
+    }
+    float scalarRange = scalarMax - scalarMin;
+
+    if (!colors.scalars.empty() && scalarRange != 0)
+    {
+        float invScalarRange = 1.0f / scalarRange;
+        for (float& scalar : colors.scalars)
+            scalar = (scalar - scalarMin) * invScalarRange;
+        colors.background = -scalarMin * invScalarRange;
+    }
+}
+
+void HoverPipeline::updateHistograms(const HoverSettings& settings, const HoverInputs& inputs, const FloodKey& floodKey, SelectionCache* cache, std::vector<std::vector<int>>& bins)
+{
+    cache = getCache(settings, cache);
+
+    HistogramKey histogramKey = makeHistogramKey(settings, floodKey);
+    const std::vector<std::vector<int>>* cachedBins = cache != nullptr ? cache->findHistograms(histogramKey) : nullptr;
+    if (cachedBins != nullptr)
+        bins = *cachedBins;
+    else
+    {
+        _histograms.setNumBins(settings.numGraphBins);
+        _histograms.compute(_workingSet, *inputs.normalizedData, &_scratch);
+        _histograms.copyTo(bins);
+        if (cache != nullptr)
+            cache->insertHistograms(histogramKey, bins);
+    }
+}
+
+void HoverPipeline::computeFlood(const HoverSettings& settings, const HoverInputs& inputs, nint seedPoint, FloodFill& floodFill, FloodWorkingSet& workingSet)
+{
+    _scratch.reset();
+
+    if (floodFill.getTargetNumWaves() != settings.numWaves)
+        floodFill = FloodFill(settings.numWaves);
+
+    if (settings.graphAvailable)
+        floodFill.compute(*inputs.knnGraph, seedPoint, &_scratch);
+
+    // Gather the flood nodes once for the ranking, colouring and histograms
+    workingSet.gather(floodFill, *inputs.baseData, *inputs.normalizedData);
+}
+
+const std::vector<float>& HoverPipeline::getRankingScores(filters::FilterType filterType)
+{
+    return filterType == filters::FilterType::HD_PEAK ? _hdFloodPeakFilter.getRanker().getScores() : _spatialPeakFilter.getRanker().getScores();
+}
+
+void HoverPipeline::computeRanking(const HoverSettings& settings, const HoverInputs& inputs, nint selectedPoint, const FloodFill& floodFill, const FloodWorkingSet& workingSet, std::vector<int>& dimRanking)
+{
+    switch (settings.filterType)
+    {
+    case filters::FilterType::SPATIAL_PEAK:
+    {
+        _spatialPeakFilter.setInnerFilterRadius(settings.innerFilterRadius);
+        _spatialPeakFilter.setOuterFilterRadius(settings.outerFilterRadius);
+        _spatialPeakFilter.setTopK(settings.numRankedDimensions);
+
+        if (settings.restrictToFlood)
+            _spatialPeakFilter.computeDimensionRanking(selectedPoint, *inputs.data, *inputs.variances, *inputs.projection, settings.projectionSize, dimRanking, floodFill.getAllNodes());
+        else
+            _spatialPeakFilter.computeDimensionRanking(selectedPoint, *inputs.data, *inputs.variances, *inputs.projection, settings.projectionSize, dimRanking);
+        break;
+    }
+    case filters::FilterType::HD_PEAK:
+    {
+        _hdFloodPeakFilter.setInnerFilterSize(settings.hdInnerFilterSize);
+        _hdFloodPeakFilter.setTopK(settings.numRankedDimensions);
+
+        _hdFloodPeakFilter.computeDimensionRanking(workingSet, *inputs.variances, dimRanking);
+        break;
+    }
+    }
+}
+
+void HoverPipeline::copyDimensionValues(const DataMatrix& data, dint dimension, std::vector<float>& values)
+{
+    const auto dimValues = data(Eigen::all, dimension);
+    values.assign(dimValues.data(), dimValues.data() + dimValues.size());
+}
+
+void HoverPipeline::invalidateData()
+{
+    _hdFloodPeakFilter.invalidateWaveSums();
+    _workingSet.invalidate();
+    _histograms.reset();
+}
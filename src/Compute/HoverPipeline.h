@@ -0,0 +1,132 @@
+#pragma once
+
+#include "DataMatrix.h"
+#include "Types.h"
+#include "FloodFill.h"
+#include "FloodWorkingSet.h"
+#include "Filters.h"
+#include "HistogramEngine.h"
+#include "MonotonicArena.h"
+#include "SelectionCache.h"
+
+#include <vector>
+
+class KnnGraph;
+class RankingAtlas;
+
+enum class OverlayType
+{
+    NONE,
+    DIM_VALUES,
+    LOCAL_DIMENSIONALITY,
+    DIRECTIONS
+};
+
+/** Settings of the hover pipeline that don't depend on the selected point */
+struct HoverSettings
+{
+    filters::FilterType     filterType = filters::FilterType::SPATIAL_PEAK;
+    OverlayType             overlayType = OverlayType::NONE;
+    bool                    restrictToFlood = false;
+    bool                    graphAvailable = true;
+    int                     numWaves = 10;
+    int                     numRankedDimensions = 2;
+    float                   innerFilterRadius = 0;
+    float                   outerFilterRadius = 0;
+    int                     hdInnerFilterSize = 0;
+    float                   projectionSize = 0;
+    int                     numOutputPoints = 0;        /** Number of colored output points, including the background */
+    int                     numGraphBins = 30;
+    SelectionInputVersions  inputVersions;              /** Versions of the inputs below, part of the cache keys */
+};
+
+/** Data the hover pipeline reads, owned by the caller and not changed while a selection is computed */
+struct HoverInputs
+{
+    const DataMatrix*                       data = nullptr;         /** Data view, or masked data when a mask is applied */
+    const DataMatrix*                       projection = nullptr;   /** Projection of the rows of data */
+    const DataMatrix*                       baseData = nullptr;     /** Full data, gathered into the working set */
+    const std::vector<std::vector<float>>*  normalizedData = nullptr;
+    const std::vector<float>*               variances = nullptr;
+    const KnnGraph*                         knnGraph = nullptr;     /** Graph the floods are computed on */
+    const std::vector<nint>*                mask = nullptr;         /** Output point of each masked point, empty without a mask */
+    const std::vector<float>*               localHighDimensionality = nullptr;
+    const RankingAtlas*                     rankingAtlas = nullptr; /** Precomputed rankings, looked up when they match the settings */
+
+    /** Output point of a flood node */
+    nint toOutputPoint(nint node) const { return mask->empty() ? node : (*mask)[node]; }
+};
+
+/** Colors of the output points, only the colored points are listed */
+struct HoverColors
+{
+    std::vector<int>    indices;
+    std::vector<float>  scalars;            /** Normalized color scalar of each colored point */
+    float               background = 0;     /** Normalized color scalar of all other points */
+
+    void clear();
+};
+
+/**
+ * Computation of a single selection of the hover pipeline: flood fill, dimension ranking,
+ * colouring and flood node histograms. Used by the hover worker of the plugin and by the
+ * headless replay harness, so both run the same stages.
+ *
+ * The pipeline keeps the flood, working set and ranking of the last selection, and the filters
+ * and histogram engine keep their caches between selections. With a selection cache, stages are
+ * looked up before they are computed and stored after.
+ *
+ * Temporary buffers of the stages come from a scratch arena that the flood stage, the first stage
+ * of every selection, resets. Together with outputs that are reused between selections, a
+ * selection doesn't allocate once the largest flood has been seen.
+ */
+class HoverPipeline
+{
+public:
+    /** Cache keys of the stages of a selection */
+    static FloodKey makeFloodKey(const HoverSettings& settings, nint seedPoint);
+    static RankingKey makeRankingKey(const HoverSettings& settings, const FloodKey& floodKey, nint selectedPoint);
+    static HistogramKey makeHistogramKey(const HoverSettings& settings, const FloodKey& floodKey);
+
+    /** Flood from the seed point and gather the working set, cache can be nullptr */
+    FloodKey updateFlood(const HoverSettings& settings, const HoverInputs& inputs, nint seedPoint, SelectionCache* cache);
+
+    /** Rank the dimensions of the last flood, or look the ranking up in the ranking atlas of the inputs */
+    void updateRanking(const HoverSettings& settings, const HoverInputs& inputs, const FloodKey& floodKey, nint selectedPoint, SelectionCache* cache);
+
+    /** Color the output points by the overlay of the settings, the directions overlay is left to the caller */
+    void computeColors(const HoverSettings& settings, const HoverInputs& inputs, HoverColors& colors) const;
+
+    /** Histograms of the flood node values of every dimension */
+    void updateHistograms(const HoverSettings& settings, const HoverInputs& inputs, const FloodKey& floodKey, SelectionCache* cache, std::vector<std::vector<int>>& bins);
+
+    /** Uncached stages, e.g. to compute selections ahead of time into separate buffers */
+    void computeFlood(const HoverSettings& settings, const HoverInputs& inputs, nint seedPoint, FloodFill& floodFill, FloodWorkingSet& workingSet);
+    void computeRanking(const HoverSettings& settings, const HoverInputs& inputs, nint selectedPoint, const FloodFill& floodFill, const FloodWorkingSet& workingSet, std::vector<int>& dimRanking);
+
+    /** Copy the values of one dimension, e.g. to color a projection view by it */
+    static void copyDimensionValues(const DataMatrix& data, dint dimension, std::vector<float>& values);
+
+    /** Drop state computed from the data, required when the data changed in place */
+    void invalidateData();
+
+    const FloodFill& getFloodFill() const { return _floodFill; }
+    const FloodWorkingSet& getWorkingSet() const { return _workingSet; }
+    const std::vector<int>& getDimRanking() const { return _dimRanking; }
+
+    /** Scores of all dimensions from the last computed ranking of the filter */
+    const std::vector<float>& getRankingScores(filters::FilterType filterType);
+
+private:
+    /** Without a graph the flood is left as it was, so nothing can be cached */
+    static SelectionCache* getCache(const HoverSettings& settings, SelectionCache* cache) { return settings.graphAvailable ? cache : nullptr; }
+
+private:
+    FloodFill                       _floodFill = FloodFill(0);
+    FloodWorkingSet                 _workingSet;
+    std::vector<int>                _dimRanking;
+    HistogramEngine                 _histograms;
+    filters::SpatialPeakFilter      _spatialPeakFilter;
+    filters::HDFloodPeakFilter      _hdFloodPeakFilter;
+    MonotonicArena                  _scratch;           /** Temporary buffers of the current selection */
+};
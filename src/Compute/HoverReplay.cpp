@@ -0,0 +1,266 @@
+#include "HoverReplay.h"
+
+#include "DataTransformations.h"
+#include "TaskScheduler.h"
+#include "Tracing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+    constexpr int SELECTION_CACHE_SIZE = 32;
+
+    /** Nearest rank quantile of the sorted values */
+    std::uint64_t getQuantile(const std::vector<std::uint64_t>& sorted, double quantile)
+    {
+        if (sorted.empty())
+            return 0;
+
+        size_t rank = (size_t) std::ceil(quantile * sorted.size());
+        return sorted[std::clamp(rank, (size_t) 1, sorted.size()) - 1];
+    }
+
+    void printQuantiles(const std::string& name, std::vector<std::uint64_t> values, double scale, const char* unit)
+    {
+        std::sort(values.begin(), values.end());
+
+        double total = 0;
+        for (const std::uint64_t& value : values)
+            total += value;
+        double mean = values.empty() ? 0 : total / values.size();
+
+        std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(3)
+            << std::setw(12) << mean * scale << std::setw(12) << getQuantile(values, 0.5) * scale
+            << std::setw(12) << getQuantile(values, 0.9) * scale << std::setw(12) << getQuantile(values, 0.99) * scale
+            << std::setw(12) << getQuantile(values, 1) * scale << " " << unit << std::endl;
+        std::cout << std::defaultfloat << std::setprecision(6);
+    }
+}
+
+const char* getHoverStageName(int stage)
+{
+    switch (stage)
+    {
+    case FLOOD_STAGE: return "Flood fill";
+    case RANKING_STAGE: return "Ranking";
+    case COLOR_STAGE: return "Color scalars";
+    case HISTOGRAM_STAGE: return "Histograms";
+    }
+    return "";
+}
+
+std::uint64_t HoverEventStats::getTotalNanoseconds() const
+{
+    std::uint64_t total = 0;
+    for (int stage = 0; stage < NUM_HOVER_STAGES; stage++)
+        total += nanoseconds[stage];
+    return total;
+}
+
+HoverReplay::HoverReplay(const HoverRecording& recording) :
+    _recording(recording),
+    _cache(SELECTION_CACHE_SIZE)
+{
+    if (recording.viewIndices.empty())
+        _dataView = recording.baseData;
+    else
+        _dataView = recording.baseData(recording.viewIndices, Eigen::all);
+
+    normalizeData(recording.baseData, _normalizedData);
+
+    if (!recording.mask.empty())
+    {
+        _maskPositions.assign(recording.projection.rows(), -1);
+        _maskedData = _dataView(recording.mask, Eigen::all);
+        _maskedProjection = recording.projection(recording.mask, Eigen::all);
+
+        for (int i = 0; i < (int) recording.mask.size(); i++)
+            _maskPositions[recording.mask[i]] = i;
+    }
+
+    _pointGrid.build(recording.projection);
+
+    bool masked = !recording.mask.empty();
+    _inputs.data = masked ? &_maskedData : &_dataView;
+    _inputs.projection = masked ? &_maskedProjection : &recording.projection;
+    _inputs.baseData = &recording.baseData;
+    _inputs.normalizedData = &_normalizedData;
+    _inputs.variances = &recording.variances;
+    _inputs.knnGraph = &recording.knnGraph;
+    _inputs.mask = &recording.mask;
+    _inputs.localHighDimensionality = &recording.localHighDimensionality;
+}
+
+nint HoverReplay::pickSelectedPoint(const HoverEvent& event) const
+{
+    if (event.selectedPoint >= 0)
+        return event.selectedPoint;
+
+    // With a mask the position in the mask is picked, like the plugin does
+    return _pointGrid.findNearest(event.cursorX, event.cursorY, 1, 1, _maskPositions);
+}
+
+void HoverReplay::updateRankingAtlas(const HoverSettings& settings)
+{
+    if (_rankingAtlas.matches(settings) || !RankingAtlas::isSupported(settings, _inputs))
+        return;
+
+    std::uint64_t begin = tracing::now();
+    _rankingAtlas.build(settings, _inputs, _recording.viewIndices, std::max(settings.numRankedDimensions, RankingAtlas::DEFAULT_TOP_K));
+
+    std::cout << "Built ranking atlas of " << _rankingAtlas.getNumPoints() << " points in " << (tracing::now() - begin) * 1e-6 << " ms" << std::endl;
+}
+
+void HoverReplay::run(std::vector<HoverEventStats>& stats)
+{
+    TRACE_SCOPE("Hover replay");
+
+    // Measure the loops with the priority they have in the plugin
+    tasks::ScopedPriority priority(tasks::Priority::INTERACTIVE);
+
+    stats.clear();
+    stats.reserve(_recording.events.size());
+
+    _cache.invalidateAll();
+    SelectionCache* cache = _useCache ? &_cache : nullptr;
+    _inputs.rankingAtlas = _useRankingAtlas ? &_rankingAtlas : nullptr;
+
+    const std::vector<int>& viewIndices = _recording.viewIndices;
+
+    Output& output = _output;
+    for (const HoverEvent& event : _recording.events)
+    {
+        nint selectedPoint = pickSelectedPoint(event);
+        if (selectedPoint < 0)
+            continue;
+
+        nint seedPoint = event.seedPoint;
+        if (seedPoint < 0)
+            seedPoint = viewIndices.empty() ? selectedPoint : viewIndices[selectedPoint];
+
+        // The recorded versions only identify the inputs of the recording, cache keys use the current ones
+        HoverSettings settings = event.settings;
+        settings.inputVersions = _cache.getVersions();
+
+        if (_useRankingAtlas)
+            updateRankingAtlas(settings);
+
+        HoverEventStats eventStats;
+        eventStats.selectedPoint = selectedPoint;
+
+        allocations::Counts allocationsBefore = allocations::getCounts();
+        std::uint64_t begin = tracing::now();
+
+        // Stages are traced with the names of the hover worker, so traces of both can be compared
+        TRACE_SPAN(floodSpan, "Hover flood fill");
+        FloodKey floodKey = _pipeline.updateFlood(settings, _inputs, seedPoint, cache);
+
+        floodSpan.end();
+        std::uint64_t floodEnd = tracing::now();
+        TRACE_SPAN(rankingSpan, "Hover ranking");
+        _pipeline.updateRanking(settings, _inputs, floodKey, selectedPoint, cache);
+
+        rankingSpan.end();
+        std::uint64_t rankingEnd = tracing::now();
+        TRACE_SPAN(colorSpan, "Hover color scalars");
+        const std::vector<int>& dimRanking = _pipeline.getDimRanking();
+
+        output.projectionScalars.resize(_recording.numProjectionViews);
+        for (int pi = 0; pi < _recording.numProjectionViews; pi++)
+            HoverPipeline::copyDimensionValues(*_inputs.data, dimRanking[pi], output.projectionScalars[pi]);
+        if (event.selectedDimension >= 0)
+            HoverPipeline::copyDimensionValues(*_inputs.data, event.selectedDimension, output.selectedDimensionScalars);
+
+        _pipeline.computeColors(settings, _inputs, output.colors);
+
+        colorSpan.end();
+        std::uint64_t colorEnd = tracing::now();
+        TRACE_SPAN(histogramSpan, "Hover histograms");
+        _pipeline.updateHistograms(settings, _inputs, floodKey, cache, output.bins);
+
+        output.floodFill = _pipeline.getFloodFill();
+        output.dimRanking = dimRanking;
+
+        histogramSpan.end();
+        std::uint64_t end = tracing::now();
+
+        eventStats.nanoseconds[FLOOD_STAGE] = floodEnd - begin;
+        eventStats.nanoseconds[RANKING_STAGE] = rankingEnd - floodEnd;
+        eventStats.nanoseconds[COLOR_STAGE] = colorEnd - rankingEnd;
+        eventStats.nanoseconds[HISTOGRAM_STAGE] = end - colorEnd;
+        eventStats.allocations = allocations::getCounts() - allocationsBefore;
+
+        stats.push_back(eventStats);
+    }
+}
+
+void HoverReplay::printSummary(const std::vector<HoverEventStats>& stats)
+{
+    std::cout << "Replayed " << stats.size() << " hover events" << std::endl;
+    std::cout << std::left << std::setw(24) << "Stage" << std::right << std::setw(12) << "Mean" << std::setw(12) << "p50"
+        << std::setw(12) << "p90" << std::setw(12) << "p99" << std::setw(12) << "Max" << std::endl;
+
+    std::vector<std::uint64_t> values(stats.size());
+    for (int stage = 0; stage < NUM_HOVER_STAGES; stage++)
+    {
+        for (size_t i = 0; i < stats.size(); i++)
+            values[i] = stats[i].nanoseconds[stage];
+        printQuantiles(getHoverStageName(stage), values, 1e-6, "ms");
+    }
+
+    for (size_t i = 0; i < stats.size(); i++)
+        values[i] = stats[i].getTotalNanoseconds();
+    printQuantiles("Event", values, 1e-6, "ms");
+
+    if (!allocations::isCounting())
+    {
+        std::cout << "Allocations are not counted in this executable" << std::endl;
+        return;
+    }
+
+    for (size_t i = 0; i < stats.size(); i++)
+        values[i] = stats[i].allocations.allocations;
+    printQuantiles("Allocations", values, 1, "per event");
+
+    for (size_t i = 0; i < stats.size(); i++)
+        values[i] = stats[i].allocations.bytes;
+    printQuantiles("Allocated", values, 1.0 / 1024, "KiB per event");
+}
+
+bool HoverReplay::writeCsv(const std::vector<HoverEventStats>& stats, const std::string& fileName)
+{
+    std::ofstream file(fileName);
+    if (!file)
+    {
+        std::cout << "Cannot open file for writing hover replay results!" << std::endl;
+        return false;
+    }
+
+    file << "event,selected_point";
+    for (int stage = 0; stage < NUM_HOVER_STAGES; stage++)
+        file << "," << getHoverStageName(stage) << " ns";
+    file << ",total ns,allocations,allocated bytes\n";
+
+    for (size_t i = 0; i < stats.size(); i++)
+    {
+        const HoverEventStats& eventStats = stats[i];
+
+        file << i << "," << eventStats.selectedPoint;
+        for (int stage = 0; stage < NUM_HOVER_STAGES; stage++)
+            file << "," << eventStats.nanoseconds[stage];
+        file << "," << eventStats.getTotalNanoseconds() << "," << eventStats.allocations.allocations << "," << eventStats.allocations.bytes << "\n";
+    }
+
+    if (!file)
+    {
+        std::cout << "Failed writing hover replay results to file!" << std::endl;
+        return false;
+    }
+
+    std::cout << "Hover replay results written to file: " << fileName << std::endl;
+    return true;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "DataMatrix.h"
+#include "Types.h"
+#include "Allocations.h"
+#include "HoverPipeline.h"
+#include "KnnGraph.h"
+#include "PointGrid.h"
+#include "RankingAtlas.h"
+#include "SelectionCache.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** A selection made while recording, or a cursor position to select the closest point of */
+struct HoverEvent
+{
+    double          time = 0;               /** Milliseconds since the recording started */
+    nint            selectedPoint = -1;     /** Point in the projection, negative to pick the point closest to the cursor */
+    nint            seedPoint = -1;         /** Flood seed, negative for the data view point of the selected point */
+    float           cursorX = 0;            /** Cursor in projection coordinates */
+    float           cursorY = 0;
+    dint            selectedDimension = -1;
+    HoverSettings   settings;
+};
+
+/** A hover session and the inputs of the pipeline when it started, enough to replay it without the plugin */
+struct HoverRecording
+{
+    DataMatrix                  baseData;                   /** Standardized data of all points */
+    std::vector<float>          variances;
+    std::vector<int>            viewIndices;                /** Points of the data view, empty for all points */
+    DataMatrix                  projection;                 /** Projection of the data view */
+    std::vector<nint>           mask;
+    KnnGraph                    knnGraph;                   /** Graph the floods are computed on */
+    std::vector<float>          localHighDimensionality;
+    int                         numProjectionViews = 2;     /** Gradient views colored by the top ranked dimensions */
+    std::vector<HoverEvent>     events;
+};
+
+enum HoverStage
+{
+    FLOOD_STAGE,
+    RANKING_STAGE,
+    COLOR_STAGE,
+    HISTOGRAM_STAGE,
+    NUM_HOVER_STAGES
+};
+
+const char* getHoverStageName(int stage);
+
+/** Measurements of a single replayed event */
+struct HoverEventStats
+{
+    nint                    selectedPoint = 0;
+    std::uint64_t           nanoseconds[NUM_HOVER_STAGES] = {};
+    allocations::Counts     allocations;
+
+    std::uint64_t getTotalNanoseconds() const;
+};
+
+/**
+ * Replays a hover recording through the hover pipeline without the plugin or any rendering,
+ * running the same stages as the hover worker: flood fill, dimension ranking, the scalars of
+ * the gradient views, colouring and flood node histograms. Every event is measured, including
+ * the number of allocations when the executable counts them (see Allocations.h).
+ *
+ * Events are replayed back to back, so none are dropped as superseded and no selections are
+ * prefetched, which makes runs comparable across versions and machines.
+ */
+class HoverReplay
+{
+public:
+    /** Derive the pipeline inputs from the recording, which has to outlive the replay */
+    explicit HoverReplay(const HoverRecording& recording);
+
+    HoverReplay(const HoverReplay&) = delete;
+    HoverReplay& operator=(const HoverReplay&) = delete;
+
+    /** Look stages up in a selection cache like the plugin does, off by default to measure the computation */
+    void setUseCache(bool useCache) { _useCache = useCache; }
+
+    /** Look rankings up in a ranking atlas like the plugin does, the atlas is built outside of the measured events */
+    void setUseRankingAtlas(bool useRankingAtlas) { _useRankingAtlas = useRankingAtlas; }
+
+    /** Replay all events, stats get one entry per event */
+    void run(std::vector<HoverEventStats>& stats);
+
+    /** Print latency quantiles per stage and the allocations per event */
+    static void printSummary(const std::vector<HoverEventStats>& stats);
+
+    /** Write one line per event, @return False if the file could not be written */
+    static bool writeCsv(const std::vector<HoverEventStats>& stats, const std::string& fileName);
+
+private:
+    /** Everything the hover worker hands to the widgets, reused between events like the worker recycles its results */
+    struct Output
+    {
+        FloodFill                       floodFill = FloodFill(0);
+        std::vector<int>                dimRanking;
+        std::vector<std::vector<float>> projectionScalars;
+        std::vector<float>              selectedDimensionScalars;
+        HoverColors                     colors;
+        std::vector<std::vector<int>>   bins;
+    };
+
+    nint pickSelectedPoint(const HoverEvent& event) const;
+
+    /** Build the ranking atlas for the settings unless it already matches them */
+    void updateRankingAtlas(const HoverSettings& settings);
+
+private:
+    const HoverRecording&           _recording;
+
+    DataMatrix                      _dataView;
+    DataMatrix                      _maskedData;
+    DataMatrix                      _maskedProjection;
+    std::vector<std::vector<float>> _normalizedData;
+    std::vector<int>                _maskPositions;     /** Position of each point in the mask, -1 for points outside of it, empty without a mask */
+    PointGrid                       _pointGrid;
+    HoverInputs                     _inputs;
+
+    HoverPipeline                   _pipeline;
+    Output                          _output;
+    SelectionCache                  _cache;
+    bool                            _useCache = false;
+    RankingAtlas                    _rankingAtlas;
+    bool                            _useRankingAtlas = false;
+};
@@ -1,7 +1,10 @@
 #include "KnnGraph.h"
 
 #include "SecondaryDistanceMeasures.h"
+#include "ComputeProgress.h"
 #include "IO/KnnGraphIO.h"
+#include "TaskScheduler.h"
+#include "Tracing.h"
 
 #include <algorithm>
 #include <iostream>
@@ -55,7 +58,7 @@ void printDistances(std::string name, float* distances, int k)
 // Build KNN sub-graph from bigger graph
 void KnnGraph::build(const KnnGraph& graph, int numNeighbours)
 {
-    assert(graph.getNumNeighbours() > numNeighbours);
+    assert(graph.getNumNeighbours() >= numNeighbours);
 
     _numNeighbours = numNeighbours;
 
@@ -71,14 +74,17 @@ void KnnGraph::build(const KnnGraph& graph, int numNeighbours)
     }
 }
 
-void KnnGraph::build(const DataMatrix& data, const knn::Index& index, int numNeighbours)
+void KnnGraph::build(const DataMatrix& data, const knn::Index& index, int numNeighbours, ComputeProgress* progress)
 {
     std::vector<int> indices;
     std::vector<float> distances;
 
     int k = numNeighbours + 1; // Plus one to account for the query point itself being in the results
 
-    index.search(data, k, indices, distances);
+    index.search(data, k, indices, distances, progress);
+
+    if (progress && progress->isCancelled())
+        return;
 
     // print results
     printIndices("INDEX", indices, k);
@@ -88,16 +94,13 @@ void KnnGraph::build(const DataMatrix& data, const knn::Index& index, int numNei
     _neighbours.clear();
     _neighbours.resize(data.rows(), std::vector<int>(_numNeighbours));
 
-    int progressTick = std::max(EIGEN_DEFAULT_DENSE_INDEX_TYPE(1), data.rows() / 100);
-#pragma omp parallel for
-    for (int i = 0; i < data.rows(); i++)
+    tasks::parallelFor(0, (int) data.rows(), [&](int i)
     {
-        if (i % progressTick == 0) std::cout << "Building graph: " << i << "/" << data.rows() << std::endl;
         for (int j = 0; j < _numNeighbours; j++)
         {
             _neighbours[i][j] = indices[i * k + j + 1];
         }
-    }
+    });
 }
 
 void KnnGraph::build(const KnnGraph& graph, int numNeighbours, bool shared)
@@ -109,7 +112,188 @@ void KnnGraph::build(const KnnGraph& graph, int numNeighbours, bool shared)
     computeSharedNeighboursBitset(graph.getNeighbours(), _neighbours, numNeighbours);
 }
 
-void KnnGraph::readFromFile(QString filePath)
+void KnnGraph::refine(const DataMatrix& data, const KnnGraph& seed, int numRounds, ComputeProgress* progress)
+{
+    // Neighbours whose own neighbours are searched, the nearest ones are the most likely to lead to better ones
+    constexpr int NUM_EXPANDED = 10;
+
+    int numPoints = (int) data.rows();
+    int numNeighbours = seed.getNumNeighbours();
+    bool cosine = getKnnMetric(data) == knn::Metric::COSINE;
+
+    // Every point is compared with hundreds of candidates, so its values are kept together
+    Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> rows = data;
+    int numDimensions = (int) rows.cols();
+
+    std::vector<float> inverseNorms;
+    if (cosine)
+    {
+        inverseNorms.resize(numPoints);
+        tasks::parallelFor(0, numPoints, [&](int i)
+        {
+            float norm = rows.row(i).norm();
+            inverseNorms[i] = norm > 0 ? 1.0f / norm : 0;
+        });
+    }
+
+    const auto distance = [&](int i, int j)
+    {
+        const float* a = rows.data() + (std::size_t) i * numDimensions;
+        const float* b = rows.data() + (std::size_t) j * numDimensions;
+
+        float sum = 0;
+        if (cosine)
+        {
+            for (int d = 0; d < numDimensions; d++)
+                sum += a[d] * b[d];
+            return 1 - sum * inverseNorms[i] * inverseNorms[j];
+        }
+
+        for (int d = 0; d < numDimensions; d++)
+            sum += std::abs(a[d] - b[d]);
+        return sum;
+    };
+
+    std::vector<std::vector<nint>> current = seed.getNeighbours();
+    std::vector<std::vector<nint>> next(numPoints, std::vector<nint>(numNeighbours));
+
+    for (int round = 0; round < numRounds; round++)
+    {
+        if (progress && progress->isCancelled())
+            return;
+
+        tasks::parallelForRanges(0, numPoints, 64, [&](int begin, int end, int)
+        {
+            std::vector<nint> candidates;
+            std::vector<std::pair<float, nint>> scored;
+
+            for (int i = begin; i < end; i++)
+            {
+                const std::vector<nint>& neighbours = current[i];
+
+                candidates.assign(neighbours.begin(), neighbours.end());
+                for (int k = 0; k < std::min(NUM_EXPANDED, (int) neighbours.size()); k++)
+                {
+                    const std::vector<nint>& secondNeighbours = current[neighbours[k]];
+                    candidates.insert(candidates.end(), secondNeighbours.begin(), secondNeighbours.end());
+                }
+
+                std::sort(candidates.begin(), candidates.end());
+                candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+                scored.clear();
+                for (nint candidate : candidates)
+                {
+                    if (candidate != i)
+                        scored.emplace_back(distance(i, candidate), candidate);
+                }
+
+                int numKept = std::min(numNeighbours, (int) scored.size());
+                std::partial_sort(scored.begin(), scored.begin() + numKept, scored.end());
+
+                // The old neighbours are among the candidates, so there are always enough
+                for (int k = 0; k < numKept; k++)
+                    next[i][k] = scored[k].second;
+            }
+        });
+
+        current.swap(next);
+
+        if (progress)
+            progress->setStageProgress((float) (round + 1) / numRounds);
+    }
+
+    _numNeighbours = numNeighbours;
+    _neighbours = std::move(current);
+}
+
+knn::Metric getKnnMetric(const DataMatrix& data)
+{
+    return data.cols() <= 200 ? knn::Metric::MANHATTAN : knn::Metric::COSINE;
+}
+
+void createKnnIndex(const DataMatrix& data, knn::Index& index, ComputeProgress* progress)
+{
+    index.create(data.cols(), getKnnMetric(data));
+    index.addData(data, progress);
+}
+
+bool buildKnnGraphs(const DataMatrix& data, bool useSharedDistances, KnnGraphBuild& build, ComputeProgress* progress)
+{
+    TRACE_SCOPE("kNN graph build");
+
+    // faiss searches with OpenMP, keep it within the thread budget of the build
+    tasks::limitOpenMPThreads();
+
+    const auto isCancelled = [progress]() { return progress && progress->isCancelled(); };
+
+    TRACE_SPAN(indexSpan, "kNN index build");
+    if (progress) progress->setStage(0, 0.05f);
+    createKnnIndex(data, build.index, progress);
+
+    indexSpan.end();
+    if (isCancelled())
+        return false;
+
+    // Searching the index takes nearly all of the time
+    if (progress) progress->setStage(0.05f, 0.95f);
+    if (useSharedDistances)
+    {
+        build.sourceGraph.build(data, build.index, 100, progress);
+        if (isCancelled())
+            return false;
+
+        if (progress) progress->setStage(0.95f, 1);
+        build.largeGraph.build(build.sourceGraph, 30, true);
+        build.graph.build(build.sourceGraph, 10, true);
+    }
+    else
+    {
+        build.largeGraph.build(data, build.index, 30, progress);
+        if (isCancelled())
+            return false;
+
+        if (progress) progress->setStage(0.95f, 1);
+        build.graph.build(build.largeGraph, 10);
+    }
+
+    if (progress) progress->setStageProgress(1);
+    return !isCancelled();
+}
+
+bool refineKnnGraphs(const DataMatrix& data, bool useSharedDistances, const KnnGraph& seedGraph, KnnGraphBuild& build, ComputeProgress* progress)
+{
+    TRACE_SCOPE("kNN graph refinement");
+
+    // Two rounds recover nearly all neighbours after a few dimensions changed
+    constexpr int NUM_ROUNDS = 2;
+
+    if (progress) progress->setStage(0, 0.95f);
+    if (useSharedDistances)
+    {
+        build.sourceGraph.refine(data, seedGraph, NUM_ROUNDS, progress);
+        if (progress && progress->isCancelled())
+            return false;
+
+        if (progress) progress->setStage(0.95f, 1);
+        build.largeGraph.build(build.sourceGraph, 30, true);
+        build.graph.build(build.sourceGraph, 10, true);
+    }
+    else
+    {
+        build.largeGraph.refine(data, seedGraph, NUM_ROUNDS, progress);
+        if (progress && progress->isCancelled())
+            return false;
+
+        if (progress) progress->setStage(0.95f, 1);
+        build.graph.build(build.largeGraph, 10);
+    }
+
+    if (progress) progress->setStageProgress(1);
+    return !(progress && progress->isCancelled());
+}
+
+void KnnGraph::readFromFile(const std::string& filePath)
 {
     KnnGraphImporter::read(filePath, *this);
 }
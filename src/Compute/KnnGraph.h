@@ -3,10 +3,11 @@
 #include "Types.h"
 #include "KnnIndex.h"
 
-#include <QString>
+#include <string>
 
 class KnnGraphImporter;
 class KnnGraphExporter;
+class ComputeProgress;
 
 class KnnGraph
 {
@@ -17,10 +18,17 @@ public:
     int getNumNeighbours() const { return _numNeighbours; }
 
     void build(const KnnGraph& graph, int numNeighbours);
-    void build(const DataMatrix& data, const knn::Index& index, int numNeighbours);
+    void build(const DataMatrix& data, const knn::Index& index, int numNeighbours, ComputeProgress* progress = nullptr);
     void build(const KnnGraph& graph, int numNeighbours, bool shared);
 
-    void readFromFile(QString filePath);
+    /**
+     * Refine the neighbours of the seed graph to the data by searching the neighbours of neighbours,
+     * a few rounds of NN-Descent. Far cheaper than a build, and close to exact when the data only
+     * changed a little since the seed was built. Keeps the number of neighbours of the seed.
+     */
+    void refine(const DataMatrix& data, const KnnGraph& seed, int numRounds, ComputeProgress* progress = nullptr);
+
+    void readFromFile(const std::string& filePath);
     void writeToFile();
 
 private:
@@ -30,4 +38,37 @@ private:
     friend class SpaceWalkerPlugin;
     friend class KnnGraphImporter;
     friend class KnnGraphExporter;
+    friend class HoverRecordingImporter;
+    friend class DerivedDataCache;
+    friend class TestData;
+};
+
+/** Index and graphs of a full kNN build, kept apart from the graphs in use until the build has finished */
+struct KnnGraphBuild
+{
+    knn::Index  index;
+    KnnGraph    sourceGraph;    /** Only built with shared distances, the graphs below are derived from it */
+    KnnGraph    largeGraph;
+    KnnGraph    graph;
 };
+
+/** Metric the flood graphs of the data are built with */
+knn::Metric getKnnMetric(const DataMatrix& data);
+
+/** Create the kNN index the flood graphs of the data are built with */
+void createKnnIndex(const DataMatrix& data, knn::Index& index, ComputeProgress* progress = nullptr);
+
+/**
+ * Create a kNN index of the data and build the flood graphs from it, reporting progress
+ * and checking for cancellation through the optional progress object.
+ * @return False if the build was cancelled
+ */
+bool buildKnnGraphs(const DataMatrix& data, bool useSharedDistances, KnnGraphBuild& build, ComputeProgress* progress = nullptr);
+
+/**
+ * Refine the graphs of an earlier build to changed data instead of building them again, used when
+ * dimensions are enabled or disabled. No index is created, rebuildKnnGraph() creates it on demand.
+ * @param seedGraph Source graph of the earlier build when it used shared distances, its large graph otherwise
+ * @return False if the refinement was cancelled
+ */
+bool refineKnnGraphs(const DataMatrix& data, bool useSharedDistances, const KnnGraph& seedGraph, KnnGraphBuild& build, ComputeProgress* progress = nullptr);
@@ -1,8 +1,13 @@
 #include "KnnIndex.h"
 
-#include <QDebug>
+#include "ComputeProgress.h"
+#include "TaskScheduler.h"
+
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <utility>
 
 #include <fstream>
 #include <sstream>
@@ -48,7 +53,101 @@ void writeDataMatrixToDisk(const DataMatrix& dataMatrix)
     std::cout << "Data matrix written to file" << std::endl;
 }
 
-void createFaissIndex(faiss::IndexFlat*& index, int numDimensions, knn::Metric metric)
+#ifdef SPACEWALKER_NO_FAISS
+namespace knn
+{
+    class BruteForceIndex
+    {
+    public:
+        /** Distances are reported like faiss does, squared for L2 and largest first for inner products */
+        enum class Distance
+        {
+            L1, L2, INNER_PRODUCT
+        };
+
+        BruteForceIndex(int numDimensions, Distance distance) :
+            _numDimensions(numDimensions),
+            _distance(distance)
+        {
+
+        }
+
+        void add(idx_t numPoints, const float* data)
+        {
+            _data.insert(_data.end(), data, data + numPoints * _numDimensions);
+        }
+
+        void search(idx_t numQueries, const float* queries, idx_t k, float* distances, idx_t* labels) const
+        {
+            idx_t numPoints = (idx_t) _data.size() / _numDimensions;
+            idx_t numFound = std::min(k, numPoints);
+            bool largestFirst = _distance == Distance::INNER_PRODUCT;
+
+            tasks::parallelForRanges(0, (int) numQueries, 0, [&](int begin, int end, int)
+            {
+                std::vector<std::pair<float, idx_t>> candidates(numPoints);
+                for (int q = begin; q < end; q++)
+                {
+                    const float* query = queries + (size_t) q * _numDimensions;
+                    for (idx_t p = 0; p < numPoints; p++)
+                        candidates[p] = { getDistance(query, _data.data() + p * _numDimensions), p };
+
+                    // Equal distances are ordered by index, so results don't depend on the sort implementation
+                    std::partial_sort(candidates.begin(), candidates.begin() + numFound, candidates.end(), [largestFirst](const auto& a, const auto& b)
+                    {
+                        if (a.first != b.first)
+                            return largestFirst ? a.first > b.first : a.first < b.first;
+                        return a.second < b.second;
+                    });
+
+                    // Like faiss, missing neighbours are -1 at the worst possible distance
+                    for (idx_t i = 0; i < k; i++)
+                    {
+                        size_t offset = (size_t) q * k + i;
+                        labels[offset] = i < numFound ? candidates[i].second : -1;
+                        distances[offset] = i < numFound ? candidates[i].first : (largestFirst ? -INFINITY : INFINITY);
+                    }
+                }
+            });
+        }
+
+    private:
+        float getDistance(const float* a, const float* b) const
+        {
+            float distance = 0;
+            for (int d = 0; d < _numDimensions; d++)
+            {
+                switch (_distance)
+                {
+                case Distance::L1: distance += std::abs(a[d] - b[d]); break;
+                case Distance::L2: distance += (a[d] - b[d]) * (a[d] - b[d]); break;
+                case Distance::INNER_PRODUCT: distance += a[d] * b[d]; break;
+                }
+            }
+            return distance;
+        }
+
+    private:
+        int                 _numDimensions;
+        Distance            _distance;
+        std::vector<float>  _data;
+    };
+}
+
+void createFaissIndex(knn::FlatIndex*& index, int numDimensions, knn::Metric metric)
+{
+    switch (metric)
+    {
+    case knn::Metric::MANHATTAN:
+        index = new knn::BruteForceIndex(numDimensions, knn::BruteForceIndex::Distance::L1); break;
+    case knn::Metric::EUCLIDEAN:
+        index = new knn::BruteForceIndex(numDimensions, knn::BruteForceIndex::Distance::L2); break;
+    case knn::Metric::COSINE:
+        index = new knn::BruteForceIndex(numDimensions, knn::BruteForceIndex::Distance::INNER_PRODUCT); break;
+    }
+}
+#else
+void createFaissIndex(knn::FlatIndex*& index, int numDimensions, knn::Metric metric)
 {
     switch (metric)
     {
@@ -60,12 +159,22 @@ void createFaissIndex(faiss::IndexFlat*& index, int numDimensions, knn::Metric m
         index = new faiss::IndexFlat(numDimensions, faiss::METRIC_INNER_PRODUCT); break;
     }
 }
+#endif
 
 void createAnnoyIndex(AnnoyIndex*& index, int numDimensions)
 {
     index = new AnnoyIndex(numDimensions);
 }
 
+namespace
+{
+    // Number of query points searched at once, bounds the time until progress is reported or a cancel is noticed
+    constexpr int SEARCH_CHUNK_SIZE = 4096;
+
+    // Points an approximate search thread takes at once, bounds the time until a thread switches to interactive work
+    constexpr int ANNOY_SEARCH_GRAIN_SIZE = 64;
+}
+
 namespace knn
 {
     Index::Index() :
@@ -75,15 +184,52 @@ namespace knn
     }
 
     Index::~Index()
+    {
+        release();
+    }
+
+    Index::Index(Index&& other) noexcept :
+        _annoyIndex(other._annoyIndex),
+        _faissIndex(other._faissIndex),
+        _metric(other._metric),
+        _preciseKnn(other._preciseKnn)
+    {
+        other._annoyIndex = nullptr;
+        other._faissIndex = nullptr;
+    }
+
+    Index& Index::operator=(Index&& other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+
+            _annoyIndex = other._annoyIndex;
+            _faissIndex = other._faissIndex;
+            _metric = other._metric;
+            _preciseKnn = other._preciseKnn;
+
+            other._annoyIndex = nullptr;
+            other._faissIndex = nullptr;
+        }
+        return *this;
+    }
+
+    void Index::release()
     {
         if (_annoyIndex != nullptr)
             delete _annoyIndex;
         if (_faissIndex != nullptr)
             delete _faissIndex;
+
+        _annoyIndex = nullptr;
+        _faissIndex = nullptr;
     }
 
     void Index::create(int numDimensions, Metric metric)
     {
+        release();
+
         _metric = metric;
         if (_preciseKnn)
             createFaissIndex(_faissIndex, numDimensions, metric);
@@ -91,13 +237,16 @@ namespace knn
             createAnnoyIndex(_annoyIndex, numDimensions);
     }
 
-    void Index::addData(const DataMatrix& data)
+    void Index::addData(const DataMatrix& data, ComputeProgress* progress)
     {
         size_t numPoints = data.rows();
         size_t numDimensions = data.cols();
 
         std::vector<float> indexData;
-        linearizeData(data, indexData);
+        linearizeData(data, indexData, progress);
+
+        if (progress && progress->isCancelled())
+            return;
 
         if (_preciseKnn)
         {
@@ -109,19 +258,22 @@ namespace knn
             //writeDataMatrixToDisk(data);
             //_annoyIndex->on_disk_build("test.ann");
             for (size_t i = 0; i < numPoints; ++i) {
-                if (i % 10000 == 0) qDebug() << "Add Progress: " << i;
                 _annoyIndex->add_item((int) i, indexData.data() + (i * numDimensions));
-                if (i % 100 == 0)
-                    std::cout << "Loading objects ...\t object: " << i + 1 << "\tProgress:" << std::fixed << std::setprecision(2) << (double)i / (double)(numPoints + 1) * 100 << "%\r";
+
+                if (progress && i % 10000 == 0)
+                {
+                    if (progress->isCancelled())
+                        return;
+                    progress->setStageProgress((float) i / numPoints);
+                }
             }
 
-            std::cout << "Building index.." << std::endl;
             _annoyIndex->build((int) (10 * numDimensions));
             //_annoyIndex->save("test.ann");
         }
     }
 
-    void Index::search(const DataMatrix& data, int k, std::vector<int>& indices, std::vector<float>& distances) const
+    void Index::search(const DataMatrix& data, int k, std::vector<int>& indices, std::vector<float>& distances, ComputeProgress* progress) const
     {
         int numPoints = data.rows();
         int numDimensions = data.cols();
@@ -131,42 +283,66 @@ namespace knn
         linearizeData(data, query);
 
         // Initialize result vectors
-        size_t resultSize = numPoints * k;
+        size_t resultSize = (size_t) numPoints * k;
         indices.resize(resultSize);
         distances.resize(resultSize);
 
         if (_preciseKnn)
         {
-            idx_t* I = new idx_t[resultSize];
+            std::vector<idx_t> I(resultSize);
+
+            // Search in chunks so a long search reports progress and can be cancelled in between
+            for (int start = 0; start < numPoints; start += SEARCH_CHUNK_SIZE)
+            {
+                if (progress && progress->isCancelled())
+                    return;
+
+                int count = std::min(SEARCH_CHUNK_SIZE, numPoints - start);
+                size_t offset = (size_t) start * k;
 
-            _faissIndex->search(numPoints, query.data(), k, distances.data(), I);
+                _faissIndex->search(count, query.data() + (size_t) start * numDimensions, k, distances.data() + offset, I.data() + offset);
 
-            indices.assign(I, I + resultSize);
+                if (progress)
+                    progress->setStageProgress((float) (start + count) / numPoints);
+            }
 
-            delete[] I;
+            indices.assign(I.begin(), I.end());
         }
         else
         {
-            std::vector<std::vector<int>> tempIndices(numPoints, std::vector<int>(k));
-            std::vector<std::vector<float>> tempDistances(numPoints, std::vector<float>(k));
-
-            int totalCount = 0;
-#pragma omp parallel for
-            for (int i = 0; i < data.rows(); i++)
+            tasks::parallelForRanges(0, (int) data.rows(), ANNOY_SEARCH_GRAIN_SIZE, [&](int begin, int end, int)
             {
-                _annoyIndex->get_nns_by_item(i, k, -1, &tempIndices[i], &tempDistances[i]);
-                
-                if (i % 1000 == 0) std::cout << "Querying neighbours: " << i << "/" << data.rows() << std::endl;
-//#pragma omp critical
-//                {
-//                    totalCount += 1;
-//                    if (totalCount % 1000 == 0) std::cout << "Querying neighbours: " << totalCount << "/" << data.rows() << std::endl;
-//                }
-            }
+                // Annoy appends its results, so the buffers are cleared per point and only keep their capacity
+                std::vector<int> pointIndices;
+                std::vector<float> pointDistances;
+                pointIndices.reserve(k);
+                pointDistances.reserve(k);
+
+                for (int i = begin; i < end; i++)
+                {
+                    if (progress && progress->isCancelled())
+                        return;
+
+                    pointIndices.clear();
+                    pointDistances.clear();
+                    _annoyIndex->get_nns_by_item(i, k, -1, &pointIndices, &pointDistances);
+
+                    // Like faiss, neighbours that weren't found are -1 at an infinite distance
+                    size_t offset = (size_t) i * k;
+                    int numFound = std::min((int) pointIndices.size(), k);
+                    std::copy(pointIndices.begin(), pointIndices.begin() + numFound, indices.begin() + offset);
+                    std::copy(pointDistances.begin(), pointDistances.begin() + numFound, distances.begin() + offset);
+                    std::fill(indices.begin() + offset + numFound, indices.begin() + offset + k, -1);
+                    std::fill(distances.begin() + offset + numFound, distances.begin() + offset + k, INFINITY);
+
+                    if (progress && i % 1000 == 0)
+                        progress->setStageProgress((float) i / numPoints);
+                }
+            });
         }
     }
 
-    void Index::linearizeData(const DataMatrix& data, std::vector<float>& highDimArray) const
+    void Index::linearizeData(const DataMatrix& data, std::vector<float>& highDimArray, ComputeProgress* progress) const
     {
         size_t numPoints = data.rows();
         size_t numDimensions = data.cols();
@@ -174,7 +350,7 @@ namespace knn
         // Put eigen matrix into flat float vector
         highDimArray.resize(numPoints * numDimensions);
 
-        int idx = 0;
+        size_t idx = 0;
         for (int i = 0; i < numPoints; i++)
         {
             if (_metric == Metric::COSINE)
@@ -197,7 +373,13 @@ namespace knn
                 for (int d = 0; d < numDimensions; d++)
                     highDimArray[idx++] = data(i, d);
             }
-            if (i % 10000 == 0) qDebug() << "Convert Data Progress: " << i;
+
+            if (progress && i % 10000 == 0)
+            {
+                if (progress->isCancelled())
+                    return;
+                progress->setStageProgress((float) i / numPoints);
+            }
         }
     }
 }
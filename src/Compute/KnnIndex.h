@@ -8,13 +8,17 @@
 #include <kissrandom.h>
 #pragma warning(pop)
 
+#ifndef SPACEWALKER_NO_FAISS
 #include <faiss/IndexFlat.h>
 #include <faiss/IndexIVFFlat.h>
+#endif
 
 using AnnoyIndex = Annoy::AnnoyIndex<int, float, Annoy::Angular, Annoy::Kiss32Random, Annoy::AnnoyIndexMultiThreadedBuildPolicy>;
 
 using idx_t = int64_t;
 
+class ComputeProgress;
+
 namespace knn
 {
     enum class Metric
@@ -22,22 +26,47 @@ namespace knn
         EUCLIDEAN, MANHATTAN, COSINE, ANGULAR
     };
 
+#ifdef SPACEWALKER_NO_FAISS
+    /** Exact search by brute force, stands in for the flat faiss index in builds without faiss */
+    class BruteForceIndex;
+    using FlatIndex = BruteForceIndex;
+#else
+    using FlatIndex = faiss::IndexFlat;
+#endif
+
     class Index
     {
     public:
         Index();
         ~Index();
 
+        // Owns the underlying index, so it can be moved but not copied
+        Index(const Index&) = delete;
+        Index& operator=(const Index&) = delete;
+        Index(Index&& other) noexcept;
+        Index& operator=(Index&& other) noexcept;
+
+        /** Search exactly with faiss, or by brute force without it, or approximately with an angular annoy index. Takes effect on the next create() */
+        void setPreciseKnn(bool preciseKnn) { _preciseKnn = preciseKnn; }
+        bool isPreciseKnn() const { return _preciseKnn; }
+
         void create(int numDimensions, Metric metric);
-        void addData(const DataMatrix& data);
-        void search(const DataMatrix& data, int numNeighbours, std::vector<int>& indices, std::vector<float>& distances) const;
+        bool isCreated() const { return _annoyIndex != nullptr || _faissIndex != nullptr; }
+
+        /**
+         * The optional progress object receives progress in [0, 1] and is checked for cancellation,
+         * a cancelled call returns early leaving the index or results incomplete.
+         */
+        void addData(const DataMatrix& data, ComputeProgress* progress = nullptr);
+        void search(const DataMatrix& data, int numNeighbours, std::vector<int>& indices, std::vector<float>& distances, ComputeProgress* progress = nullptr) const;
 
     private:
-        void linearizeData(const DataMatrix& data, std::vector<float>& highDimArray) const;
+        void linearizeData(const DataMatrix& data, std::vector<float>& highDimArray, ComputeProgress* progress = nullptr) const;
+        void release();
 
     private:
         AnnoyIndex*                         _annoyIndex     = nullptr;
-        faiss::IndexFlat*                   _faissIndex     = nullptr;
+        FlatIndex*                          _faissIndex     = nullptr;
 
         Metric                              _metric;
 
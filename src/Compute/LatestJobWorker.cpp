@@ -0,0 +1,88 @@
+#include "LatestJobWorker.h"
+
+LatestJobWorker::LatestJobWorker() :
+    _pendingGeneration(0),
+    _busy(false),
+    _stopping(false),
+    _generation(0),
+    _cancelledGeneration(0)
+{
+
+}
+
+LatestJobWorker::~LatestJobWorker()
+{
+    stop();
+}
+
+std::uint64_t LatestJobWorker::submit(Job job)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_stopping)
+        return 0;
+
+    if (!_thread.joinable())
+        _thread = std::thread(&LatestJobWorker::run, this);
+
+    _pendingJob = std::move(job);
+    _pendingGeneration = ++_generation;
+
+    _jobAvailable.notify_one();
+
+    return _pendingGeneration;
+}
+
+void LatestJobWorker::cancelAndWait()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    _cancelledGeneration = ++_generation;
+    _pendingJob = nullptr;
+
+    _idle.wait(lock, [this]() { return !_busy; });
+}
+
+void LatestJobWorker::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _stopping = true;
+        _cancelledGeneration = ++_generation;
+        _pendingJob = nullptr;
+    }
+    _jobAvailable.notify_all();
+
+    if (_thread.joinable())
+        _thread.join();
+}
+
+void LatestJobWorker::run()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    while (true)
+    {
+        _jobAvailable.wait(lock, [this]() { return _stopping || _pendingJob; });
+
+        if (_stopping)
+            break;
+
+        Job job = std::move(_pendingJob);
+        std::uint64_t generation = _pendingGeneration;
+        _pendingJob = nullptr;
+        _busy = true;
+
+        lock.unlock();
+        if (!isSuperseded(generation))
+            job(generation);
+        lock.lock();
+
+        _busy = false;
+        _idle.notify_all();
+    }
+
+    _busy = false;
+    _idle.notify_all();
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+ * Background thread that only runs the most recently submitted job.
+ *
+ * Submitting a job replaces a job that hasn't started yet and supersedes the one that is running.
+ * Every job receives a generation number and should check isSuperseded() between its stages to
+ * stop early. Jobs must not submit or wait on the worker themselves.
+ */
+class LatestJobWorker
+{
+public:
+    using Job = std::function<void(std::uint64_t generation)>;
+
+    LatestJobWorker();
+    ~LatestJobWorker();
+
+    LatestJobWorker(const LatestJobWorker&) = delete;
+    LatestJobWorker& operator=(const LatestJobWorker&) = delete;
+
+    /** Queue a job in place of any pending one, the thread is started on first use */
+    std::uint64_t submit(Job job);
+
+    /** A newer job has been submitted, or the job was cancelled */
+    bool isSuperseded(std::uint64_t generation) const { return generation != _generation.load(); }
+
+    /** The job was cancelled by cancelAndWait() or stop() rather than replaced by a newer job */
+    bool isCancelled(std::uint64_t generation) const { return generation <= _cancelledGeneration.load(); }
+
+    /** Drop the pending job, supersede the running one and block until the worker is idle */
+    void cancelAndWait();
+
+    /** Cancel all work and join the thread, no jobs are accepted afterwards */
+    void stop();
+
+private:
+    void run();
+
+private:
+    std::thread                 _thread;
+    std::mutex                  _mutex;
+    std::condition_variable     _jobAvailable;
+    std::condition_variable     _idle;
+
+    Job                         _pendingJob;
+    std::uint64_t               _pendingGeneration;
+    bool                        _busy;
+    bool                        _stopping;
+
+    std::atomic<std::uint64_t>  _generation;
+    std::atomic<std::uint64_t>  _cancelledGeneration;
+};
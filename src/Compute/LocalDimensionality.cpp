@@ -2,8 +2,6 @@
 
 #include "KnnGraph.h"
 
-#include <QDebug>
-
 namespace hdps
 {
     namespace compute
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * Fixed capacity map that evicts the least recently used entry. Not thread-safe.
+ */
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache
+{
+public:
+    using EvictionHandler = std::function<void(const Key& key, const Value& value)>;
+
+    explicit LruCache(std::size_t capacity) :
+        _capacity(capacity)
+    {
+
+    }
+
+    void setCapacity(std::size_t capacity)
+    {
+        _capacity = capacity;
+        while (_entries.size() > _capacity)
+            evictLast();
+    }
+
+    std::size_t getCapacity() const { return _capacity; }
+    std::size_t size() const { return _entries.size(); }
+
+    /** Called for every entry that is evicted or cleared */
+    void setEvictionHandler(EvictionHandler handler) { _evictionHandler = std::move(handler); }
+
+    /** Look up an entry and mark it as most recently used, nullptr if there is none */
+    Value* find(const Key& key)
+    {
+        auto it = _lookup.find(key);
+        if (it == _lookup.end())
+            return nullptr;
+
+        _entries.splice(_entries.begin(), _entries, it->second);
+        return &it->second->second;
+    }
+
+    /** Whether there is an entry for the key, without changing the order of use */
+    bool contains(const Key& key) const { return _lookup.find(key) != _lookup.end(); }
+
+    /** Insert or replace an entry as most recently used */
+    Value& insert(const Key& key, Value value)
+    {
+        Value& entryValue = insertForOverwrite(key);
+        entryValue = std::move(value);
+        return entryValue;
+    }
+
+    /**
+     * Insert an entry as most recently used and return its value for the caller to overwrite.
+     * When the cache is full the least recently used entry is evicted and its storage is reused,
+     * so values that are assigned into keep their buffers and a full cache doesn't allocate.
+     */
+    Value& insertForOverwrite(const Key& key)
+    {
+        auto it = _lookup.find(key);
+        if (it != _lookup.end())
+        {
+            _entries.splice(_entries.begin(), _entries, it->second);
+            return it->second->second;
+        }
+
+        if (_capacity > 0 && !_entries.empty() && _entries.size() >= _capacity)
+        {
+            auto last = std::prev(_entries.end());
+            if (_evictionHandler)
+                _evictionHandler(last->first, last->second);
+
+            // Rekey the lookup node and the entry in place
+            auto node = _lookup.extract(last->first);
+            node.key() = key;
+            last->first = key;
+            _lookup.insert(std::move(node));
+
+            _entries.splice(_entries.begin(), _entries, last);
+            return last->second;
+        }
+
+        _entries.emplace_front(key, Value());
+        _lookup[key] = _entries.begin();
+        return _entries.front().second;
+    }
+
+    void erase(const Key& key)
+    {
+        auto it = _lookup.find(key);
+        if (it == _lookup.end())
+            return;
+
+        _entries.erase(it->second);
+        _lookup.erase(it);
+    }
+
+    void clear()
+    {
+        if (_evictionHandler)
+        {
+            for (const auto& entry : _entries)
+                _evictionHandler(entry.first, entry.second);
+        }
+
+        _entries.clear();
+        _lookup.clear();
+    }
+
+private:
+    void evictLast()
+    {
+        const auto& entry = _entries.back();
+        if (_evictionHandler)
+            _evictionHandler(entry.first, entry.second);
+
+        _lookup.erase(entry.first);
+        _entries.pop_back();
+    }
+
+private:
+    using Entry = std::pair<Key, Value>;
+
+    std::size_t                                                         _capacity;
+    std::list<Entry>                                                    _entries;   /** Most recently used first */
+    std::unordered_map<Key, typename std::list<Entry>::iterator, Hash>  _lookup;
+    EvictionHandler                                                     _evictionHandler;
+};
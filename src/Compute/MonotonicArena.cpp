@@ -0,0 +1,60 @@
+#include "MonotonicArena.h"
+
+#include <algorithm>
+
+namespace
+{
+    // Blocks are allocated with the alignment of operator new, larger alignments are not supported
+    constexpr std::size_t MAX_ALIGNMENT = alignof(std::max_align_t);
+}
+
+MonotonicArena::MonotonicArena(std::size_t initialCapacity) :
+    _offset(0),
+    _used(0),
+    _capacity(0)
+{
+    addBlock(std::max(initialCapacity, MAX_ALIGNMENT));
+}
+
+void* MonotonicArena::allocateBytes(std::size_t size, std::size_t alignment)
+{
+    alignment = std::min(alignment, MAX_ALIGNMENT);
+
+    std::size_t offset = (_offset + alignment - 1) & ~(alignment - 1);
+    if (offset + size > _blocks.back().size)
+    {
+        // Grow geometrically so a growing interaction needs few blocks
+        addBlock(std::max(size, 2 * _blocks.back().size));
+        offset = 0;
+    }
+
+    _used += size + (offset - _offset);
+    _offset = offset + size;
+    return _blocks.back().data.get() + offset;
+}
+
+void MonotonicArena::addBlock(std::size_t minSize)
+{
+    Block block;
+    block.data.reset(new std::byte[minSize]);
+    block.size = minSize;
+
+    _capacity += minSize;
+    _blocks.push_back(std::move(block));
+    _offset = 0;
+}
+
+void MonotonicArena::reset()
+{
+    // Coalesce into a single block that fits everything the last interaction needed
+    if (_blocks.size() > 1)
+    {
+        std::size_t capacity = _capacity;
+        _blocks.clear();
+        _capacity = 0;
+        addBlock(capacity);
+    }
+
+    _offset = 0;
+    _used = 0;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Bump allocator for the scratch memory of a single interaction, such as one hover selection.
+ *
+ * Memory is handed out from large blocks and only released all at once by reset(). When an
+ * interaction needed more than one block, reset() replaces them by a single block of their
+ * combined size, so once the largest interaction has been seen no more heap allocations are
+ * made. Only trivially copyable types are handed out, no constructors or destructors are run.
+ * Not thread-safe, allocate before a parallel region and hand the memory to the threads.
+ *
+ *   arena.reset();
+ *   std::uint64_t* visited = arena.allocate<std::uint64_t>(numWords);
+ */
+class MonotonicArena
+{
+public:
+    explicit MonotonicArena(std::size_t initialCapacity = 64 * 1024);
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    /** Uninitialized memory for count values of T, valid until the next reset() */
+    template<typename T>
+    T* allocate(std::size_t count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value, "Arena memory is never constructed or destroyed");
+        return static_cast<T*>(allocateBytes(count * sizeof(T), alignof(T)));
+    }
+
+    /** Release everything allocated since the last reset */
+    void reset();
+
+    /** Bytes allocated since the last reset */
+    std::size_t getUsed() const { return _used; }
+
+    /** Bytes held by the arena */
+    std::size_t getCapacity() const { return _capacity; }
+
+private:
+    struct Block
+    {
+        std::unique_ptr<std::byte[]>    data;
+        std::size_t                     size;
+    };
+
+    void* allocateBytes(std::size_t size, std::size_t alignment);
+    void addBlock(std::size_t minSize);
+
+private:
+    std::vector<Block>  _blocks;
+    std::size_t         _offset;        /** Position in the last block */
+    std::size_t         _used;
+    std::size_t         _capacity;
+};
@@ -0,0 +1,137 @@
+#include "PointGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void PointGrid::build(const DataMatrix& projection)
+{
+    int numPoints = (int) projection.rows();
+
+    clear();
+    if (numPoints == 0)
+        return;
+
+    float maxX = -std::numeric_limits<float>::max();
+    float maxY = -std::numeric_limits<float>::max();
+    _minX = std::numeric_limits<float>::max();
+    _minY = std::numeric_limits<float>::max();
+    for (int i = 0; i < numPoints; i++)
+    {
+        _minX = std::min(_minX, projection(i, 0));
+        _minY = std::min(_minY, projection(i, 1));
+        maxX = std::max(maxX, projection(i, 0));
+        maxY = std::max(maxY, projection(i, 1));
+    }
+
+    // Square cells with about two points per cell if the points were spread evenly
+    float width = std::max(maxX - _minX, 1e-6f);
+    float height = std::max(maxY - _minY, 1e-6f);
+    float cellSize = std::sqrt(width * height * 2 / numPoints);
+    _resolutionX = std::clamp((int) std::ceil(width / cellSize), 1, 4096);
+    _resolutionY = std::clamp((int) std::ceil(height / cellSize), 1, 4096);
+    _cellWidth = width / _resolutionX;
+    _cellHeight = height / _resolutionY;
+
+    std::vector<int> pointCells(numPoints);
+    _cellOffsets.assign((size_t) _resolutionX * _resolutionY + 1, 0);
+    for (int i = 0; i < numPoints; i++)
+    {
+        pointCells[i] = cellY(projection(i, 1)) * _resolutionX + cellX(projection(i, 0));
+        _cellOffsets[pointCells[i] + 1]++;
+    }
+    for (int c = 0; c < _resolutionX * _resolutionY; c++)
+        _cellOffsets[c + 1] += _cellOffsets[c];
+
+    std::vector<int> fill(_cellOffsets.begin(), _cellOffsets.end() - 1);
+    _cellPoints.resize(numPoints);
+    _positions.resize((size_t) numPoints * 2);
+    for (int i = 0; i < numPoints; i++)
+    {
+        int slot = fill[pointCells[i]]++;
+        _cellPoints[slot] = i;
+        _positions[slot * 2 + 0] = projection(i, 0);
+        _positions[slot * 2 + 1] = projection(i, 1);
+    }
+}
+
+void PointGrid::clear()
+{
+    _resolutionX = 0;
+    _resolutionY = 0;
+    _cellOffsets.clear();
+    _cellPoints.clear();
+    _positions.clear();
+}
+
+int PointGrid::cellX(float x) const
+{
+    return std::clamp((int) ((x - _minX) / _cellWidth), 0, _resolutionX - 1);
+}
+
+int PointGrid::cellY(float y) const
+{
+    return std::clamp((int) ((y - _minY) / _cellHeight), 0, _resolutionY - 1);
+}
+
+int PointGrid::findNearest(float x, float y, float scaleX, float scaleY, const std::vector<int>& ids) const
+{
+    if (_cellPoints.empty())
+        return -1;
+
+    int qx = cellX(x);
+    int qy = cellY(y);
+
+    int closest = -1;
+    float minDist = std::numeric_limits<float>::max();
+
+    auto visitCell = [&](int cx, int cy)
+    {
+        int cell = cy * _resolutionX + cx;
+        for (int slot = _cellOffsets[cell]; slot < _cellOffsets[cell + 1]; slot++)
+        {
+            int point = _cellPoints[slot];
+            if (!ids.empty() && ids[point] < 0)
+                continue;
+
+            float dx = (_positions[slot * 2 + 0] - x) * scaleX;
+            float dy = (_positions[slot * 2 + 1] - y) * scaleY;
+            float dist = dx * dx + dy * dy;
+            if (dist < minDist)
+            {
+                minDist = dist;
+                closest = point;
+            }
+        }
+    };
+
+    int maxRing = std::max(_resolutionX, _resolutionY);
+    for (int ring = 0; ring <= maxRing; ring++)
+    {
+        // Visit the cells at Chebyshev distance ring from the query cell
+        for (int cy = qy - ring; cy <= qy + ring; cy++)
+        {
+            if (cy < 0 || cy >= _resolutionY)
+                continue;
+
+            bool edgeRow = cy == qy - ring || cy == qy + ring;
+            for (int cx = qx - ring; cx <= qx + ring; cx += edgeRow ? 1 : 2 * ring)
+            {
+                if (cx >= 0 && cx < _resolutionX)
+                    visitCell(cx, cy);
+                if (ring == 0)
+                    break;
+            }
+        }
+
+        // Points in the next rings are at least ring cells away along one of the axes
+        float bound = std::min(ring * _cellWidth * std::abs(scaleX), ring * _cellHeight * std::abs(scaleY));
+        if (closest >= 0 && minDist <= bound * bound)
+            break;
+    }
+
+    if (closest < 0)
+        return -1;
+
+    return ids.empty() ? closest : ids[closest];
+}
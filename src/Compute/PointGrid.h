@@ -0,0 +1,45 @@
+#pragma once
+
+#include "DataMatrix.h"
+
+#include <vector>
+
+/**
+ * Uniform grid over the 2D positions of a projection for nearest point queries. Points are
+ * bucketed by cell in a compressed layout, queries visit rings of cells around the query
+ * position until no closer point can be found.
+ */
+class PointGrid
+{
+public:
+    /** Bucket the first two columns of the projection, roughly two points per cell */
+    void build(const DataMatrix& projection);
+
+    void clear();
+
+    int getNumPoints() const { return (int) _positions.size() / 2; }
+
+    /**
+     * Find the point closest to the given position in projection coordinates
+     * @param scaleX, scaleY Scale of both axes in the distance metric, e.g. to measure distances in pixels
+     * @param ids Optional id of each point, points with a negative id are skipped
+     * @return Id of the closest point, or its index if no ids are given, -1 if there are no candidates
+     */
+    int findNearest(float x, float y, float scaleX, float scaleY, const std::vector<int>& ids = std::vector<int>()) const;
+
+private:
+    int cellX(float x) const;
+    int cellY(float y) const;
+
+private:
+    int                 _resolutionX = 0;
+    int                 _resolutionY = 0;
+    float               _minX = 0;
+    float               _minY = 0;
+    float               _cellWidth = 1;
+    float               _cellHeight = 1;
+
+    std::vector<int>    _cellOffsets;       /** Offsets of each cell into _cellPoints */
+    std::vector<int>    _cellPoints;        /** Point indices ordered by cell */
+    std::vector<float>  _positions;         /** Interleaved x and y ordered like _cellPoints */
+};
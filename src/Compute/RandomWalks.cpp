@@ -2,7 +2,6 @@
 
 #include "KnnGraph.h"
 
-#include <QDebug>
 #include <random>
 
 std::default_random_engine generator;
@@ -28,7 +27,7 @@ namespace hdps
             return itemFromLeft;
         }
 
-        void doRandomWalks(const DataMatrix& highDim, const DataMatrix& spatialMap, int selectedPoint, std::vector<std::vector<Vector2f>>& randomWalks)
+        void doRandomWalks(const DataMatrix& highDim, const DataMatrix& spatialMap, int selectedPoint, std::vector<std::vector<Eigen::Vector2f>>& randomWalks)
         {
             int numDimensions = highDim.cols();
 
@@ -50,7 +49,7 @@ namespace hdps
                 // Iterations
                 for (int i = 0; i < 10; i++)
                 {
-                    randomWalks[w][i] = Vector2f(spatialMap(currentNode, 0), spatialMap(currentNode, 1));
+                    randomWalks[w][i] = Eigen::Vector2f(spatialMap(currentNode, 0), spatialMap(currentNode, 1));
                     float probSum = 0;
                     float cdfSum = 0;
                     for (int j = 0; j < highDim.rows(); j++)
@@ -119,7 +118,7 @@ namespace hdps
             }
         }
 
-        void traceLineage(const DataMatrix& data, const std::vector<std::vector<int>>& floodFill, std::vector<Vector2f>& positions, int seedIndex, std::vector<int>& lineage)
+        void traceLineage(const DataMatrix& data, const std::vector<std::vector<int>>& floodFill, std::vector<Eigen::Vector2f>& positions, int seedIndex, std::vector<int>& lineage)
         {
             bigint numFloodNodes = 0;
             for (int i = 0; i < floodFill.size(); i++)
@@ -139,17 +138,17 @@ namespace hdps
             }
 
             int currentNode = seedIndex;
-            Vector2f currentNodePos = positions[seedIndex];
+            Eigen::Vector2f currentNodePos = positions[seedIndex];
 
             // Determine initial direction
-            Vector2f sumPos(0, 0);
+            Eigen::Vector2f sumPos(0, 0);
             for (int i = 0; i < floodNodes.size(); i++)
             {
                 sumPos += positions[floodNodes[i]];
             }
-            sumPos = sumPos / floodNodes.size();
-            Vector2f initDir(0, 0);// = (sumPos - currentNodePos) / (sumPos - currentNodePos).length();
-            Vector2f currentDir = initDir;
+            sumPos = sumPos / (float) floodNodes.size();
+            Eigen::Vector2f initDir(0, 0);// = (sumPos - currentNodePos) / (sumPos - currentNodePos).norm();
+            Eigen::Vector2f currentDir = initDir;
 
             // Find neighbours
             while (lineage.size() < 10)
@@ -161,8 +160,8 @@ namespace hdps
 
                     if (floodIndex == currentNode) continue;
 
-                    Vector2f nodePos = positions[floodIndex];
-                    if (abs(nodePos.x - currentNodePos.x) < 1.1f && abs(nodePos.y - currentNodePos.y) < 1.1f)
+                    Eigen::Vector2f nodePos = positions[floodIndex];
+                    if (abs(nodePos.x() - currentNodePos.x()) < 1.1f && abs(nodePos.y() - currentNodePos.y()) < 1.1f)
                     {
                         neighbours.push_back(floodIndex);
                     }
@@ -172,15 +171,15 @@ namespace hdps
 
                 // Calculate probabilities based on cosine similarity to current direction
                 std::vector<float> probs(neighbours.size());
-                std::vector<Vector2f> dirs(neighbours.size());
+                std::vector<Eigen::Vector2f> dirs(neighbours.size());
                 float totalProb = 0;
                 for (int i = 0; i < neighbours.size(); i++)
                 {
-                    Vector2f loc = positions[neighbours[i]];
-                    Vector2f dir = (loc - currentNodePos) / (loc - currentNodePos).length();
+                    Eigen::Vector2f loc = positions[neighbours[i]];
+                    Eigen::Vector2f dir = (loc - currentNodePos) / (loc - currentNodePos).norm();
                     dirs[i] = dir;
 
-                    float sim = (currentDir.x * dir.x + currentDir.y * dir.y) / (dir.length());
+                    float sim = (currentDir.x() * dir.x() + currentDir.y() * dir.y()) / (dir.norm());
                     if (sim <= 0) sim = 0.001f;
                     probs[i] = sim;
                     totalProb += sim;
@@ -1,7 +1,6 @@
 #pragma once
 
 #include "DataMatrix.h"
-#include "graphics/Vector2f.h"
 
 #include <vector>
 
@@ -13,10 +12,10 @@ namespace hdps
     {
         int binarySearchCDF(const std::vector<float>& cdf, float u);
 
-        void doRandomWalks(const DataMatrix& highDim, const DataMatrix& spatialMap, int selectedPoint, std::vector<std::vector<Vector2f>>& randomWalks);
+        void doRandomWalks(const DataMatrix& highDim, const DataMatrix& spatialMap, int selectedPoint, std::vector<std::vector<Eigen::Vector2f>>& randomWalks);
 
         void doRandomWalksKNN(const DataMatrix& highDim, const DataMatrix& spatialMap, const KnnGraph& knnGraph, int selectedPoint, std::vector<std::vector<int>>& randomWalks);
 
-        void traceLineage(const DataMatrix& data, const std::vector<std::vector<int>>& floodFill, std::vector<Vector2f>& positions, int seedIndex, std::vector<int>& lineage);
+        void traceLineage(const DataMatrix& data, const std::vector<std::vector<int>>& floodFill, std::vector<Eigen::Vector2f>& positions, int seedIndex, std::vector<int>& lineage);
     }
 }
@@ -0,0 +1,271 @@
+#include "RankingAtlas.h"
+
+#include "ComputeProgress.h"
+#include "DimensionRanking.h"
+#include "HoverPipeline.h"
+#include "TaskScheduler.h"
+#include "Tracing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+
+namespace
+{
+    // Points ranked between progress updates
+    constexpr int BATCH_SIZE = 1024;
+
+    // Points per chunk of the scheduler, rankings of neighbouring points cost about the same
+    constexpr int GRAIN_SIZE = 16;
+
+    /** Float to IEEE half precision, rounded to nearest even, out of range values saturate to infinity */
+    std::uint16_t toHalf(float value)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        std::uint32_t sign = (bits >> 16) & 0x8000;
+        std::uint32_t exponent = (bits >> 23) & 0xff;
+        std::uint32_t mantissa = bits & 0x7fffff;
+
+        // Infinity and NaN, NaN keeps a mantissa bit
+        if (exponent == 0xff)
+            return (std::uint16_t) (sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));
+
+        int halfExponent = (int) exponent - 127 + 15;
+        if (halfExponent >= 31)
+            return (std::uint16_t) (sign | 0x7c00);
+
+        if (halfExponent <= 0)
+        {
+            // Subnormal half, or zero when even the implicit bit is shifted out
+            if (halfExponent < -10)
+                return (std::uint16_t) sign;
+
+            mantissa |= 0x800000;
+            int shift = 14 - halfExponent;
+            std::uint32_t half = mantissa >> shift;
+            std::uint32_t remainder = mantissa & ((1u << shift) - 1);
+            std::uint32_t halfway = 1u << (shift - 1);
+            if (remainder > halfway || (remainder == halfway && (half & 1)))
+                half++;
+            return (std::uint16_t) (sign | half);
+        }
+
+        // A carry out of the mantissa rounds up into the exponent, up to infinity
+        std::uint32_t half = ((std::uint32_t) halfExponent << 10) | (mantissa >> 13);
+        std::uint32_t remainder = mantissa & 0x1fff;
+        if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+            half++;
+        return (std::uint16_t) (sign | half);
+    }
+
+    float fromHalf(std::uint16_t half)
+    {
+        std::uint32_t sign = (std::uint32_t) (half & 0x8000) << 16;
+        std::uint32_t exponent = (half >> 10) & 0x1f;
+        std::uint32_t mantissa = half & 0x3ff;
+
+        if (exponent == 0)
+        {
+            float value = std::ldexp((float) mantissa, -24);
+            return sign != 0 ? -value : value;
+        }
+
+        std::uint32_t bits;
+        if (exponent == 31)
+            bits = sign | 0x7f800000 | (mantissa << 13);
+        else
+            bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    /** Pipeline and buffers of one scheduler slot, so slots rank points independently */
+    struct RankingWorker
+    {
+        HoverPipeline       pipeline;
+        FloodFill           floodFill = FloodFill(0);
+        FloodWorkingSet     workingSet;
+        std::vector<int>    dimRanking;
+    };
+}
+
+bool RankingAtlas::Settings::operator==(const Settings& other) const
+{
+    return filterType == other.filterType &&
+        restrictToFlood == other.restrictToFlood &&
+        numWaves == other.numWaves &&
+        innerFilterRadius == other.innerFilterRadius &&
+        outerFilterRadius == other.outerFilterRadius &&
+        hdInnerFilterSize == other.hdInnerFilterSize &&
+        projectionSize == other.projectionSize;
+}
+
+RankingAtlas::Settings RankingAtlas::makeSettings(const HoverSettings& settings)
+{
+    Settings atlasSettings;
+    atlasSettings.filterType = settings.filterType;
+    atlasSettings.restrictToFlood = settings.filterType == filters::FilterType::SPATIAL_PEAK && settings.restrictToFlood;
+    atlasSettings.numWaves = needsFlood(settings) ? settings.numWaves : 0;
+
+    switch (settings.filterType)
+    {
+    case filters::FilterType::SPATIAL_PEAK:
+        atlasSettings.innerFilterRadius = settings.innerFilterRadius;
+        atlasSettings.outerFilterRadius = settings.outerFilterRadius;
+        atlasSettings.projectionSize = settings.projectionSize;
+        break;
+    case filters::FilterType::HD_PEAK:
+        atlasSettings.hdInnerFilterSize = settings.hdInnerFilterSize;
+        break;
+    }
+
+    return atlasSettings;
+}
+
+bool RankingAtlas::needsFlood(const HoverSettings& settings)
+{
+    return settings.filterType == filters::FilterType::HD_PEAK || settings.restrictToFlood;
+}
+
+bool RankingAtlas::isSupported(const HoverSettings& settings, const HoverInputs& inputs)
+{
+    if (inputs.data == nullptr || inputs.data->rows() == 0 || inputs.data->cols() > MAX_DIMENSIONS)
+        return false;
+
+    // Without a graph the hover pipeline ranks on whatever flood it has left, which can't be precomputed
+    return !needsFlood(settings) || (settings.graphAvailable && inputs.knnGraph != nullptr);
+}
+
+bool RankingAtlas::build(const HoverSettings& settings, const HoverInputs& inputs, const std::vector<int>& seedPoints, int topK, ComputeProgress* progress)
+{
+    TRACE_SCOPE("Build ranking atlas");
+
+    *this = RankingAtlas();
+
+    int numPoints = (int) inputs.data->rows();
+    int numDimensions = (int) inputs.data->cols();
+    topK = std::clamp(topK, 1, numDimensions);
+
+    HoverSettings rankingSettings = settings;
+    rankingSettings.numRankedDimensions = topK;
+    bool flood = needsFlood(settings);
+
+    std::vector<std::uint16_t> dimensions((std::size_t) numPoints * topK);
+    std::vector<std::uint16_t> scores((std::size_t) numPoints * topK);
+
+    // Pipelines are large, only the slots that run are given one
+    std::vector<std::unique_ptr<RankingWorker>> workers(tasks::getNumSlots());
+
+    const auto isCancelled = [progress]() { return progress && progress->isCancelled(); };
+
+    for (int batchBegin = 0; batchBegin < numPoints; batchBegin += BATCH_SIZE)
+    {
+        int batchEnd = std::min(batchBegin + BATCH_SIZE, numPoints);
+        tasks::parallelForRanges(batchBegin, batchEnd, GRAIN_SIZE, [&](int begin, int end, int slot)
+        {
+            if (workers[slot] == nullptr)
+                workers[slot] = std::make_unique<RankingWorker>();
+            RankingWorker& worker = *workers[slot];
+
+            for (int p = begin; p < end; p++)
+            {
+                // Checked per point, so a cancelled build stops after the points in progress
+                if (isCancelled())
+                    return;
+
+                if (flood)
+                    worker.pipeline.computeFlood(rankingSettings, inputs, seedPoints.empty() ? p : seedPoints[p], worker.floodFill, worker.workingSet);
+                worker.pipeline.computeRanking(rankingSettings, inputs, p, worker.floodFill, worker.workingSet, worker.dimRanking);
+
+                const std::vector<float>& rankingScores = worker.pipeline.getRankingScores(settings.filterType);
+
+                std::size_t offset = (std::size_t) p * topK;
+                for (int k = 0; k < topK; k++)
+                {
+                    int dimension = worker.dimRanking[k];
+                    dimensions[offset + k] = (std::uint16_t) dimension;
+                    scores[offset + k] = toHalf(rankingScores[dimension]);
+                }
+            }
+        });
+
+        if (isCancelled())
+            return false;
+
+        if (progress)
+            progress->setStageProgress((float) batchEnd / numPoints);
+    }
+
+    _settings = makeSettings(settings);
+    _versions = settings.inputVersions;
+    _needsFlood = flood;
+    _numPoints = numPoints;
+    _numDimensions = numDimensions;
+    _topK = topK;
+    _dimensions = std::move(dimensions);
+    _scores = std::move(scores);
+    return true;
+}
+
+bool RankingAtlas::matches(const HoverSettings& settings) const
+{
+    if (isEmpty())
+        return false;
+
+    // A full ranking can only be answered when every dimension was ranked
+    int numRanked = settings.numRankedDimensions == filters::FULL_RANKING ? _numDimensions : settings.numRankedDimensions;
+    if (numRanked > _topK)
+        return false;
+
+    return isCurrent(settings.inputVersions) && makeSettings(settings) == _settings;
+}
+
+bool RankingAtlas::isCurrent(const SelectionInputVersions& versions) const
+{
+    return versions.data == _versions.data && versions.mask == _versions.mask && (!_needsFlood || versions.graph == _versions.graph);
+}
+
+void RankingAtlas::getRanking(nint point, int numRanked, std::vector<int>& dimRanking) const
+{
+    numRanked = numRanked == filters::FULL_RANKING ? _topK : std::min(numRanked, _topK);
+
+    const std::uint16_t* entries = _dimensions.data() + (std::size_t) point * _topK;
+    dimRanking.assign(entries, entries + numRanked);
+}
+
+float RankingAtlas::getScore(nint point, int rank) const
+{
+    return fromHalf(_scores[(std::size_t) point * _topK + rank]);
+}
+
+bool RankingAtlas::restore(const Settings& settings, const SelectionInputVersions& versions, int numPoints, int numDimensions, int topK, std::vector<std::uint16_t> dimensions, std::vector<std::uint16_t> scores)
+{
+    std::size_t numEntries = (std::size_t) numPoints * topK;
+    if (numPoints <= 0 || numDimensions <= 0 || numDimensions > MAX_DIMENSIONS || topK <= 0 || topK > numDimensions ||
+        dimensions.size() != numEntries || scores.size() != numEntries)
+        return false;
+
+    // Entries come from a project file, ids beyond the dimensions would index out of bounds
+    if (std::any_of(dimensions.begin(), dimensions.end(), [numDimensions](std::uint16_t dimension) { return dimension >= numDimensions; }))
+        return false;
+
+    _settings = settings;
+    _versions = versions;
+    _needsFlood = settings.filterType == filters::FilterType::HD_PEAK || settings.restrictToFlood;
+    _numPoints = numPoints;
+    _numDimensions = numDimensions;
+    _topK = topK;
+    _dimensions = std::move(dimensions);
+    _scores = std::move(scores);
+    return true;
+}
+
+void RankingAtlas::setInputVersions(const SelectionInputVersions& versions)
+{
+    _versions = versions;
+}
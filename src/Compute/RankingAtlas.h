@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Filters.h"
+#include "SelectionCache.h"
+#include "Types.h"
+
+#include <cstdint>
+#include <vector>
+
+struct HoverSettings;
+struct HoverInputs;
+class ComputeProgress;
+
+/**
+ * Top-K dimension ranking of every point for one set of filter settings, computed ahead of time
+ * so hovering looks rankings up instead of computing them.
+ *
+ * The rankings are computed with the same stages as the hover pipeline, so a lookup returns what
+ * hovering would have computed. Entries are compact, uint16 dimension ids and fp16 scores, so a
+ * million points with a top 16 take 64 MiB. An atlas only answers for the settings and input
+ * versions it was built with, changing a filter parameter, the data, graph or mask makes it miss.
+ */
+class RankingAtlas
+{
+public:
+    /** Ranked dimensions per point unless more are shown */
+    static constexpr int DEFAULT_TOP_K = 16;
+
+    /** Dimension ids are stored as uint16 */
+    static constexpr int MAX_DIMENSIONS = 65536;
+
+    /** Filter settings the rankings depend on, settings the filter doesn't use are left at zero */
+    struct Settings
+    {
+        filters::FilterType filterType = filters::FilterType::SPATIAL_PEAK;
+        bool                restrictToFlood = false;
+        int                 numWaves = 0;
+        float               innerFilterRadius = 0;
+        float               outerFilterRadius = 0;
+        int                 hdInnerFilterSize = 0;
+        float               projectionSize = 0;
+
+        bool operator==(const Settings& other) const;
+        bool operator!=(const Settings& other) const { return !(*this == other); }
+    };
+
+    static Settings makeSettings(const HoverSettings& settings);
+
+    /** Whether the ranking of a point depends on its flood, and so on the graph */
+    static bool needsFlood(const HoverSettings& settings);
+
+    /** Whether an atlas can be built for the settings and inputs */
+    static bool isSupported(const HoverSettings& settings, const HoverInputs& inputs);
+
+    /**
+     * Rank the dimensions of every point of the inputs in parallel batches, checking for cancellation between points
+     * @param seedPoints Flood seed of each point as the hover jobs use it, empty if points are their own seed
+     * @return False if the build was cancelled, the atlas is left empty then
+     */
+    bool build(const HoverSettings& settings, const HoverInputs& inputs, const std::vector<int>& seedPoints, int topK, ComputeProgress* progress = nullptr);
+
+    /** Whether the atlas holds the rankings a hover job with the settings computes */
+    bool matches(const HoverSettings& settings) const;
+
+    /** Whether the inputs the atlas depends on are still at the given versions */
+    bool isCurrent(const SelectionInputVersions& versions) const;
+
+    /** Top numRanked dimensions of the point, at most getTopK() */
+    void getRanking(nint point, int numRanked, std::vector<int>& dimRanking) const;
+    float getScore(nint point, int rank) const;
+
+    bool isEmpty() const { return _numPoints == 0; }
+    int getNumPoints() const { return _numPoints; }
+    int getNumDimensions() const { return _numDimensions; }
+    int getTopK() const { return _topK; }
+    const Settings& getSettings() const { return _settings; }
+
+    /** Entries per point, topK dimension ids and topK fp16 scores, to persist the atlas */
+    const std::vector<std::uint16_t>& getDimensions() const { return _dimensions; }
+    const std::vector<std::uint16_t>& getScores() const { return _scores; }
+
+    /**
+     * Restore a persisted atlas, it answers for the given input versions from then on
+     * @return False if the sizes of the entries don't match
+     */
+    bool restore(const Settings& settings, const SelectionInputVersions& versions, int numPoints, int numDimensions, int topK, std::vector<std::uint16_t> dimensions, std::vector<std::uint16_t> scores);
+
+    /** Adopt the atlas for new input versions, once the inputs are known to be the ones it was built from */
+    void setInputVersions(const SelectionInputVersions& versions);
+
+private:
+    Settings                    _settings;
+    SelectionInputVersions      _versions;
+    bool                        _needsFlood = false;
+    int                         _numPoints = 0;
+    int                         _numDimensions = 0;
+    int                         _topK = 0;
+    std::vector<std::uint16_t>  _dimensions;
+    std::vector<std::uint16_t>  _scores;        /** IEEE half precision */
+};
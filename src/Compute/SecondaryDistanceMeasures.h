@@ -4,6 +4,8 @@
 #include <numeric>
 #include <bitset>
 #include <iostream>
+#include <unordered_map>
+#include <unordered_set>
 
 void computeSharedNeighboursBruteForce(const std::vector<std::vector<int>>& neighbours, std::vector<std::vector<int>>& _neighbours, int k)
 {
@@ -0,0 +1,214 @@
+#include "SelectionCache.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace
+{
+    // Histograms are large compared to floods and rankings
+    constexpr std::size_t HISTOGRAM_CACHE_DIVISOR = 4;
+
+    template<typename T>
+    void hashCombine(std::size_t& seed, const T& value)
+    {
+        seed ^= std::hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+}
+
+bool FloodKey::operator==(const FloodKey& other) const
+{
+    return seedPoint == other.seedPoint &&
+        graphVersion == other.graphVersion &&
+        maskVersion == other.maskVersion &&
+        numWaves == other.numWaves;
+}
+
+bool RankingKey::operator==(const RankingKey& other) const
+{
+    return flood == other.flood &&
+        selectedPoint == other.selectedPoint &&
+        dataVersion == other.dataVersion &&
+        filterType == other.filterType &&
+        restrictToFlood == other.restrictToFlood &&
+        numRankedDimensions == other.numRankedDimensions &&
+        innerFilterRadius == other.innerFilterRadius &&
+        outerFilterRadius == other.outerFilterRadius &&
+        hdInnerFilterSize == other.hdInnerFilterSize &&
+        projectionSize == other.projectionSize;
+}
+
+bool HistogramKey::operator==(const HistogramKey& other) const
+{
+    return flood == other.flood &&
+        dataVersion == other.dataVersion &&
+        numBins == other.numBins;
+}
+
+std::size_t FloodKeyHash::operator()(const FloodKey& key) const
+{
+    std::size_t seed = 0;
+    hashCombine(seed, key.seedPoint);
+    hashCombine(seed, key.graphVersion);
+    hashCombine(seed, key.maskVersion);
+    hashCombine(seed, key.numWaves);
+    return seed;
+}
+
+std::size_t RankingKeyHash::operator()(const RankingKey& key) const
+{
+    std::size_t seed = FloodKeyHash()(key.flood);
+    hashCombine(seed, key.selectedPoint);
+    hashCombine(seed, key.dataVersion);
+    hashCombine(seed, (int) key.filterType);
+    hashCombine(seed, key.restrictToFlood);
+    hashCombine(seed, key.numRankedDimensions);
+    hashCombine(seed, key.innerFilterRadius);
+    hashCombine(seed, key.outerFilterRadius);
+    hashCombine(seed, key.hdInnerFilterSize);
+    hashCombine(seed, key.projectionSize);
+    return seed;
+}
+
+std::size_t HistogramKeyHash::operator()(const HistogramKey& key) const
+{
+    std::size_t seed = FloodKeyHash()(key.flood);
+    hashCombine(seed, key.dataVersion);
+    hashCombine(seed, key.numBins);
+    return seed;
+}
+
+SelectionCache::SelectionCache(std::size_t capacity) :
+    _floods(capacity),
+    _rankings(capacity),
+    _histograms(std::max<std::size_t>(capacity / HISTOGRAM_CACHE_DIVISOR, 1)),
+    _lookups(0),
+    _hits(0),
+    _prefetched(0),
+    _prefetchHits(0),
+    _prefetchWasted(0)
+{
+    _floods.setEvictionHandler([this](const FloodKey&, const FloodEntry& entry)
+    {
+        if (entry.speculative)
+            _prefetchWasted++;
+    });
+}
+
+void SelectionCache::invalidateData()
+{
+    _versions.data++;
+
+    // Floods only depend on the graphs and the mask
+    _rankings.clear();
+    _histograms.clear();
+}
+
+void SelectionCache::invalidateGraph()
+{
+    _versions.graph++;
+
+    _floods.clear();
+    _rankings.clear();
+    _histograms.clear();
+}
+
+void SelectionCache::invalidateMask()
+{
+    _versions.mask++;
+
+    _floods.clear();
+    _rankings.clear();
+    _histograms.clear();
+}
+
+void SelectionCache::invalidateAll()
+{
+    _versions.data++;
+    _versions.graph++;
+    _versions.mask++;
+
+    _floods.clear();
+    _rankings.clear();
+    _histograms.clear();
+}
+
+const FloodFill* SelectionCache::findFlood(const FloodKey& key)
+{
+    _lookups++;
+
+    FloodEntry* entry = _floods.find(key);
+    if (entry == nullptr)
+        return nullptr;
+
+    _hits++;
+    if (entry->speculative)
+    {
+        _prefetchHits++;
+        entry->speculative = false;
+    }
+
+    return &entry->floodFill;
+}
+
+const std::vector<int>* SelectionCache::findRanking(const RankingKey& key)
+{
+    _lookups++;
+
+    const std::vector<int>* dimRanking = _rankings.find(key);
+    if (dimRanking != nullptr)
+        _hits++;
+
+    return dimRanking;
+}
+
+const std::vector<std::vector<int>>* SelectionCache::findHistograms(const HistogramKey& key)
+{
+    _lookups++;
+
+    const std::vector<std::vector<int>>* bins = _histograms.find(key);
+    if (bins != nullptr)
+        _hits++;
+
+    return bins;
+}
+
+void SelectionCache::insertFlood(const FloodKey& key, const FloodFill& floodFill, bool speculative)
+{
+    if (speculative)
+        _prefetched++;
+
+    // Copied into the storage of the evicted entries, so a full cache doesn't allocate
+    FloodEntry& entry = _floods.insertForOverwrite(key);
+    entry.floodFill = floodFill;
+    entry.speculative = speculative;
+}
+
+void SelectionCache::insertRanking(const RankingKey& key, const std::vector<int>& dimRanking)
+{
+    _rankings.insertForOverwrite(key) = dimRanking;
+}
+
+void SelectionCache::insertHistograms(const HistogramKey& key, const std::vector<std::vector<int>>& bins)
+{
+    _histograms.insertForOverwrite(key) = bins;
+}
+
+SelectionCache::Stats SelectionCache::getStats() const
+{
+    Stats stats;
+    stats.lookups = _lookups;
+    stats.hits = _hits;
+    stats.prefetched = _prefetched;
+    stats.prefetchHits = _prefetchHits;
+    stats.prefetchWasted = _prefetchWasted;
+    return stats;
+}
+
+void SelectionCache::resetStats()
+{
+    _lookups = 0;
+    _hits = 0;
+    _prefetched = 0;
+    _prefetchHits = 0;
+    _prefetchWasted = 0;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "FloodFill.h"
+#include "Filters.h"
+#include "LruCache.h"
+#include "Types.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/** Versions of the inputs of the hover pipeline, bumped through the invalidation functions of SelectionCache */
+struct SelectionInputVersions
+{
+    std::uint64_t       data = 0;               /** Data, normalized data and projection */
+    std::uint64_t       graph = 0;              /** kNN graphs */
+    std::uint64_t       mask = 0;               /** Mask and data view */
+};
+
+/** Everything a flood depends on */
+struct FloodKey
+{
+    nint                seedPoint = 0;
+    std::uint64_t       graphVersion = 0;
+    std::uint64_t       maskVersion = 0;
+    int                 numWaves = 0;
+
+    bool operator==(const FloodKey& other) const;
+};
+
+/** Everything a dimension ranking depends on */
+struct RankingKey
+{
+    FloodKey            flood;
+    nint                selectedPoint = 0;
+    std::uint64_t       dataVersion = 0;
+    filters::FilterType filterType = filters::FilterType::SPATIAL_PEAK;
+    bool                restrictToFlood = false;
+    int                 numRankedDimensions = 0;
+    float               innerFilterRadius = 0;
+    float               outerFilterRadius = 0;
+    int                 hdInnerFilterSize = 0;
+    float               projectionSize = 0;
+
+    bool operator==(const RankingKey& other) const;
+};
+
+/** Everything the flood node histograms depend on */
+struct HistogramKey
+{
+    FloodKey            flood;
+    std::uint64_t       dataVersion = 0;
+    int                 numBins = 0;
+
+    bool operator==(const HistogramKey& other) const;
+};
+
+struct FloodKeyHash { std::size_t operator()(const FloodKey& key) const; };
+struct RankingKeyHash { std::size_t operator()(const RankingKey& key) const; };
+struct HistogramKeyHash { std::size_t operator()(const HistogramKey& key) const; };
+
+/**
+ * Results of recent selections per stage of the hover pipeline: floods, dimension rankings and
+ * flood node histograms. Each stage is keyed by what it depends on, so re-selecting a point with
+ * other settings only recomputes the stages those settings affect. Floods can be computed ahead
+ * of time for where the cursor is expected to go.
+ *
+ * The invalidation functions must be called, while the hover worker is idle, whenever the data,
+ * graphs or mask change. They bump the version of that input and drop the results depending on it.
+ * Lookups and speculative work are counted, only the statistics may be read from another thread.
+ */
+class SelectionCache
+{
+public:
+    struct Stats
+    {
+        std::uint64_t lookups = 0;
+        std::uint64_t hits = 0;
+        std::uint64_t prefetched = 0;           /** Speculative floods computed */
+        std::uint64_t prefetchHits = 0;         /** Speculative floods that were used */
+        std::uint64_t prefetchWasted = 0;       /** Speculative floods dropped without being used */
+    };
+
+    explicit SelectionCache(std::size_t capacity);
+
+    SelectionCache(const SelectionCache&) = delete;
+    SelectionCache& operator=(const SelectionCache&) = delete;
+
+    const SelectionInputVersions& getVersions() const { return _versions; }
+
+    void invalidateData();
+    void invalidateGraph();
+    void invalidateMask();
+    void invalidateAll();
+
+    /** Look up results for use, nullptr if they are not cached */
+    const FloodFill* findFlood(const FloodKey& key);
+    const std::vector<int>* findRanking(const RankingKey& key);
+    const std::vector<std::vector<int>>* findHistograms(const HistogramKey& key);
+
+    bool containsFlood(const FloodKey& key) const { return _floods.contains(key); }
+    bool containsRanking(const RankingKey& key) const { return _rankings.contains(key); }
+
+    void insertFlood(const FloodKey& key, const FloodFill& floodFill, bool speculative);
+    void insertRanking(const RankingKey& key, const std::vector<int>& dimRanking);
+    void insertHistograms(const HistogramKey& key, const std::vector<std::vector<int>>& bins);
+
+    Stats getStats() const;
+    void resetStats();
+
+private:
+    struct FloodEntry
+    {
+        FloodFill   floodFill = FloodFill(0);
+        bool        speculative = false;        /** Computed ahead of time and not used yet */
+    };
+
+    SelectionInputVersions                                                      _versions;
+
+    LruCache<FloodKey, FloodEntry, FloodKeyHash>                                _floods;
+    LruCache<RankingKey, std::vector<int>, RankingKeyHash>                      _rankings;
+    LruCache<HistogramKey, std::vector<std::vector<int>>, HistogramKeyHash>     _histograms;
+
+    std::atomic<std::uint64_t>  _lookups;
+    std::atomic<std::uint64_t>  _hits;
+    std::atomic<std::uint64_t>  _prefetched;
+    std::atomic<std::uint64_t>  _prefetchHits;
+    std::atomic<std::uint64_t>  _prefetchWasted;
+};
@@ -0,0 +1,371 @@
+#include "TaskScheduler.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace tasks
+{
+    namespace
+    {
+        // Loops that can be joined at the same time, more loops still run but only on their own thread
+        constexpr int MAX_JOINABLE_LOOPS = 64;
+
+        // Chunks per thread when no grain size is given, enough to balance without much stealing
+        constexpr int CHUNKS_PER_SLOT = 8;
+
+        thread_local Priority currentPriority = Priority::BACKGROUND;
+        thread_local int currentDepth = 0;      /** Number of loops the chunk running on this thread is nested in */
+
+        /** Remaining range of a slot, relative to the start of the loop, as begin << 32 | end */
+        struct alignas(64) SlotRange
+        {
+            std::atomic<std::uint64_t> range;
+        };
+
+        std::uint64_t pack(std::uint32_t begin, std::uint32_t end) { return ((std::uint64_t) begin << 32) | end; }
+        std::uint32_t rangeBegin(std::uint64_t range) { return (std::uint32_t) (range >> 32); }
+        std::uint32_t rangeEnd(std::uint64_t range) { return (std::uint32_t) range; }
+        std::uint32_t rangeSize(std::uint64_t range) { return rangeEnd(range) > rangeBegin(range) ? rangeEnd(range) - rangeBegin(range) : 0; }
+
+        /** Priority and depth of the chunks of a loop, restored when the thread is done with it */
+        class LoopContext
+        {
+        public:
+            LoopContext(Priority priority, int depth) :
+                _previousPriority(currentPriority),
+                _previousDepth(currentDepth)
+            {
+                currentPriority = priority;
+                currentDepth = depth;
+            }
+
+            ~LoopContext()
+            {
+                currentPriority = _previousPriority;
+                currentDepth = _previousDepth;
+            }
+
+        private:
+            Priority    _previousPriority;
+            int         _previousDepth;
+        };
+    }
+
+    struct Scheduler::Loop
+    {
+        RangeFunction       function;
+        void*               context;
+        int                 begin;
+        Priority            priority;
+        int                 depth;
+        std::uint32_t       grainSize;
+        int                 numSlots;
+
+        // Guarded by the scheduler mutex
+        bool                joinable = false;
+        int                 freeSlots[MAX_SLOTS];
+        int                 numFreeSlots = 0;
+
+        std::atomic<int>    numWorkers{ 0 };    /** Workers taking part, the loop lives until they have left */
+        SlotRange           ranges[MAX_SLOTS];
+
+        bool hasWork() const
+        {
+            for (int s = 0; s < numSlots; s++)
+            {
+                if (rangeSize(ranges[s].range.load(std::memory_order_relaxed)) > 0)
+                    return true;
+            }
+            return false;
+        }
+
+        /** Take a chunk from the front of the own range */
+        bool takeChunk(int slot, std::uint32_t& chunkBegin, std::uint32_t& chunkEnd)
+        {
+            std::atomic<std::uint64_t>& range = ranges[slot].range;
+            std::uint64_t current = range.load(std::memory_order_acquire);
+            while (rangeSize(current) > 0)
+            {
+                std::uint32_t end = rangeEnd(current);
+                std::uint32_t newBegin = rangeSize(current) > grainSize ? rangeBegin(current) + grainSize : end;
+                if (range.compare_exchange_weak(current, pack(newBegin, end), std::memory_order_acq_rel))
+                {
+                    chunkBegin = rangeBegin(current);
+                    chunkEnd = newBegin;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /** Take the back half of the largest range of another slot, the first chunk is returned and the rest becomes the own range */
+        bool stealChunk(int slot, std::uint32_t& chunkBegin, std::uint32_t& chunkEnd)
+        {
+            while (true)
+            {
+                int victim = -1;
+                std::uint64_t victimRange = 0;
+                for (int s = 0; s < numSlots; s++)
+                {
+                    std::uint64_t range = ranges[s].range.load(std::memory_order_acquire);
+                    if (s != slot && rangeSize(range) > rangeSize(victimRange))
+                    {
+                        victim = s;
+                        victimRange = range;
+                    }
+                }
+
+                if (victim < 0)
+                    return false;
+
+                std::uint32_t begin = rangeBegin(victimRange);
+                std::uint32_t end = rangeEnd(victimRange);
+                std::uint32_t size = end - begin;
+
+                // Small ranges are taken whole, larger ones are split so the victim keeps the front half
+                std::uint32_t split = size <= grainSize ? begin : begin + size / 2;
+                if (!ranges[victim].range.compare_exchange_strong(victimRange, pack(begin, split), std::memory_order_acq_rel))
+                    continue;
+
+                chunkBegin = split;
+                chunkEnd = std::min(split + grainSize, end);
+                ranges[slot].range.store(pack(chunkEnd, end), std::memory_order_release);
+                return true;
+            }
+        }
+    };
+
+    Scheduler& Scheduler::global()
+    {
+        static Scheduler scheduler(std::max((int) std::thread::hardware_concurrency() - 1, 0));
+        return scheduler;
+    }
+
+    Scheduler::Scheduler(int numWorkers) :
+        _stopping(false),
+        _maxNesting(1)
+    {
+        numWorkers = std::clamp(numWorkers, 0, MAX_SLOTS - 1);
+
+        for (int p = 0; p < NUM_PRIORITIES; p++)
+        {
+            _loops[p].reserve(MAX_JOINABLE_LOOPS);
+            _demand[p].store(0, std::memory_order_relaxed);
+        }
+
+        // Background work leaves a core for the interactive work and the GUI
+        _threadBudgets[(int) Priority::INTERACTIVE].store(numWorkers + 1, std::memory_order_relaxed);
+        _threadBudgets[(int) Priority::BACKGROUND].store(std::max(numWorkers, 1), std::memory_order_relaxed);
+
+        _workers.reserve(numWorkers);
+        for (int w = 0; w < numWorkers; w++)
+            _workers.emplace_back(&Scheduler::runWorker, this);
+    }
+
+    Scheduler::~Scheduler()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _workAvailable.notify_all();
+
+        for (std::thread& worker : _workers)
+            worker.join();
+    }
+
+    void Scheduler::setThreadBudget(Priority priority, int numThreads)
+    {
+        _threadBudgets[(int) priority].store(std::clamp(numThreads, 1, MAX_SLOTS), std::memory_order_relaxed);
+    }
+
+    int Scheduler::getNumSlots() const
+    {
+        if (currentDepth >= getMaxNesting())
+            return 1;
+
+        return std::min({ getThreadBudget(currentPriority), getNumWorkers() + 1, MAX_SLOTS });
+    }
+
+    void Scheduler::parallelFor(int begin, int end, int grainSize, RangeFunction function, void* context)
+    {
+        if (end <= begin)
+            return;
+
+        std::uint32_t count = (std::uint32_t) (end - begin);
+        int numSlots = getNumSlots();
+        std::uint32_t grain = grainSize > 0 ? (std::uint32_t) grainSize : std::max(count / (numSlots * CHUNKS_PER_SLOT), 1u);
+        numSlots = (int) std::min<std::uint32_t>(numSlots, (count + grain - 1) / grain);
+
+        if (numSlots <= 1)
+        {
+            LoopContext loopContext(currentPriority, currentDepth + 1);
+            function(context, begin, end, 0);
+            return;
+        }
+
+        Loop loop;
+        loop.function = function;
+        loop.context = context;
+        loop.begin = begin;
+        loop.priority = currentPriority;
+        loop.depth = currentDepth;
+        loop.grainSize = grain;
+        loop.numSlots = numSlots;
+
+        // Every slot starts with an equal share, the shares of slots nobody joins are stolen
+        for (int s = 0; s < numSlots; s++)
+        {
+            std::uint32_t slotBegin = (std::uint32_t) ((std::uint64_t) count * s / numSlots);
+            std::uint32_t slotEnd = (std::uint32_t) ((std::uint64_t) count * (s + 1) / numSlots);
+            loop.ranges[s].range.store(pack(slotBegin, slotEnd), std::memory_order_relaxed);
+        }
+
+        // The calling thread has slot 0
+        for (int s = numSlots - 1; s > 0; s--)
+            loop.freeSlots[loop.numFreeSlots++] = s;
+
+        std::vector<Loop*>& loops = _loops[(int) loop.priority];
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (loops.size() < loops.capacity())
+            {
+                loops.push_back(&loop);
+                loop.joinable = true;
+                updateDemand(loop.priority, loop.numFreeSlots);
+            }
+        }
+        if (loop.joinable)
+            _workAvailable.notify_all();
+
+        participate(loop, 0, false);
+
+        if (loop.joinable)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            loops.erase(std::find(loops.begin(), loops.end(), &loop));
+            loop.joinable = false;
+            updateDemand(loop.priority, -loop.numFreeSlots);
+        }
+
+        // Workers still inside are finishing their last chunk, or an interactive loop they were preempted into,
+        // which can take as long as that loop, so the caller blocks instead of spinning on a core
+        if (loop.numWorkers.load(std::memory_order_acquire) > 0)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _workersLeft.wait(lock, [&loop]() { return loop.numWorkers.load(std::memory_order_acquire) == 0; });
+        }
+    }
+
+    void Scheduler::runWorker()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        while (true)
+        {
+            Loop* loop = nullptr;
+            int slot = 0;
+            _workAvailable.wait(lock, [&]() { return _stopping || (loop = joinLoop(slot, NUM_PRIORITIES - 1)) != nullptr; });
+
+            if (loop == nullptr)
+                break;
+
+            lock.unlock();
+            participate(*loop, slot, true);
+            lock.lock();
+
+            leaveLoop(*loop, slot);
+        }
+    }
+
+    void Scheduler::participate(Loop& loop, int slot, bool isWorker)
+    {
+        LoopContext loopContext(loop.priority, loop.depth + 1);
+
+        bool checkPreemption = isWorker && loop.priority != Priority::INTERACTIVE;
+
+        std::uint32_t chunkBegin = 0, chunkEnd = 0;
+        while (loop.takeChunk(slot, chunkBegin, chunkEnd) || loop.stealChunk(slot, chunkBegin, chunkEnd))
+        {
+            loop.function(loop.context, loop.begin + (int) chunkBegin, loop.begin + (int) chunkEnd, slot);
+
+            // Help out with interactive loops first, the rest of the own range can be stolen in the meantime
+            if (checkPreemption && _demand[(int) Priority::INTERACTIVE].load(std::memory_order_relaxed) > 0)
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+
+                int interactiveSlot = 0;
+                Loop* interactiveLoop = joinLoop(interactiveSlot, (int) Priority::INTERACTIVE);
+                if (interactiveLoop != nullptr)
+                {
+                    lock.unlock();
+                    participate(*interactiveLoop, interactiveSlot, true);
+                    lock.lock();
+
+                    leaveLoop(*interactiveLoop, interactiveSlot);
+                }
+            }
+        }
+    }
+
+    Scheduler::Loop* Scheduler::joinLoop(int& slot, int maxPriority)
+    {
+        for (int p = 0; p <= maxPriority; p++)
+        {
+            if (_demand[p].load(std::memory_order_relaxed) == 0)
+                continue;
+
+            for (Loop* loop : _loops[p])
+            {
+                if (loop->numFreeSlots == 0 || !loop->hasWork())
+                    continue;
+
+                slot = loop->freeSlots[--loop->numFreeSlots];
+                loop->numWorkers.fetch_add(1, std::memory_order_relaxed);
+                updateDemand(loop->priority, -1);
+                return loop;
+            }
+        }
+        return nullptr;
+    }
+
+    void Scheduler::leaveLoop(Loop& loop, int slot)
+    {
+        loop.freeSlots[loop.numFreeSlots++] = slot;
+        if (loop.joinable)
+            updateDemand(loop.priority, 1);
+
+        // Last access, the loop may be gone right after, but not before the mutex is released
+        if (loop.numWorkers.fetch_sub(1, std::memory_order_release) == 1)
+            _workersLeft.notify_all();
+    }
+
+    void Scheduler::updateDemand(Priority priority, int delta)
+    {
+        _demand[(int) priority].fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    Priority getPriority()
+    {
+        return currentPriority;
+    }
+
+    ScopedPriority::ScopedPriority(Priority priority) :
+        _previous(currentPriority)
+    {
+        currentPriority = priority;
+    }
+
+    ScopedPriority::~ScopedPriority()
+    {
+        currentPriority = _previous;
+    }
+
+    void limitOpenMPThreads()
+    {
+#ifdef _OPENMP
+        omp_set_num_threads(Scheduler::global().getThreadBudget(currentPriority));
+#endif
+    }
+}
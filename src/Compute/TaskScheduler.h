@@ -0,0 +1,155 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Thread pool shared by all compute modules, so background work and latency critical work don't
+ * each start their own threads and oversubscribe the cores.
+ *
+ * Loops are split into one range per thread. A thread takes chunks from the front of its own
+ * range and, when that runs out, steals the back half of the largest range of another thread, so
+ * uneven work balances without a shared queue. The thread starting a loop takes part in it, so a
+ * loop always finishes, even when no worker is free.
+ *
+ * Loops run with the priority of the thread that starts them, background unless changed with
+ * ScopedPriority. Free workers join interactive loops first, and workers in a background loop
+ * switch to an interactive loop between chunks, so a running export or index build doesn't hold
+ * up hovering. Each priority has a thread budget, and loops started inside a loop run serially
+ * unless the nesting limit is raised. Starting a loop doesn't allocate.
+ *
+ *   tasks::parallelFor(0, numDimensions, [&](int d)
+ *   {
+ *       ...
+ *   });
+ */
+namespace tasks
+{
+    enum class Priority
+    {
+        INTERACTIVE,    /** Work the user is waiting on, such as hover selections */
+        BACKGROUND      /** Bulk work, such as data loading, index builds and exports */
+    };
+
+    constexpr int NUM_PRIORITIES = 2;
+
+    /** Runs [begin, end) of a loop, slot identifies the thread within the loop */
+    using RangeFunction = void (*)(void* context, int begin, int end, int slot);
+
+    class Scheduler
+    {
+    public:
+        /** Most threads that take part in a single loop */
+        static constexpr int MAX_SLOTS = 64;
+
+        /** Scheduler shared by all compute modules, with a worker per hardware thread but one */
+        static Scheduler& global();
+
+        /** @param numWorkers Worker threads, the thread starting a loop always takes part as well */
+        explicit Scheduler(int numWorkers);
+        ~Scheduler();
+
+        Scheduler(const Scheduler&) = delete;
+        Scheduler& operator=(const Scheduler&) = delete;
+
+        int getNumWorkers() const { return (int) _workers.size(); }
+
+        /** Threads, including the one starting the loop, that loops of the priority run on at most */
+        void setThreadBudget(Priority priority, int numThreads);
+        int getThreadBudget(Priority priority) const { return _threadBudgets[(int) priority].load(std::memory_order_relaxed); }
+
+        /** Loops started at this depth of nested loops run serially on their thread, 1 by default */
+        void setMaxNesting(int maxNesting) { _maxNesting.store(std::max(maxNesting, 1), std::memory_order_relaxed); }
+        int getMaxNesting() const { return _maxNesting.load(std::memory_order_relaxed); }
+
+        /** Upper bound of the slots of a loop started by the calling thread, to size per-slot buffers */
+        int getNumSlots() const;
+
+        /**
+         * Run the function over [begin, end) in chunks and block until all chunks are done. The
+         * slots of the chunks running at the same time differ and are below getNumSlots().
+         * @param grainSize Size of the chunks, 0 to pick one from the number of threads
+         */
+        void parallelFor(int begin, int end, int grainSize, RangeFunction function, void* context);
+
+    private:
+        struct Loop;
+
+        void runWorker();
+
+        /** Take part in the loop until no work is left, or a worker is preempted, call with a slot of the loop */
+        void participate(Loop& loop, int slot, bool isWorker);
+
+        /** Find a loop with work and a free slot and join it, prefers interactive loops, call with the mutex held */
+        Loop* joinLoop(int& slot, int maxPriority);
+
+        /** Give the slot back, call with the mutex held so a caller waiting for the workers can't miss the last one */
+        void leaveLoop(Loop& loop, int slot);
+        void updateDemand(Priority priority, int delta);
+
+    private:
+        std::vector<std::thread>    _workers;
+        std::mutex                  _mutex;
+        std::condition_variable     _workAvailable;
+        std::condition_variable     _workersLeft;               /** Signalled when the last worker leaves a loop */
+        bool                        _stopping;
+
+        std::vector<Loop*>          _loops[NUM_PRIORITIES];     /** Loops that can be joined, capacity reserved up front */
+        std::atomic<int>            _demand[NUM_PRIORITIES];    /** Free slots of the joinable loops */
+
+        std::atomic<int>            _threadBudgets[NUM_PRIORITIES];
+        std::atomic<int>            _maxNesting;
+    };
+
+    /** Priority of the loops started by the calling thread */
+    Priority getPriority();
+
+    /** Start loops with the given priority on this thread until the scope closes */
+    class ScopedPriority
+    {
+    public:
+        explicit ScopedPriority(Priority priority);
+        ~ScopedPriority();
+
+        ScopedPriority(const ScopedPriority&) = delete;
+        ScopedPriority& operator=(const ScopedPriority&) = delete;
+
+    private:
+        Priority _previous;
+    };
+
+    /** Limit OpenMP regions started by the calling thread, such as those inside faiss, to the budget of its priority */
+    void limitOpenMPThreads();
+
+    /** Slots of a loop started by the calling thread on the global scheduler */
+    inline int getNumSlots() { return Scheduler::global().getNumSlots(); }
+
+    /** Run function(begin, end, slot) over chunks of [begin, end) on the global scheduler */
+    template<typename Function>
+    void parallelForRanges(int begin, int end, int grainSize, Function&& function)
+    {
+        using FunctionType = std::remove_reference_t<Function>;
+
+        Scheduler::global().parallelFor(begin, end, grainSize, [](void* context, int rangeBegin, int rangeEnd, int slot)
+        {
+            (*static_cast<FunctionType*>(context))(rangeBegin, rangeEnd, slot);
+        }, (void*) &function);
+    }
+
+    /** Run function(i) for every i in [begin, end) on the global scheduler */
+    template<typename Function>
+    void parallelFor(int begin, int end, Function&& function)
+    {
+        parallelForRanges(begin, end, 0, [&function](int rangeBegin, int rangeEnd, int)
+        {
+            for (int i = rangeBegin; i < rangeEnd; i++)
+                function(i);
+        });
+    }
+}
@@ -1,27 +1,34 @@
-#include "DataMatrix.h"
+#include "DataConversion.h"
+
+#include "Compute/TaskScheduler.h"
 
 #include "PointData/DimensionsPickerAction.h"
 
-void convertToEigenMatrix(hdps::Dataset<Points> dataset, hdps::Dataset<Points> sourceDataset, DataMatrix& dataMatrix)
+std::vector<int> getEnabledDimensions(hdps::Dataset<Points> dataset)
 {
-    // Compute num points
-    std::vector<bool> enabledDims = sourceDataset->getDimensionsPickerAction().getEnabledDimensions();
-    int numPoints = sourceDataset->getNumPoints();
-    int numDimensions = sourceDataset->getNumDimensions();
-    int numEnabledDims = std::count(enabledDims.begin(), enabledDims.end(), true);
+    std::vector<bool> enabledDims = dataset->getDimensionsPickerAction().getEnabledDimensions();
 
-    // Create list of enabled dimensions
-    std::vector<int> enabledDimensions(numEnabledDims);
-    int col = 0;
-    for (int d = 0; d < numDimensions; d++)
+    std::vector<int> enabledDimensions;
+    for (int d = 0; d < (int) enabledDims.size(); d++)
         if (enabledDims[d])
-            enabledDimensions[col++] = d;
+            enabledDimensions.push_back(d);
+
+    return enabledDimensions;
+}
+
+void convertToEigenMatrix(hdps::Dataset<Points> dataset, hdps::Dataset<Points> sourceDataset, DataMatrix& dataMatrix)
+{
+    convertDimensionsToEigenMatrix(dataset, sourceDataset, getEnabledDimensions(sourceDataset), dataMatrix);
+}
+
+void convertDimensionsToEigenMatrix(hdps::Dataset<Points> dataset, hdps::Dataset<Points> sourceDataset, const std::vector<int>& enabledDimensions, DataMatrix& dataMatrix)
+{
+    int numPoints = sourceDataset->getNumPoints();
 
     DataMatrix fullDataMatrix;
-    fullDataMatrix.resize(numPoints, numEnabledDims);
+    fullDataMatrix.resize(numPoints, (int) enabledDimensions.size());
 
-#pragma omp parallel for
-    for (int d = 0; d < enabledDimensions.size(); d++)
+    tasks::parallelFor(0, (int) enabledDimensions.size(), [&](int d)
     {
         int dim = enabledDimensions[d];
 
@@ -29,7 +36,7 @@ void convertToEigenMatrix(hdps::Dataset<Points> dataset, hdps::Dataset<Points> s
         sourceDataset->extractDataForDimension(dimData, dim);
         for (int i = 0; i < numPoints; i++)
             fullDataMatrix(i, d) = dimData[i];
-    }
+    });
 
     // If the dataset was a subset or subset chain, take only a portion of the matrix by indexing
     if (!dataset->isFull())
@@ -66,8 +73,7 @@ void convertToEigenMatrixProjection(hdps::Dataset<Points> dataset, DataMatrix& d
     DataMatrix fullDataMatrix;
     fullDataMatrix.resize(numPointsOfFull, numEnabledDims);
 
-#pragma omp parallel for
-    for (int d = 0; d < numEnabledDims; d++)
+    tasks::parallelFor(0, numEnabledDims, [&](int d)
     {
         int dim = enabledDimensions[d];
 
@@ -75,7 +81,7 @@ void convertToEigenMatrixProjection(hdps::Dataset<Points> dataset, DataMatrix& d
         fullDataset->extractDataForDimension(dimData, dim);
         for (int i = 0; i < numPointsOfFull; i++)
             fullDataMatrix(i, d) = dimData[i];
-    }
+    });
 
     // If the dataset was a subset or subset chain, take only a portion of the matrix by indexing
     if (!dataset->isFull())
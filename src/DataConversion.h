@@ -0,0 +1,16 @@
+#pragma once
+
+#include "DataMatrix.h"
+
+#include "Set.h"
+#include "PointData/PointData.h"
+
+/** Indices of the dimensions enabled in the dimension picker of the dataset, in ascending order */
+std::vector<int> getEnabledDimensions(hdps::Dataset<Points> dataset);
+
+void convertToEigenMatrix(hdps::Dataset<Points> dataset, hdps::Dataset<Points> sourceDataset, DataMatrix& dataMatrix);
+
+/** Convert only the given dimensions of the source dataset, to update data whose enabled dimensions changed */
+void convertDimensionsToEigenMatrix(hdps::Dataset<Points> dataset, hdps::Dataset<Points> sourceDataset, const std::vector<int>& enabledDimensions, DataMatrix& dataMatrix);
+
+void convertToEigenMatrixProjection(hdps::Dataset<Points> dataset, DataMatrix& dataMatrix);
@@ -2,6 +2,9 @@
 
 #include "DataMatrix.h"
 
+#include <numeric>
+#include <vector>
+
 // Eigen::IndexedView<Eigen::MatrixXf, std::vector<int>, Eigen::internal::AllRange<-1>>
 
 class DataStorage
@@ -19,32 +22,53 @@ public:
 
     const std::vector<int>& getViewIndices() const { return _viewIndices; }
 
+    /** Index of each base data point in the data view, -1 for points outside the view */
+    const std::vector<int>& getPointViewIndices() const { return _pointViewIndices; }
+
     // Auxilliary data getters
     std::vector<float>& getVariances() { return _variances; }
 
-    int getNumPoints() { return _dataView.rows(); }
+    /** Points in the view, known as soon as the point view is created */
+    int getNumPoints() { return _fullProjectionView.rows(); }
     int getNumDimensions() { return _dataView.cols(); }
 
     void setProjectionSize(float projectionSize) { _projectionSize = projectionSize; }
     float getProjectionSize() { return _projectionSize; }
 
-    void createDataView()
+    /** Positions and indices of the points in the view, only needs the projection so the view can be drawn before the data is ready */
+    void createPointView()
     {
-        _dataView = _dataMatrix;
         _fullProjectionView = _fullProjMatrix;
 
         _viewIndices.resize(_projectionView.rows());
         std::iota(_viewIndices.begin(), _viewIndices.end(), 0);
 
-        _hasBaseData = true;
+        _pointViewIndices.resize(_fullProjMatrix.rows());
+        std::iota(_pointViewIndices.begin(), _pointViewIndices.end(), 0);
     }
 
-    void createDataView(const std::vector<int>& indices)
+    void createPointView(const std::vector<int>& indices)
     {
-        _dataView = _dataMatrix(indices, Eigen::all);
         _fullProjectionView = _fullProjMatrix(indices, Eigen::all);
 
         _viewIndices = indices;
+
+        _pointViewIndices.assign(_fullProjMatrix.rows(), -1);
+        for (int i = 0; i < (int) indices.size(); i++)
+            _pointViewIndices[indices[i]] = i;
+    }
+
+    /** Data of the points in the view, the same points as the point view */
+    void createDataView()
+    {
+        _dataView = _dataMatrix;
+
+        _hasBaseData = true;
+    }
+
+    void createDataView(const std::vector<int>& indices)
+    {
+        _dataView = _dataMatrix(indices, Eigen::all);
     }
 
     void createProjectionView(int xDim, int yDim)
@@ -65,6 +89,7 @@ private:
     DataMatrix                      _projectionView;
 
     std::vector<int>                _viewIndices;
+    std::vector<int>                _pointViewIndices;
 
     // Auxilliary data
     std::vector<float>              _variances;
@@ -0,0 +1,89 @@
+#include "FloodScalarPublisher.h"
+
+#include <QTimer>
+
+using namespace hdps;
+
+namespace
+{
+    constexpr int DEFAULT_MINIMUM_INTERVAL = 100;
+}
+
+FloodScalarPublisher::FloodScalarPublisher(Dataset<Points>& dataset, QObject* parent) :
+    _dataset(dataset),
+    _timer(new QTimer(parent)),
+    _minimumInterval(DEFAULT_MINIMUM_INTERVAL),
+    _fullyDirty(true),
+    _pending(false)
+{
+    _timer->setSingleShot(true);
+    QObject::connect(_timer, &QTimer::timeout, [this]() { publishNow(); });
+}
+
+void FloodScalarPublisher::setScalars(const std::vector<float>& scalars)
+{
+    // Copy into the existing buffer, the size rarely changes
+    _scalars.assign(scalars.begin(), scalars.end());
+    _dirtyIndices.clear();
+    _fullyDirty = true;
+}
+
+void FloodScalarPublisher::publish()
+{
+    _pending = true;
+
+    if (_minimumInterval < 0 || _timer->isActive())
+        return;
+
+    qint64 elapsed = _sinceLastPublication.isValid() ? _sinceLastPublication.elapsed() : _minimumInterval;
+    if (elapsed >= _minimumInterval)
+        publishNow();
+    else
+        _timer->start((int) (_minimumInterval - elapsed));
+}
+
+void FloodScalarPublisher::flush()
+{
+    _timer->stop();
+
+    if (_pending)
+        publishNow();
+}
+
+void FloodScalarPublisher::reset()
+{
+    _timer->stop();
+    _scalars.clear();
+    _dirtyIndices.clear();
+    _fullyDirty = true;
+    _pending = false;
+}
+
+void FloodScalarPublisher::publishNow()
+{
+    _pending = false;
+
+    if (!_dataset.isValid() || _scalars.empty())
+        return;
+
+    // Writing single values only pays off for small changes to a dataset of the same size
+    bool sameLayout = _dataset->getNumPoints() == _scalars.size() && _dataset->getNumDimensions() == 1;
+    if (_fullyDirty || !sameLayout || _dirtyIndices.size() > _scalars.size() / 8)
+    {
+        _dataset->setData<float>(_scalars.data(), _scalars.size(), 1);
+    }
+    else
+    {
+        if (_dirtyIndices.empty())
+            return;
+
+        for (const int& index : _dirtyIndices)
+            _dataset->setValueAt(index, _scalars[index]);
+    }
+
+    _dirtyIndices.clear();
+    _fullyDirty = false;
+    _sinceLastPublication.start();
+
+    events().notifyDatasetDataChanged(_dataset);
+}
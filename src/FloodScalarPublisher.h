@@ -0,0 +1,58 @@
+#pragma once
+
+#include "PointData/PointData.h"
+
+#include <QElapsedTimer>
+
+#include <vector>
+
+class QTimer;
+
+/**
+ * Publishes the flood scalars to the output dataset of the plugin. Every publication makes all
+ * linked views in the application reload the dataset, so updates are coalesced and published at
+ * most once per minimum interval. Only the latest scalars are published, points that changed
+ * since the last publication are written into the existing dataset buffer in place.
+ */
+class FloodScalarPublisher
+{
+public:
+    FloodScalarPublisher(hdps::Dataset<Points>& dataset, QObject* parent);
+
+    /** Minimum time between two publications in milliseconds, negative values only publish on flush() */
+    void setMinimumInterval(int interval) { _minimumInterval = interval; }
+    int getMinimumInterval() const { return _minimumInterval; }
+
+    /** Replace all scalars */
+    void setScalars(const std::vector<float>& scalars);
+
+    /** Change the scalar of a single point, scalars must have been set before */
+    void setScalar(int index, float scalar)
+    {
+        _scalars[index] = scalar;
+        _dirtyIndices.push_back(index);
+    }
+
+    /** Schedule publication of the current scalars */
+    void publish();
+
+    /** Publish pending changes right away, e.g. at the end of an interaction */
+    void flush();
+
+    /** Drop pending changes */
+    void reset();
+
+private:
+    void publishNow();
+
+private:
+    hdps::Dataset<Points>&  _dataset;
+    QTimer*                 _timer;
+    QElapsedTimer           _sinceLastPublication;
+    int                     _minimumInterval;
+
+    std::vector<float>      _scalars;
+    std::vector<int>        _dirtyIndices;      /** Points changed since the last publication */
+    bool                    _fullyDirty;        /** Whether all scalars have to be published */
+    bool                    _pending;
+};
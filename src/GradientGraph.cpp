@@ -1,6 +1,6 @@
 #include "GradientGraph.h"
 
-#include "Timer.h"
+#include "Tracing.h"
 
 #include <QVBoxLayout>
 
@@ -148,8 +148,7 @@ void GradientGraph::setValues(const std::vector<std::vector<float>>& values)
 
 void GradientGraph::setBins(const std::vector<std::vector<int>>& bins)
 {
-    Timer timer;
-    timer.start();
+    TRACE_SCOPE("Gradient graph bins");
 
     // Store values in a QList<QPointF>
     std::vector<QList<QPointF>> pointLists(bins.size());
@@ -176,8 +175,6 @@ void GradientGraph::setBins(const std::vector<std::vector<int>>& bins)
         _seriesArray[d]->replace(pointLists[d]);
 
     updateChartColors();
-
-    timer.finish("Graph inner");
 }
 
 void GradientGraph::setTopDimensions(dint dimension1, dint dimension2)
@@ -1,6 +1,6 @@
 #include "GraphView.h"
 
-#include "Timer.h"
+#include "Tracing.h"
 
 #define mv hdps
 
@@ -38,8 +38,7 @@ void GraphView::setTopDimensions(int d1, int d2)
 
 void GraphView::setBins(const std::vector<std::vector<int>>& bins)
 {
-    Timer timer;
-    timer.start();
+    TRACE_SCOPE("Graph view bins");
 
     Q_ASSERT(!bins.empty());
     Q_ASSERT(!bins[0].empty());
@@ -63,7 +62,7 @@ void GraphView::setBins(const std::vector<std::vector<int>>& bins)
             binTotal += bins[d][i];
 
             _lineVertices[_numLineVertices++] = currentPoint;
-            currentPoint.set(binTotal, i / 30.0f);
+            currentPoint.set(binTotal, i / (float) numSteps);
             _lineVertices[_numLineVertices++] = currentPoint;
         }
     }
@@ -81,8 +80,6 @@ void GraphView::setBins(const std::vector<std::vector<int>>& bins)
 
     //updateChartColors();
     update();
-
-    timer.finish("Graph inner");
 }
 
 void GraphView::initializeGL()
@@ -146,6 +143,8 @@ void GraphView::resizeGL(int w, int h)
 
 void GraphView::paintGL()
 {
+    TRACE_SCOPE("Render graph view");
+
     glClear(GL_COLOR_BUFFER_BIT);
 
     _graphShader.bind();
@@ -0,0 +1,489 @@
+#include "DerivedDataCache.h"
+
+#include "Compute/FloodWorkingSet.h"
+#include "Compute/KnnGraph.h"
+#include "Compute/TaskScheduler.h"
+#include "Tracing.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr char MAGIC[4] = { 'S', 'W', 'D', 'C' };
+    constexpr std::uint32_t VERSION = 1;
+
+    // Sections start at cache line boundaries, so mapped arrays are aligned for any element type
+    constexpr std::uint64_t SECTION_ALIGNMENT = 64;
+
+    constexpr std::uint32_t MAX_SECTIONS = 16;
+
+    constexpr std::uint64_t DEFAULT_MAX_SIZE = 8ull * 1024 * 1024 * 1024;
+
+    const char* PREPROCESSED_EXTENSION = ".swdata";
+    const char* KNN_EXTENSION = ".swknn";
+
+    enum class EntryType : std::uint32_t
+    {
+        PREPROCESSED = 1,
+        KNN_GRAPHS = 2
+    };
+
+    // Bump when buildKnnGraphs changes its metrics or neighbour counts, so old graphs miss
+    constexpr std::uint64_t KNN_PARAMETERS_VERSION = 1;
+
+    constexpr std::uint64_t HASH_MULTIPLIER = 0xc6a4a7935bd1e995ull;
+
+    /** Mix a 64-bit value into the hash, as in MurmurHash64A */
+    std::uint64_t mix(std::uint64_t hash, std::uint64_t value)
+    {
+        value *= HASH_MULTIPLIER;
+        value ^= value >> 47;
+        value *= HASH_MULTIPLIER;
+
+        hash ^= value;
+        hash *= HASH_MULTIPLIER;
+        return hash;
+    }
+
+    std::uint64_t finalize(std::uint64_t hash)
+    {
+        hash ^= hash >> 47;
+        hash *= HASH_MULTIPLIER;
+        hash ^= hash >> 47;
+        return hash;
+    }
+
+    std::uint64_t hashBytes(const unsigned char* bytes, std::size_t size, std::uint64_t seed)
+    {
+        std::uint64_t hash = seed ^ (size * HASH_MULTIPLIER);
+
+        std::size_t numWords = size / sizeof(std::uint64_t);
+        for (std::size_t w = 0; w < numWords; w++)
+        {
+            std::uint64_t word;
+            std::memcpy(&word, bytes + w * sizeof(std::uint64_t), sizeof(word));
+            hash = mix(hash, word);
+        }
+
+        std::size_t tailSize = size % sizeof(std::uint64_t);
+        if (tailSize > 0)
+        {
+            std::uint64_t tail = 0;
+            std::memcpy(&tail, bytes + numWords * sizeof(std::uint64_t), tailSize);
+            hash = mix(hash, tail);
+        }
+
+        return finalize(hash);
+    }
+
+    struct SectionHeader
+    {
+        std::uint64_t   offset;
+        std::uint64_t   size;
+        std::int32_t    rows;
+        std::int32_t    cols;
+    };
+
+    /** Array written as a section of an entry */
+    struct Section
+    {
+        const void*     data;
+        std::int32_t    rows;
+        std::int32_t    cols;
+        std::uint64_t   elementSize;
+    };
+
+    template<typename T>
+    void writeValue(std::ofstream& file, const T& value)
+    {
+        file.write((const char*) &value, sizeof(T));
+    }
+
+    template<typename T>
+    void readValue(std::ifstream& file, T& value)
+    {
+        file.read((char*) &value, sizeof(T));
+    }
+
+    std::uint64_t alignOffset(std::uint64_t offset)
+    {
+        return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+    }
+
+    /** Write the entry next to its final path and move it in place, so readers never see a partial entry */
+    bool writeEntry(const std::string& path, std::uint64_t key, EntryType type, const std::vector<Section>& sections)
+    {
+        std::ostringstream temporaryPath;
+        temporaryPath << path << "." << std::hash<std::thread::id>()(std::this_thread::get_id()) << ".tmp";
+
+        std::vector<SectionHeader> headers(sections.size());
+        std::uint64_t offset = sizeof(MAGIC) + sizeof(VERSION) + sizeof(key) + sizeof(std::uint32_t) * 2 + headers.size() * sizeof(SectionHeader);
+        for (size_t s = 0; s < sections.size(); s++)
+        {
+            offset = alignOffset(offset);
+            headers[s].offset = offset;
+            headers[s].size = (std::uint64_t) sections[s].rows * sections[s].cols * sections[s].elementSize;
+            headers[s].rows = sections[s].rows;
+            headers[s].cols = sections[s].cols;
+            offset += headers[s].size;
+        }
+
+        {
+            std::ofstream file(temporaryPath.str(), std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!file)
+                return false;
+
+            file.write(MAGIC, sizeof(MAGIC));
+            writeValue(file, VERSION);
+            writeValue(file, key);
+            writeValue(file, (std::uint32_t) type);
+            writeValue(file, (std::uint32_t) sections.size());
+            file.write((const char*) headers.data(), headers.size() * sizeof(SectionHeader));
+
+            const char padding[SECTION_ALIGNMENT] = {};
+            for (size_t s = 0; s < sections.size(); s++)
+            {
+                file.write(padding, headers[s].offset - (std::uint64_t) file.tellp());
+                file.write((const char*) sections[s].data, headers[s].size);
+            }
+
+            if (!file)
+            {
+                file.close();
+                std::error_code error;
+                fs::remove(temporaryPath.str(), error);
+                return false;
+            }
+        }
+
+        std::error_code error;
+        fs::rename(temporaryPath.str(), path, error);
+        if (error)
+        {
+            fs::remove(temporaryPath.str(), error);
+            return false;
+        }
+        return true;
+    }
+
+    /** Open an entry and read its section table, @return False if it is missing, of another version or truncated */
+    bool openEntry(const std::string& path, std::uint64_t key, EntryType type, std::ifstream& file, std::vector<SectionHeader>& headers)
+    {
+        std::error_code error;
+        std::uint64_t fileSize = fs::file_size(path, error);
+        if (error)
+            return false;
+
+        file.open(path, std::ios::in | std::ios::binary);
+        if (!file)
+            return false;
+
+        char magic[4] = {};
+        std::uint32_t version = 0, entryType = 0, numSections = 0;
+        std::uint64_t entryKey = 0;
+        file.read(magic, sizeof(magic));
+        readValue(file, version);
+        readValue(file, entryKey);
+        readValue(file, entryType);
+        readValue(file, numSections);
+        if (!file || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || version != VERSION || entryKey != key || entryType != (std::uint32_t) type || numSections > MAX_SECTIONS)
+            return false;
+
+        headers.resize(numSections);
+        file.read((char*) headers.data(), headers.size() * sizeof(SectionHeader));
+        if (!file)
+            return false;
+
+        // Elements are at least a byte, so a damaged entry can't make the reader allocate more than the file size
+        for (const SectionHeader& header : headers)
+        {
+            if (header.rows < 0 || header.cols < 0 || (std::uint64_t) header.rows * header.cols > header.size || header.offset + header.size > fileSize)
+                return false;
+        }
+
+        // Mark the entry as recently used, trimming removes the entries that haven't been read for longest
+        fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+        return true;
+    }
+
+    bool readSection(std::ifstream& file, const SectionHeader& header, void* data, std::uint64_t elementSize)
+    {
+        if (header.size != (std::uint64_t) header.rows * header.cols * elementSize)
+            return false;
+
+        file.seekg(header.offset);
+        file.read((char*) data, header.size);
+        return (bool) file;
+    }
+
+    Section graphSection(const KnnGraph& graph, std::vector<nint>& linearNeighbours)
+    {
+        const std::vector<std::vector<nint>>& neighbours = graph.getNeighbours();
+        int numNeighbours = neighbours.empty() ? 0 : graph.getNumNeighbours();
+
+        linearNeighbours.resize(neighbours.size() * numNeighbours);
+        for (size_t i = 0; i < neighbours.size(); i++)
+            std::copy_n(neighbours[i].begin(), numNeighbours, linearNeighbours.begin() + i * numNeighbours);
+
+        return { linearNeighbours.data(), (std::int32_t) neighbours.size(), numNeighbours, sizeof(nint) };
+    }
+
+}
+
+std::uint64_t DerivedDataCache::hashData(const DataMatrix& data)
+{
+    return combineColumnHashes((int) data.rows(), hashColumns(data));
+}
+
+std::vector<std::uint64_t> DerivedDataCache::hashColumns(const DataMatrix& data)
+{
+    TRACE_SCOPE("Hash derived data key");
+
+    std::vector<std::uint64_t> columnHashes(data.cols());
+    tasks::parallelFor(0, (int) data.cols(), [&](int d)
+    {
+        columnHashes[d] = hashBytes((const unsigned char*) data.col(d).data(), data.rows() * sizeof(float), 0);
+    });
+
+    return columnHashes;
+}
+
+std::uint64_t DerivedDataCache::combineColumnHashes(int numRows, const std::vector<std::uint64_t>& columnHashes)
+{
+    std::uint64_t hash = mix(mix(0, (std::uint64_t) numRows), (std::uint64_t) columnHashes.size());
+
+    // Combined in order, so the same columns in another order hash differently
+    for (std::uint64_t columnHash : columnHashes)
+        hash = mix(hash, columnHash);
+
+    return finalize(hash);
+}
+
+std::uint64_t DerivedDataCache::hashValues(const void* values, std::size_t size, std::uint64_t seed)
+{
+    return hashBytes((const unsigned char*) values, size, seed);
+}
+
+DerivedDataCache::DerivedDataCache() :
+    _maxSize(DEFAULT_MAX_SIZE)
+{
+
+}
+
+void DerivedDataCache::setDirectory(const std::string& directory)
+{
+    _directory = directory;
+    if (_directory.empty())
+        return;
+
+    std::error_code error;
+    fs::create_directories(_directory, error);
+    if (error)
+    {
+        std::cout << "Cannot create derived data cache directory " << _directory << ", caching is disabled" << std::endl;
+        _directory.clear();
+    }
+}
+
+bool DerivedDataCache::readPreprocessed(std::uint64_t dataHash, DataMatrix& standardizedData, std::vector<float>& variances, std::vector<std::vector<float>>& normalizedData) const
+{
+    if (!isEnabled())
+        return false;
+
+    TRACE_SCOPE("Read preprocessed data cache");
+
+    std::uint64_t key = mix(dataHash, (std::uint64_t) EntryType::PREPROCESSED);
+
+    std::ifstream file;
+    std::vector<SectionHeader> headers;
+    if (!openEntry(getEntryPath(key, PREPROCESSED_EXTENSION), key, EntryType::PREPROCESSED, file, headers) || headers.size() != 3)
+        return false;
+
+    int numPoints = headers[0].rows;
+    int numDimensions = headers[0].cols;
+    if (headers[1].rows != 1 || headers[1].cols != numDimensions || headers[2].rows != numPoints || headers[2].cols != numDimensions)
+        return false;
+
+    DataMatrix data(numPoints, numDimensions);
+    std::vector<float> dataVariances(numDimensions);
+    std::vector<std::uint8_t> levels((size_t) numPoints * numDimensions);
+    if (!readSection(file, headers[0], data.data(), sizeof(float)) ||
+        !readSection(file, headers[1], dataVariances.data(), sizeof(float)) ||
+        !readSection(file, headers[2], levels.data(), sizeof(std::uint8_t)))
+        return false;
+
+    standardizedData = std::move(data);
+    variances = std::move(dataVariances);
+
+    // The normalized data is only ever used quantized, the centre of each level quantizes back to the same level
+    normalizedData.resize(numDimensions);
+    tasks::parallelFor(0, numDimensions, [&](int d)
+    {
+        const std::uint8_t* dimensionLevels = levels.data() + (size_t) d * numPoints;
+
+        normalizedData[d].resize(numPoints);
+        for (int i = 0; i < numPoints; i++)
+            normalizedData[d][i] = (dimensionLevels[i] + 0.5f) * (1.0f / FloodWorkingSet::NUM_LEVELS);
+    });
+
+    return true;
+}
+
+void DerivedDataCache::writePreprocessed(std::uint64_t dataHash, const DataMatrix& standardizedData, const std::vector<float>& variances, const std::vector<std::vector<float>>& normalizedData)
+{
+    if (!isEnabled())
+        return;
+
+    TRACE_SCOPE("Write preprocessed data cache");
+
+    int numPoints = (int) standardizedData.rows();
+    int numDimensions = (int) standardizedData.cols();
+
+    std::vector<std::uint8_t> levels((size_t) numPoints * numDimensions);
+    tasks::parallelFor(0, numDimensions, [&](int d)
+    {
+        std::uint8_t* dimensionLevels = levels.data() + (size_t) d * numPoints;
+        for (int i = 0; i < numPoints; i++)
+            dimensionLevels[i] = FloodWorkingSet::toLevel(normalizedData[d][i]);
+    });
+
+    std::vector<Section> sections =
+    {
+        { standardizedData.data(), numPoints, numDimensions, sizeof(float) },
+        { variances.data(), 1, numDimensions, sizeof(float) },
+        { levels.data(), numPoints, numDimensions, sizeof(std::uint8_t) }
+    };
+
+    std::uint64_t key = mix(dataHash, (std::uint64_t) EntryType::PREPROCESSED);
+    if (!writeEntry(getEntryPath(key, PREPROCESSED_EXTENSION), key, EntryType::PREPROCESSED, sections))
+        std::cout << "Failed writing preprocessed data to the cache" << std::endl;
+
+    trim();
+}
+
+bool DerivedDataCache::readKnnGraphs(std::uint64_t dataHash, bool useSharedDistances, KnnGraphBuild& build) const
+{
+    if (!isEnabled())
+        return false;
+
+    TRACE_SCOPE("Read kNN graph cache");
+
+    std::uint64_t key = mix(mix(mix(dataHash, (std::uint64_t) EntryType::KNN_GRAPHS), KNN_PARAMETERS_VERSION), useSharedDistances);
+
+    std::ifstream file;
+    std::vector<SectionHeader> headers;
+    if (!openEntry(getEntryPath(key, KNN_EXTENSION), key, EntryType::KNN_GRAPHS, file, headers) || headers.size() != 3)
+        return false;
+
+    KnnGraph graphs[3];
+    std::vector<nint> linearNeighbours;
+    for (int g = 0; g < 3; g++)
+    {
+        linearNeighbours.resize((size_t) headers[g].rows * headers[g].cols);
+        if (!readSection(file, headers[g], linearNeighbours.data(), sizeof(nint)))
+            return false;
+
+        setNeighbours(graphs[g], linearNeighbours, headers[g].rows, headers[g].cols);
+    }
+
+    build.sourceGraph = std::move(graphs[0]);
+    build.largeGraph = std::move(graphs[1]);
+    build.graph = std::move(graphs[2]);
+    return true;
+}
+
+void DerivedDataCache::writeKnnGraphs(std::uint64_t dataHash, bool useSharedDistances, const KnnGraphBuild& build)
+{
+    if (!isEnabled())
+        return;
+
+    TRACE_SCOPE("Write kNN graph cache");
+
+    std::vector<nint> sourceNeighbours, largeNeighbours, neighbours;
+    std::vector<Section> sections =
+    {
+        graphSection(build.sourceGraph, sourceNeighbours),
+        graphSection(build.largeGraph, largeNeighbours),
+        graphSection(build.graph, neighbours)
+    };
+
+    std::uint64_t key = mix(mix(mix(dataHash, (std::uint64_t) EntryType::KNN_GRAPHS), KNN_PARAMETERS_VERSION), useSharedDistances);
+    if (!writeEntry(getEntryPath(key, KNN_EXTENSION), key, EntryType::KNN_GRAPHS, sections))
+        std::cout << "Failed writing kNN graphs to the cache" << std::endl;
+
+    trim();
+}
+
+void DerivedDataCache::setNeighbours(KnnGraph& graph, const std::vector<nint>& linearNeighbours, int numPoints, int numNeighbours)
+{
+    // Graphs that weren't built, such as the source graph without shared distances, stay empty
+    if (numPoints == 0)
+        return;
+
+    graph._numNeighbours = numNeighbours;
+    graph._neighbours.resize(numPoints);
+    for (int i = 0; i < numPoints; i++)
+        graph._neighbours[i].assign(linearNeighbours.begin() + (size_t) i * numNeighbours, linearNeighbours.begin() + (size_t) (i + 1) * numNeighbours);
+}
+
+std::string DerivedDataCache::getEntryPath(std::uint64_t key, const char* extension) const
+{
+    std::ostringstream fileName;
+    fileName << std::hex << std::setw(16) << std::setfill('0') << key << extension;
+
+    return (fs::path(_directory) / fileName.str()).string();
+}
+
+void DerivedDataCache::trim()
+{
+    struct Entry
+    {
+        fs::path            path;
+        std::uint64_t       size;
+        fs::file_time_type  lastUsed;
+    };
+
+    std::error_code error;
+    std::vector<Entry> entries;
+    std::uint64_t totalSize = 0;
+    for (const fs::directory_entry& item : fs::directory_iterator(_directory, error))
+    {
+        std::string extension = item.path().extension().string();
+        if (extension != PREPROCESSED_EXTENSION && extension != KNN_EXTENSION)
+            continue;
+
+        Entry entry{ item.path(), 0, {} };
+        entry.size = item.file_size(error);
+        if (error)
+            continue;
+        entry.lastUsed = item.last_write_time(error);
+        if (error)
+            continue;
+
+        totalSize += entry.size;
+        entries.push_back(entry);
+    }
+
+    if (totalSize <= _maxSize)
+        return;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.lastUsed < b.lastUsed; });
+    for (const Entry& entry : entries)
+    {
+        if (totalSize <= _maxSize)
+            break;
+
+        if (fs::remove(entry.path, error))
+            totalSize -= entry.size;
+    }
+}
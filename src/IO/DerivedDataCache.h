@@ -0,0 +1,78 @@
+#pragma once
+
+#include "DataMatrix.h"
+#include "Types.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class KnnGraph;
+struct KnnGraphBuild;
+
+/**
+ * On-disk cache of data derived from a dataset, so reopening an unchanged dataset only costs I/O.
+ *
+ * Entries are content addressed: the key is a hash of the converted data matrix, which already
+ * reflects the enabled dimensions and the subset, combined with the parameters of the step that
+ * produced the entry. A changed dataset or parameter simply misses and a new entry is written.
+ * Entries are written to a temporary file and renamed, so readers never see partial entries, and
+ * the least recently used entries are removed once the cache grows beyond its size limit.
+ *
+ * Entry files (little endian):
+ *   char[4] "SWDC", uint32 version, uint64 key, uint32 type, uint32 numSections,
+ *   numSections x { uint64 offset, uint64 size, int32 rows, int32 cols }
+ * followed by the sections, flat column-major arrays starting at 64 byte aligned offsets so they
+ * can be memory-mapped as they are. Preprocessed entries hold the standardized matrix (float32),
+ * the variances (float32) and the normalized data quantized to FloodWorkingSet levels (uint8).
+ * kNN entries hold the source, large and flood graph as points x neighbours int32 arrays.
+ */
+class DerivedDataCache
+{
+public:
+    /** Hash of the contents of a data matrix, to key the entries derived from it */
+    static std::uint64_t hashData(const DataMatrix& data);
+
+    /** Hash of each column, combined they give the hash of the matrix, so changed columns can be hashed on their own */
+    static std::vector<std::uint64_t> hashColumns(const DataMatrix& data);
+    static std::uint64_t combineColumnHashes(int numRows, const std::vector<std::uint64_t>& columnHashes);
+
+    /** Hash of raw values chained onto a previous hash, for keys of other data derived from the same inputs */
+    static std::uint64_t hashValues(const void* values, std::size_t size, std::uint64_t seed);
+
+    DerivedDataCache();
+
+    /** Directory of the entry files, the cache is disabled while it is empty */
+    void setDirectory(const std::string& directory);
+    const std::string& getDirectory() const { return _directory; }
+
+    void setMaxSize(std::uint64_t maxSize) { _maxSize = maxSize; }
+
+    bool isEnabled() const { return !_directory.empty(); }
+
+    /**
+     * Read the standardized data, variances and normalized data derived from data with the given hash
+     * @return False if there is no entry, the outputs are left untouched then
+     */
+    bool readPreprocessed(std::uint64_t dataHash, DataMatrix& standardizedData, std::vector<float>& variances, std::vector<std::vector<float>>& normalizedData) const;
+    void writePreprocessed(std::uint64_t dataHash, const DataMatrix& standardizedData, const std::vector<float>& variances, const std::vector<std::vector<float>>& normalizedData);
+
+    /**
+     * Read the kNN graphs built from data with the given hash, the index of the build is not cached
+     * @return False if there is no entry, the build is left untouched then
+     */
+    bool readKnnGraphs(std::uint64_t dataHash, bool useSharedDistances, KnnGraphBuild& build) const;
+    void writeKnnGraphs(std::uint64_t dataHash, bool useSharedDistances, const KnnGraphBuild& build);
+
+private:
+    static void setNeighbours(KnnGraph& graph, const std::vector<nint>& linearNeighbours, int numPoints, int numNeighbours);
+
+    std::string getEntryPath(std::uint64_t key, const char* extension) const;
+
+    /** Remove the least recently used entries until the cache fits its size limit */
+    void trim();
+
+private:
+    std::string     _directory;
+    std::uint64_t   _maxSize;
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <ctime>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+/**
+ * Progress callback of the batch exports, called from the thread that started the export
+ * with the number of processed points. Returning false cancels the export.
+ */
+using ExportProgressCallback = std::function<bool(int numProcessed, int numTotal)>;
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable:4996) // Disable security warning of localtime
+#endif
+/** Build a file name of the form <prefix><date time><extension> */
+inline std::string createTimestampedFileName(const std::string& prefix, const std::string& extension)
+{
+    auto t = std::time(nullptr);
+    auto tm = *std::localtime(&t);
+
+    std::ostringstream fileName;
+    fileName << prefix;
+    fileName << std::put_time(&tm, "%d-%m-%Y %H-%M-%S");
+    fileName << extension;
+
+    return fileName.str();
+}
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
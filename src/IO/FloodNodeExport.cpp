@@ -2,63 +2,200 @@
 
 #include "Compute/FloodFill.h"
 #include "Compute/KnnGraph.h"
+#include "Compute/TaskScheduler.h"
+#include "Tracing.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
 #include <vector>
 #include <iostream>
 #include <fstream>
-#include <sstream>
-#include <iomanip>
-#include <ctime>
+#include <string>
 
-#pragma warning(push)
-#pragma warning(disable:4996) // Disable security warning of localtime
-void writeFloodNodes(const std::vector<std::vector<int>>& floodNodes)
+namespace
 {
-    auto t = std::time(nullptr);
-    auto tm = *std::localtime(&t);
+    constexpr uint32_t DELTA_COMPRESSED_FLAG = 1;
 
-    std::ostringstream fileName;
-    fileName << "flood_nodes";
-    fileName << std::put_time(&tm, "%d-%m-%Y %H-%M-%S");
-    fileName << ".csv";
+    /** Encoded flood of a single point, reused between batches to bound memory */
+    struct FloodRecord
+    {
+        std::vector<uint32_t>   waveOffsets;
+        std::vector<char>       bytes;
+        std::vector<nint>       sortedWave;
+    };
 
-    std::ofstream myfile;
-    myfile.open(fileName.str());
-    for (int i = 0; i < floodNodes.size(); i++)
+    void appendVarint(std::vector<char>& bytes, uint32_t value)
     {
-        for (int d = 0; d < floodNodes[i].size(); d++)
+        while (value >= 0x80)
         {
-            if (d != 0) myfile << ',';
-            myfile << floodNodes[i][d];
+            bytes.push_back((char) ((value & 0x7F) | 0x80));
+            value >>= 7;
         }
-        myfile << std::endl;
+        bytes.push_back((char) value);
     }
 
-    myfile.close();
-    std::cout << "Flood nodes written to file" << std::endl;
+    void encodeFlood(const FloodFill& floodFill, const FloodNodeExportSettings& settings, FloodRecord& record)
+    {
+        const auto& waves = floodFill.getWaves();
+
+        record.bytes.clear();
+        record.waveOffsets.resize(waves.size() + 1);
+        record.waveOffsets[0] = 0;
+
+        for (size_t w = 0; w < waves.size(); w++)
+        {
+            const std::vector<nint>& wave = waves[w];
+            record.waveOffsets[w + 1] = record.waveOffsets[w] + (uint32_t) wave.size();
+
+            if (settings.format == FloodNodeExportFormat::CSV)
+            {
+                std::string line = "-1";
+                for (const nint& node : wave)
+                {
+                    line += ',';
+                    line += std::to_string(node);
+                }
+                if (w != 0) record.bytes.push_back(',');
+                record.bytes.insert(record.bytes.end(), line.begin(), line.end());
+            }
+            else if (settings.deltaCompressed)
+            {
+                // Order within a wave carries no meaning, sorting makes the deltas small
+                record.sortedWave.assign(wave.begin(), wave.end());
+                std::sort(record.sortedWave.begin(), record.sortedWave.end());
+
+                uint32_t previous = 0;
+                for (const nint& node : record.sortedWave)
+                {
+                    appendVarint(record.bytes, (uint32_t) node - previous);
+                    previous = (uint32_t) node;
+                }
+            }
+            else
+            {
+                const char* data = (const char*) wave.data();
+                record.bytes.insert(record.bytes.end(), data, data + wave.size() * sizeof(int32_t));
+            }
+        }
+
+        if (settings.format == FloodNodeExportFormat::CSV)
+            record.bytes.push_back('\n');
+    }
 }
-#pragma warning(pop)
 
-void exportFloodNodes(int numPoints, FloodFill& floodFill, KnnGraph& knnGraph)
+bool exportFloodNodes(int numPoints, const FloodFill& floodFill, const KnnGraph& knnGraph, const FloodNodeExportSettings& settings, const ExportProgressCallback& progressCallback)
 {
-    std::vector<std::vector<int>> perPointFloodNodes(numPoints);
-    for (int p = 0; p < numPoints; p++)
+    TRACE_SCOPE("Flood node export");
+
+    int numWaves = floodFill.getNumWaves();
+    int batchSize = std::max(settings.batchSize, 1);
+    bool binary = settings.format == FloodNodeExportFormat::BINARY;
+
+    std::string fileName = createTimestampedFileName("flood_nodes", binary ? ".swflood" : ".csv");
+
+    std::ofstream myfile(fileName, std::ios::out | std::ios::binary);
+    if (!myfile) {
+        std::cout << "Cannot open file for writing flood nodes!" << std::endl;
+        return false;
+    }
+
+    // Header, section positions are filled in once the nodes have been written
+    uint64_t sectionPositions[2] = { 0, 0 };
+    std::streampos sectionPositionsPos = 0;
+    if (binary)
     {
-        FloodFill exportFloodFill(floodFill.getNumWaves());
-        exportFloodFill.compute(knnGraph, p);
+        const char magic[4] = { 'S', 'W', 'F', 'N' };
+        uint32_t header[4] = { 1, (uint32_t) numPoints, (uint32_t) numWaves, settings.deltaCompressed ? DELTA_COMPRESSED_FLAG : 0 };
+
+        myfile.write(magic, sizeof(magic));
+        myfile.write((char*) header, sizeof(header));
+        sectionPositionsPos = myfile.tellp();
+        myfile.write((char*) sectionPositions, sizeof(sectionPositions));
+    }
 
-        // Store all flood nodes together
-        perPointFloodNodes[p].resize(exportFloodFill.getTotalNumNodes() + exportFloodFill.getNumWaves());
-        int n = 0;
-        for (int i = 0; i < exportFloodFill.getNumWaves(); i++)
+    std::vector<FloodFill> floodFills(tasks::getNumSlots(), FloodFill(numWaves));
+    std::vector<FloodRecord> records(batchSize);
+
+    // Index of the CSR layout, small compared to the nodes so it is kept in memory
+    std::vector<uint64_t> offsets;
+    std::vector<uint32_t> waveOffsets;
+    if (binary)
+    {
+        offsets.reserve((size_t) numPoints + 1);
+        waveOffsets.reserve((size_t) numPoints * (numWaves + 1));
+        offsets.push_back(0);
+    }
+
+    bool completed = true;
+    for (int batchStart = 0; batchStart < numPoints; batchStart += batchSize)
+    {
+        int batchEnd = std::min(batchStart + batchSize, numPoints);
+
+        TRACE_SPAN(batchSpan, "Flood node export batch");
+        tasks::parallelForRanges(batchStart, batchEnd, 16, [&](int rangeBegin, int rangeEnd, int slot)
         {
-            perPointFloodNodes[p][n++] = -1;
-            for (int j = 0; j < exportFloodFill.getWaves()[i].size(); j++)
+            FloodFill& exportFloodFill = floodFills[slot];
+            for (int p = rangeBegin; p < rangeEnd; p++)
             {
-                perPointFloodNodes[p][n++] = exportFloodFill.getWaves()[i][j];
+                exportFloodFill.compute(knnGraph, p);
+
+                encodeFlood(exportFloodFill, settings, records[p - batchStart]);
             }
+        });
+
+        batchSpan.end();
+
+        // Write in point order so the output doesn't depend on thread scheduling
+        for (int p = batchStart; p < batchEnd; p++)
+        {
+            const FloodRecord& record = records[p - batchStart];
+            myfile.write(record.bytes.data(), record.bytes.size());
+
+            if (binary)
+            {
+                offsets.push_back(offsets.back() + record.bytes.size());
+                waveOffsets.insert(waveOffsets.end(), record.waveOffsets.begin(), record.waveOffsets.end());
+            }
+        }
+
+        if (!myfile)
+        {
+            std::cout << "Failed writing flood nodes to file!" << std::endl;
+            completed = false;
+            break;
         }
+
+        if (progressCallback && !progressCallback(batchEnd, numPoints))
+        {
+            std::cout << "Flood node export cancelled" << std::endl;
+            completed = false;
+            break;
+        }
+    }
+
+    if (completed && binary)
+    {
+        sectionPositions[0] = (uint64_t) myfile.tellp();
+        myfile.write((char*) offsets.data(), offsets.size() * sizeof(uint64_t));
+        sectionPositions[1] = (uint64_t) myfile.tellp();
+        myfile.write((char*) waveOffsets.data(), waveOffsets.size() * sizeof(uint32_t));
+
+        myfile.seekp(sectionPositionsPos);
+        myfile.write((char*) sectionPositions, sizeof(sectionPositions));
+
+        completed = (bool) myfile;
+    }
+
+    myfile.close();
+
+    // Don't leave partial exports behind
+    if (!completed)
+    {
+        std::remove(fileName.c_str());
+        return false;
     }
 
-    writeFloodNodes(perPointFloodNodes);
+    std::cout << "Flood nodes written to file: " << fileName << std::endl;
+    return true;
 }
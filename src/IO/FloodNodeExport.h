@@ -1,10 +1,33 @@
 #pragma once
 
-#include <vector>
+#include "ExportCommon.h"
 
 class FloodFill;
 class KnnGraph;
 
-void writeFloodNodes(const std::vector<std::vector<int>>& floodNodes);
+enum class FloodNodeExportFormat
+{
+    BINARY,     /** Binary CSR layout of offsets, wave offsets and nodes */
+    CSV         /** One line per point with -1 as wave separator, roughly 10x the binary size */
+};
 
-void exportFloodNodes(int numPoints, FloodFill& floodFill, KnnGraph& knnGraph);
+struct FloodNodeExportSettings
+{
+    FloodNodeExportFormat   format              = FloodNodeExportFormat::BINARY;
+    bool                    deltaCompressed     = false;    /** Sort nodes within each wave and store them as varint deltas */
+    int                     batchSize           = 1024;     /** Number of floods buffered before they are written to disk */
+};
+
+/**
+ * Compute the flood of every point and stream the flood nodes to disk in point order.
+ *
+ * Binary layout (little endian):
+ *   char[4] "SWFN", uint32 version, uint32 numPoints, uint32 numWaves, uint32 flags (bit 0: delta compressed),
+ *   uint64 file position of the offsets, uint64 file position of the wave offsets,
+ *   nodes: per point either int32 node indices, or per wave the unsigned LEB128 varint deltas of the sorted nodes,
+ *   offsets: numPoints + 1 uint64 byte offsets of each point into the nodes section,
+ *   wave offsets: numPoints x (numWaves + 1) uint32 node offsets of each wave within the point
+ *
+ * @return False if the export was cancelled or the file could not be written
+ */
+bool exportFloodNodes(int numPoints, const FloodFill& floodFill, const KnnGraph& knnGraph, const FloodNodeExportSettings& settings, const ExportProgressCallback& progressCallback = nullptr);
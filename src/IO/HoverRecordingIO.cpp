@@ -0,0 +1,273 @@
+#include "HoverRecordingIO.h"
+
+#include "ExportCommon.h"
+#include "Compute/HoverReplay.h"
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    constexpr char MAGIC[4] = { 'S', 'W', 'H', 'R' };
+    constexpr std::uint32_t VERSION = 1;
+
+    template<typename T>
+    void writeValue(std::ofstream& file, const T& value)
+    {
+        file.write((const char*) &value, sizeof(T));
+    }
+
+    template<typename T>
+    void readValue(std::ifstream& file, T& value)
+    {
+        file.read((char*) &value, sizeof(T));
+    }
+
+    template<typename T>
+    void writeList(std::ofstream& file, const std::vector<T>& values)
+    {
+        writeValue(file, (std::uint64_t) values.size());
+        file.write((const char*) values.data(), values.size() * sizeof(T));
+    }
+
+    template<typename T>
+    bool readList(std::ifstream& file, std::vector<T>& values)
+    {
+        std::uint64_t size = 0;
+        readValue(file, size);
+        if (!file)
+            return false;
+
+        values.resize(size);
+        file.read((char*) values.data(), size * sizeof(T));
+        return (bool) file;
+    }
+
+    void writeMatrix(std::ofstream& file, const DataMatrix& matrix)
+    {
+        writeValue(file, (std::int32_t) matrix.rows());
+        writeValue(file, (std::int32_t) matrix.cols());
+        file.write((const char*) matrix.data(), matrix.size() * sizeof(float));
+    }
+
+    bool readMatrix(std::ifstream& file, DataMatrix& matrix)
+    {
+        std::int32_t rows = 0, cols = 0;
+        readValue(file, rows);
+        readValue(file, cols);
+        if (!file || rows < 0 || cols < 0)
+            return false;
+
+        matrix.resize(rows, cols);
+        file.read((char*) matrix.data(), matrix.size() * sizeof(float));
+        return (bool) file;
+    }
+
+    void writeEvent(std::ofstream& file, const HoverEvent& event)
+    {
+        const HoverSettings& settings = event.settings;
+
+        writeValue(file, event.time);
+        writeValue(file, (std::int32_t) event.selectedPoint);
+        writeValue(file, (std::int32_t) event.seedPoint);
+        writeValue(file, event.cursorX);
+        writeValue(file, event.cursorY);
+        writeValue(file, (std::int32_t) event.selectedDimension);
+
+        writeValue(file, (std::int32_t) settings.filterType);
+        writeValue(file, (std::int32_t) settings.overlayType);
+        writeValue(file, (std::uint8_t) settings.restrictToFlood);
+        writeValue(file, (std::uint8_t) settings.graphAvailable);
+        writeValue(file, (std::int32_t) settings.numWaves);
+        writeValue(file, (std::int32_t) settings.numRankedDimensions);
+        writeValue(file, settings.innerFilterRadius);
+        writeValue(file, settings.outerFilterRadius);
+        writeValue(file, (std::int32_t) settings.hdInnerFilterSize);
+        writeValue(file, settings.projectionSize);
+        writeValue(file, (std::int32_t) settings.numOutputPoints);
+        writeValue(file, (std::int32_t) settings.numGraphBins);
+    }
+
+    void readEvent(std::ifstream& file, HoverEvent& event)
+    {
+        HoverSettings& settings = event.settings;
+        std::int32_t filterType, overlayType;
+        std::uint8_t restrictToFlood, graphAvailable;
+
+        readValue(file, event.time);
+        readValue(file, event.selectedPoint);
+        readValue(file, event.seedPoint);
+        readValue(file, event.cursorX);
+        readValue(file, event.cursorY);
+        readValue(file, event.selectedDimension);
+
+        readValue(file, filterType);
+        readValue(file, overlayType);
+        readValue(file, restrictToFlood);
+        readValue(file, graphAvailable);
+        readValue(file, settings.numWaves);
+        readValue(file, settings.numRankedDimensions);
+        readValue(file, settings.innerFilterRadius);
+        readValue(file, settings.outerFilterRadius);
+        readValue(file, settings.hdInnerFilterSize);
+        readValue(file, settings.projectionSize);
+        readValue(file, settings.numOutputPoints);
+        readValue(file, settings.numGraphBins);
+
+        settings.filterType = (filters::FilterType) filterType;
+        settings.overlayType = (OverlayType) overlayType;
+        settings.restrictToFlood = restrictToFlood != 0;
+        settings.graphAvailable = graphAvailable != 0;
+    }
+}
+
+bool HoverRecordingImporter::read(const std::string& fileName, HoverRecording& recording)
+{
+    std::ifstream file(fileName, std::ios::in | std::ios::binary);
+    if (!file)
+    {
+        std::cout << "Cannot open file for reading hover recording!" << std::endl;
+        return false;
+    }
+
+    char magic[4] = {};
+    std::uint32_t version = 0;
+    file.read(magic, sizeof(magic));
+    readValue(file, version);
+    if (!file || std::string(magic, 4) != std::string(MAGIC, 4) || version != VERSION)
+    {
+        std::cout << "File is not a hover recording of a known version: " << fileName << std::endl;
+        return false;
+    }
+
+    bool valid = readMatrix(file, recording.baseData) &&
+        readList(file, recording.variances) &&
+        readList(file, recording.viewIndices) &&
+        readMatrix(file, recording.projection) &&
+        readList(file, recording.mask);
+
+    std::uint64_t numPoints = 0;
+    readValue(file, numPoints);
+
+    std::vector<std::vector<nint>>& neighbours = recording.knnGraph._neighbours;
+    neighbours.resize(valid && file ? numPoints : 0);
+    for (std::vector<nint>& pointNeighbours : neighbours)
+        valid = valid && readList(file, pointNeighbours);
+    recording.knnGraph._numNeighbours = neighbours.empty() ? 0 : (int) neighbours[0].size();
+
+    valid = valid && readList(file, recording.localHighDimensionality);
+    readValue(file, recording.numProjectionViews);
+
+    std::uint64_t numEvents = 0;
+    readValue(file, numEvents);
+    recording.events.resize(valid && file ? numEvents : 0);
+    for (HoverEvent& event : recording.events)
+        readEvent(file, event);
+
+    if (!valid || !file)
+    {
+        std::cout << "Failed reading hover recording: " << fileName << std::endl;
+        return false;
+    }
+
+    std::cout << "Read hover recording of " << recording.events.size() << " events on " << recording.baseData.rows() << " points" << std::endl;
+    return true;
+}
+
+bool HoverRecordingImporter::readEvents(const std::string& fileName, const HoverEvent& prototype, std::vector<HoverEvent>& events)
+{
+    std::ifstream file(fileName);
+    if (!file)
+    {
+        std::cout << "Cannot open file for reading hover events!" << std::endl;
+        return false;
+    }
+
+    events.clear();
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream lineStream(line);
+        std::string type;
+        HoverEvent event = prototype;
+        event.selectedPoint = -1;
+        event.seedPoint = -1;
+
+        bool valid = false;
+        if (lineStream >> type >> event.time)
+        {
+            if (type == "point")
+            {
+                valid = (bool) (lineStream >> event.selectedPoint);
+                if (!(lineStream >> event.seedPoint))
+                    event.seedPoint = -1;
+            }
+            else if (type == "cursor")
+                valid = (bool) (lineStream >> event.cursorX >> event.cursorY);
+        }
+
+        if (!valid)
+        {
+            std::cout << "Malformed hover event on line " << lineNumber << " of " << fileName << std::endl;
+            return false;
+        }
+
+        events.push_back(event);
+    }
+
+    return true;
+}
+
+std::string HoverRecordingExporter::write(const HoverRecording& recording)
+{
+    std::string fileName = createTimestampedFileName("hover_recording", ".swhr");
+    return write(recording, fileName) ? fileName : std::string();
+}
+
+bool HoverRecordingExporter::write(const HoverRecording& recording, const std::string& fileName)
+{
+    std::ofstream file(fileName, std::ios::out | std::ios::binary);
+    if (!file)
+    {
+        std::cout << "Cannot open file for writing hover recording!" << std::endl;
+        return false;
+    }
+
+    file.write(MAGIC, sizeof(MAGIC));
+    writeValue(file, VERSION);
+
+    writeMatrix(file, recording.baseData);
+    writeList(file, recording.variances);
+    writeList(file, recording.viewIndices);
+    writeMatrix(file, recording.projection);
+    writeList(file, recording.mask);
+
+    const std::vector<std::vector<nint>>& neighbours = recording.knnGraph.getNeighbours();
+    writeValue(file, (std::uint64_t) neighbours.size());
+    for (const std::vector<nint>& pointNeighbours : neighbours)
+        writeList(file, pointNeighbours);
+
+    writeList(file, recording.localHighDimensionality);
+    writeValue(file, (std::int32_t) recording.numProjectionViews);
+
+    writeValue(file, (std::uint64_t) recording.events.size());
+    for (const HoverEvent& event : recording.events)
+        writeEvent(file, event);
+
+    if (!file)
+    {
+        std::cout << "Failed writing hover recording to file!" << std::endl;
+        return false;
+    }
+
+    std::cout << "Hover recording of " << recording.events.size() << " events written to file: " << fileName << std::endl;
+    return true;
+}
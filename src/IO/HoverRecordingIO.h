@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct HoverRecording;
+struct HoverEvent;
+
+/**
+ * Binary hover recordings (little endian):
+ *   char[4] "SWHR", uint32 version,
+ *   matrix baseData, floats variances, ints viewIndices, matrix projection, ints mask,
+ *   uint64 numPoints x ints neighbours, floats localHighDimensionality, int32 numProjectionViews,
+ *   uint64 numEvents x event
+ * where a matrix is int32 rows, int32 cols and rows x cols float32 in column-major order,
+ * and a list is a uint64 length followed by its values.
+ */
+class HoverRecordingImporter
+{
+public:
+    /** @return False if the file could not be read or has an unknown version */
+    static bool read(const std::string& fileName, HoverRecording& recording);
+
+    /**
+     * Read a cursor path or sequence of selections from a text file, one event per line:
+     *   point <time ms> <selected point> [<seed point>]
+     *   cursor <time ms> <x> <y>
+     * Cursor positions are in projection coordinates, lines starting with # are skipped.
+     * Events get the given settings, e.g. those of the first recorded event.
+     * @return False if the file could not be read or has a malformed line
+     */
+    static bool readEvents(const std::string& fileName, const HoverEvent& prototype, std::vector<HoverEvent>& events);
+};
+
+class HoverRecordingExporter
+{
+public:
+    /** Write to a timestamped file in the working directory, @return Name of the file, empty if it could not be written */
+    static std::string write(const HoverRecording& recording);
+    static bool write(const HoverRecording& recording, const std::string& fileName);
+};
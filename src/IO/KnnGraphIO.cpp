@@ -1,5 +1,6 @@
 #include "KnnGraphIO.h"
 
+#include "ExportCommon.h"
 #include "Types.h"
 #include "Compute/KnnGraph.h"
 
@@ -8,15 +9,15 @@
 #include <iostream>
 #include <iomanip>
 
-void KnnGraphImporter::read(QString filePath, KnnGraph& graph)
+void KnnGraphImporter::read(const std::string& filePath, KnnGraph& graph)
 {
-    std::ifstream myfile(filePath.toStdString(), std::ios::in | std::ios::binary);
+    std::ifstream myfile(filePath, std::ios::in | std::ios::binary);
     if (!myfile) {
         std::cout << "Cannot open file for reading KNN graph!" << std::endl;
         return;
     }
 
-    std::cout << "Reading KNN file: " << filePath.toStdString() << std::endl;
+    std::cout << "Reading KNN file: " << filePath << std::endl;
     auto& neighbours = graph._neighbours;
 
     char intType;
@@ -45,6 +46,11 @@ void KnnGraphImporter::read(QString filePath, KnnGraph& graph)
 }
 
 void KnnGraphExporter::write(const KnnGraph& graph)
+{
+    write(graph, createTimestampedFileName("knngraph", ".knn"));
+}
+
+void KnnGraphExporter::write(const KnnGraph& graph, const std::string& fileName)
 {
     const std::vector<std::vector<int>>& neighbours = graph.getNeighbours();
     uint32_t numPoints = (uint32_t) neighbours.size();
@@ -61,15 +67,8 @@ void KnnGraphExporter::write(const KnnGraph& graph)
     }
     std::cout << "Linearized data for export" << std::endl;
     // Write to file
-    auto t = std::time(nullptr);
-    auto tm = *std::localtime(&t);
-
-    std::ostringstream fileName;
-    fileName << "knngraph";
-    fileName << std::put_time(&tm, "%d-%m-%Y %H-%M-%S");
-    fileName << ".knn";
-    std::cout << "Writing to file: " << fileName.str() << std::endl;
-    std::ofstream myfile(fileName.str(), std::ios::out | std::ios::binary);
+    std::cout << "Writing to file: " << fileName << std::endl;
+    std::ofstream myfile(fileName, std::ios::out | std::ios::binary);
     if (!myfile) {
         std::cout << "Cannot open file for writing KNN graph!" << std::endl;
         return;
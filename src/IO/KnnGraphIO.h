@@ -1,17 +1,19 @@
 #pragma once
 
-#include <QString>
+#include <string>
 
 class KnnGraph;
 
 class KnnGraphImporter
 {
 public:
-    static void read(QString filePath, KnnGraph& graph);
+    static void read(const std::string& filePath, KnnGraph& graph);
 };
 
 class KnnGraphExporter
 {
 public:
+    /** Write to a timestamped file in the working directory */
     static void write(const KnnGraph& graph);
+    static void write(const KnnGraph& graph, const std::string& fileName);
 };
@@ -4,64 +4,212 @@
 #include "Compute/FloodFill.h"
 #include "Compute/KnnGraph.h"
 #include "Compute/Filters.h"
+#include "Compute/TaskScheduler.h"
+#include "Tracing.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
 #include <vector>
 #include <iostream>
 #include <fstream>
-#include <sstream>
-#include <iomanip>
-#include <ctime>
+#include <string>
 
-#pragma warning(push)
-#pragma warning(disable:4996) // Disable security warning of localtime
-void writeDimensionRanking(const std::vector<std::vector<int>>& ranking, const std::vector<QString>& names)
+namespace
 {
-    auto t = std::time(nullptr);
-    auto tm = *std::localtime(&t);
+    /** Per-thread state of the export, filters keep their ranking buffers alive between points */
+    struct RankingWorker
+    {
+        RankingWorker(const filters::SpatialPeakFilter& spatialFilter, const filters::HDFloodPeakFilter& hdFilter, int numWaves, int topK) :
+            spatialFilter(spatialFilter),
+            hdFilter(hdFilter),
+            floodFill(numWaves)
+        {
+            this->spatialFilter.setTopK(topK);
+            this->hdFilter.setTopK(topK);
+        }
 
-    std::ostringstream fileName;
-    fileName << "rankings";
-    fileName << std::put_time(&tm, "%d-%m-%Y %H-%M-%S");
-    fileName << ".csv";
+        filters::SpatialPeakFilter  spatialFilter;
+        filters::HDFloodPeakFilter  hdFilter;
+        FloodFill                   floodFill;
+        std::vector<int>            dimRanking;
+    };
 
-    std::ofstream myfile;
-    myfile.open(fileName.str());
-    for (int i = 0; i < ranking.size(); i++)
+    class RankingWriter
     {
-        for (int d = 0; d < ranking[i].size(); d++)
+    public:
+        RankingWriter(RankingExportFormat format, const std::vector<std::string>& names, int topK) :
+            _format(format),
+            _topK(topK),
+            _names(names)
         {
-            if (d != 0) myfile << ',';
-            myfile << names[ranking[i][d]].toStdString();
+
+        }
+
+        bool open(const std::string& fileName, int numPoints)
+        {
+            if (_format == RankingExportFormat::BINARY)
+                _file.open(fileName, std::ios::out | std::ios::binary);
+            else
+                _file.open(fileName, std::ios::out);
+
+            if (!_file)
+                return false;
+
+            if (_format == RankingExportFormat::BINARY)
+            {
+                const char magic[4] = { 'S', 'W', 'R', 'K' };
+                uint32_t header[4] = { 1, (uint32_t) numPoints, (uint32_t) _names.size(), (uint32_t) _topK };
+
+                _file.write(magic, sizeof(magic));
+                _file.write((char*) header, sizeof(header));
+
+                for (const std::string& name : _names)
+                {
+                    uint32_t length = (uint32_t) name.size();
+                    _file.write((char*) &length, sizeof(uint32_t));
+                    _file.write(name.data(), length);
+                }
+            }
+
+            return (bool) _file;
+        }
+
+        /** Write rankings of numPoints consecutive points, stored as topK indices and scores per point */
+        bool writeBatch(const std::vector<int>& indices, const std::vector<float>& scores, int numPoints)
+        {
+            if (_format == RankingExportFormat::BINARY)
+            {
+                for (int i = 0; i < numPoints; i++)
+                {
+                    _file.write((char*) &indices[(size_t) i * _topK], _topK * sizeof(int32_t));
+                    _file.write((char*) &scores[(size_t) i * _topK], _topK * sizeof(float));
+                }
+            }
+            else
+            {
+                std::string line;
+                for (int i = 0; i < numPoints; i++)
+                {
+                    line.clear();
+                    for (int k = 0; k < _topK; k++)
+                    {
+                        if (k != 0) line += ',';
+                        line += _names[indices[(size_t) i * _topK + k]];
+                    }
+                    line += '\n';
+                    _file.write(line.data(), line.size());
+                }
+            }
+
+            return (bool) _file;
+        }
+
+        void close()
+        {
+            _file.close();
         }
-        myfile << std::endl;
-    }
 
-    myfile.close();
-    std::cout << "Rankings written to file" << std::endl;
+    private:
+        RankingExportFormat         _format;
+        int                         _topK;
+        std::vector<std::string>    _names;
+        std::ofstream               _file;
+    };
 }
-#pragma warning(pop)
 
-void exportRankings(DataStorage& dataStore, FloodFill& floodFill, KnnGraph& knnGraph, filters::FilterType filterType, filters::SpatialPeakFilter spatialFilter, filters::HDFloodPeakFilter hdFilter, bool restrictToFloodNodes, const std::vector<QString>& names)
+bool exportRankings(DataStorage& dataStore, const FloodFill& floodFill, const KnnGraph& knnGraph, filters::FilterType filterType, const filters::SpatialPeakFilter& spatialFilter, const filters::HDFloodPeakFilter& hdFilter, bool restrictToFloodNodes, const std::vector<std::string>& names, const RankingExportSettings& settings, const ExportProgressCallback& progressCallback)
 {
-    std::vector<std::vector<int>> perPointDimRankings(dataStore.getNumPoints());
-    for (int i = 0; i < dataStore.getNumPoints(); i++)
+    TRACE_SCOPE("Ranking export");
+
+    int numPoints = dataStore.getNumPoints();
+    int numDimensions = dataStore.getNumDimensions();
+    int topK = (settings.topK <= 0 || settings.topK > numDimensions) ? numDimensions : settings.topK;
+    int batchSize = std::max(settings.batchSize, 1);
+
+    // Only the HD filter and the restricted spatial filter need a flood per point
+    bool needsFlood = filterType == filters::FilterType::HD_PEAK || restrictToFloodNodes;
+
+    std::vector<RankingWorker> workers(tasks::getNumSlots(), RankingWorker(spatialFilter, hdFilter, floodFill.getNumWaves(), topK));
+
+    std::string fileName = createTimestampedFileName("rankings", settings.format == RankingExportFormat::BINARY ? ".swrank" : ".csv");
+
+    RankingWriter writer(settings.format, names, topK);
+    if (!writer.open(fileName, numPoints))
     {
-        FloodFill exportFloodFill(floodFill.getNumWaves());
-        exportFloodFill.compute(knnGraph, i);
+        std::cout << "Cannot open file for writing rankings!" << std::endl;
+        return false;
+    }
 
-        switch (filterType)
+    std::vector<int> batchIndices((size_t) batchSize * topK);
+    std::vector<float> batchScores((size_t) batchSize * topK);
+
+    bool completed = true;
+    for (int batchStart = 0; batchStart < numPoints; batchStart += batchSize)
+    {
+        int batchEnd = std::min(batchStart + batchSize, numPoints);
+
+        TRACE_SPAN(batchSpan, "Ranking export batch");
+        tasks::parallelForRanges(batchStart, batchEnd, 16, [&](int rangeBegin, int rangeEnd, int slot)
         {
-        case filters::FilterType::SPATIAL_PEAK:
-            if (restrictToFloodNodes)
-                spatialFilter.computeDimensionRanking(i, dataStore.getDataView(), dataStore.getVariances(), dataStore.getProjectionView(), dataStore.getProjectionSize(), perPointDimRankings[i], exportFloodFill.getAllNodes());
-            else
-                spatialFilter.computeDimensionRanking(i, dataStore.getDataView(), dataStore.getVariances(), dataStore.getProjectionView(), dataStore.getProjectionSize(), perPointDimRankings[i]);
+            RankingWorker& worker = workers[slot];
+            for (int i = rangeBegin; i < rangeEnd; i++)
+            {
+                if (needsFlood)
+                    worker.floodFill.compute(knnGraph, i);
+
+                const std::vector<float>* scores = nullptr;
+                switch (filterType)
+                {
+                case filters::FilterType::SPATIAL_PEAK:
+                    if (restrictToFloodNodes)
+                        worker.spatialFilter.computeDimensionRanking(i, dataStore.getDataView(), dataStore.getVariances(), dataStore.getProjectionView(), dataStore.getProjectionSize(), worker.dimRanking, worker.floodFill.getAllNodes());
+                    else
+                        worker.spatialFilter.computeDimensionRanking(i, dataStore.getDataView(), dataStore.getVariances(), dataStore.getProjectionView(), dataStore.getProjectionSize(), worker.dimRanking);
+                    scores = &worker.spatialFilter.getRanker().getScores();
+                    break;
+                case filters::FilterType::HD_PEAK:
+                    worker.hdFilter.computeDimensionRanking(i, dataStore.getDataView(), dataStore.getVariances(), worker.floodFill, worker.dimRanking);
+                    scores = &worker.hdFilter.getRanker().getScores();
+                    break;
+                }
+
+                size_t offset = (size_t) (i - batchStart) * topK;
+                for (int k = 0; k < topK; k++)
+                {
+                    int dim = worker.dimRanking[k];
+                    batchIndices[offset + k] = dim;
+                    batchScores[offset + k] = (*scores)[dim];
+                }
+            }
+        });
+
+        batchSpan.end();
+
+        if (!writer.writeBatch(batchIndices, batchScores, batchEnd - batchStart))
+        {
+            std::cout << "Failed writing rankings to file!" << std::endl;
+            completed = false;
             break;
-        case filters::FilterType::HD_PEAK:
-            hdFilter.computeDimensionRanking(i, dataStore.getDataView(), dataStore.getVariances(), exportFloodFill, perPointDimRankings[i]);
+        }
+
+        if (progressCallback && !progressCallback(batchEnd, numPoints))
+        {
+            std::cout << "Ranking export cancelled" << std::endl;
+            completed = false;
             break;
         }
     }
 
-    writeDimensionRanking(perPointDimRankings, names);
+    writer.close();
+
+    // Don't leave partial exports behind
+    if (!completed)
+    {
+        std::remove(fileName.c_str());
+        return false;
+    }
+
+    std::cout << "Rankings written to file: " << fileName << std::endl;
+    return true;
 }
@@ -1,6 +1,9 @@
 #pragma once
 
-#include <QString>
+#include "ExportCommon.h"
+
+#include <string>
+#include <vector>
 
 class DataStorage;
 class FloodFill;
@@ -13,6 +16,27 @@ namespace filters
     class HDFloodPeakFilter;
 }
 
-void writeDimensionRanking(const std::vector<std::vector<int>>& ranking, const std::vector<QString>& names);
+enum class RankingExportFormat
+{
+    BINARY,     /** Compact binary file with a names table, dimension indices and scores */
+    CSV         /** Dimension names per point, slower and much larger */
+};
+
+struct RankingExportSettings
+{
+    RankingExportFormat format      = RankingExportFormat::BINARY;
+    int                 topK        = 0;        /** Number of ranked dimensions written per point, 0 writes all of them */
+    int                 batchSize   = 4096;     /** Number of points ranked in parallel before they are written to disk */
+};
 
-void exportRankings(DataStorage& dataStore, FloodFill& floodFill, KnnGraph& knnGraph, filters::FilterType filterType, filters::SpatialPeakFilter spatialFilter, filters::HDFloodPeakFilter hdFilter, bool restrictToFloodNodes, const std::vector<QString>& names);
+/**
+ * Rank the dimensions of every point in the data view and stream the results to disk.
+ *
+ * Binary layout (little endian):
+ *   char[4] "SWRK", uint32 version, uint32 numPoints, uint32 numDimensions, uint32 topK,
+ *   numDimensions x (uint32 byte length, UTF-8 name),
+ *   numPoints x (topK x int32 dimension index, topK x float32 score)
+ *
+ * @return False if the export was cancelled or the file could not be written
+ */
+bool exportRankings(DataStorage& dataStore, const FloodFill& floodFill, const KnnGraph& knnGraph, filters::FilterType filterType, const filters::SpatialPeakFilter& spatialFilter, const filters::HDFloodPeakFilter& hdFilter, bool restrictToFloodNodes, const std::vector<std::string>& names, const RankingExportSettings& settings, const ExportProgressCallback& progressCallback = nullptr);
@@ -1,84 +1,64 @@
 #include "SpaceWalkerPlugin.h"
 
 #include "ScatterplotWidget.h"
+#include "Tracing.h"
 
 #include "ClusterData/ClusterData.h"
 
+#include <QScreen>
+
 #include <algorithm>
 #include <iostream>
 
 namespace
 {
-    Matrix3f createProjectionToUVMatrix(const Bounds& projectionBounds, const QSizeF& widgetDimensions)
+    // Minimum time between selection notifications to the core while dragging
+    constexpr int SELECTION_NOTIFY_INTERVAL = 100;
+
+    // Number of mouse samples ahead for which the selection is predicted
+    constexpr int NUM_PREDICTED_SAMPLES = 3;
+
+    /** Mouse position in projection coordinates, with the scale of projection units to widget pixels */
+    struct PickPosition
+    {
+        float x, y;
+        float scaleX, scaleY;
+    };
+
+    PickPosition mapMouseToProjection(const Bounds& bounds, const QSizeF& widgetDimensions, Vector2f mousePos)
     {
         // Bounds variables
-        float left = projectionBounds.getLeft();
-        float right = projectionBounds.getRight();
-        float bottom = projectionBounds.getBottom();
-        float top = projectionBounds.getTop();
+        float left = bounds.getLeft();
+        float right = bounds.getRight();
+        float bottom = bounds.getBottom();
+        float top = bounds.getTop();
 
-        // Widget dimension variables
+        // Widget dimension variables, the projection is shown in the largest centered square
         const auto w = widgetDimensions.width();
         const auto h = widgetDimensions.height();
         const auto size = w < h ? w : h;
 
-        // Mapping from bounds to [-1, 1]
-        Matrix3f ortho;
-        ortho[0] = 2.0f / (right - left);
-        ortho[4] = 2.0f / (top - bottom);
-        ortho[6] = -(right + left) / (right - left);
-        ortho[7] = -(top + bottom) / (top - bottom);
-
-        // Flipping the y-axis
-        Matrix3f flipMatrix;
-        flipMatrix[4] = -1;
-
-        // Scaling and biasing [-1, 1] to [0, 1]
-        Matrix3f scale;
-        scale[0] = 0.5f;
-        scale[4] = 0.5f;
-
-        Matrix3f bias;
-        bias[6] = 0.5f;
-        bias[7] = 0.5f;
-
-        // Scaling by widget square size
-        Matrix3f widgetScale;
-        widgetScale[0] = size;
-        widgetScale[4] = size;
-
-        // Translating the coordinate system by the difference between the widget dimensions and the square size inside it
-        Matrix3f widgetOffset;
-        widgetOffset[6] = (w - size) / 2.0f;
-        widgetOffset[7] = (h - size) / 2.0f;
-
-        return widgetOffset * widgetScale * bias * scale * flipMatrix * ortho;
-    }
-}
+        // Map the mouse to projection coordinates once, instead of mapping every point to widget coordinates
+        float u = (mousePos.x - (w - size) / 2.0f) / size;
+        float v = (mousePos.y - (h - size) / 2.0f) / size;
 
-int findClosestPointToMouse(const DataMatrix& projection, const Bounds& bounds, const QSizeF& widgetDimensions, Vector2f mousePos, std::vector<int> mask)
-{
-    int closestIndex = 0;
-    float minDist = std::numeric_limits<float>::max();
+        PickPosition pick;
+        pick.x = left + u * (right - left);
+        pick.y = top - v * (top - bottom);
 
-    Matrix3f boundsToWidgetCoords = createProjectionToUVMatrix(bounds, widgetDimensions);
+        // Distances are still measured in widget pixels
+        pick.scaleX = size / (right - left);
+        pick.scaleY = size / (top - bottom);
+        return pick;
+    }
 
-    for (int i = 0; i < mask.size(); i++)
+    int frameInterval(const QWidget& widget)
     {
-        int maskIndex = mask[i];
-        Vector2f pointInProjectionCoords(projection(maskIndex, 0), projection(maskIndex, 1));
-        Vector2f pointInWidgetCoords = boundsToWidgetCoords * pointInProjectionCoords;
+        const QScreen* screen = widget.screen();
+        qreal refreshRate = screen != nullptr ? screen->refreshRate() : 0;
 
-        // Find closest point to mouse coordinates
-        float dist = (pointInWidgetCoords - mousePos).sqrMagnitude();
-
-        if (dist < minDist)
-        {
-            closestIndex = i;
-            minDist = dist;
-        }
+        return refreshRate > 0 ? std::max(1, (int) (1000 / refreshRate)) : 16;
     }
-    return closestIndex;
 }
 
 void SpaceWalkerPlugin::notifyNewSelectedPoint()
@@ -100,18 +80,60 @@ void SpaceWalkerPlugin::notifyNewSelectedPoint()
     events().notifyDatasetDataSelectionChanged(_positionDataset);
 }
 
+void SpaceWalkerPlugin::scheduleSelectionNotification()
+{
+    if (!_selectionNotifyTimer->isActive())
+        _selectionNotifyTimer->start(SELECTION_NOTIFY_INTERVAL);
+}
+
+void SpaceWalkerPlugin::flushSelectionNotification()
+{
+    _selectionNotifyTimer->stop();
+
+    // The hover pipeline already ran for this point, only other plugins need to hear about it
+    _notifyingOwnSelection = true;
+    notifyNewSelectedPoint();
+    _notifyingOwnSelection = false;
+}
+
+void SpaceWalkerPlugin::scheduleMousePosition(Vector2f mousePos)
+{
+    _pendingMousePos = mousePos;
+    _hasPendingMousePos = true;
+
+    // The first sample is processed right away, later ones wait for the end of the frame
+    if (!_mouseFrameTimer->isActive())
+        processPendingMousePosition();
+}
+
+void SpaceWalkerPlugin::processPendingMousePosition()
+{
+    if (!_hasPendingMousePos)
+        return;
+
+    _hasPendingMousePos = false;
+    _mouseFrameTimer->start(frameInterval(getWidget()));
+
+    if (_positionDataset.isValid())
+        mousePositionChanged(_pendingMousePos);
+}
+
 void SpaceWalkerPlugin::mousePositionChanged(Vector2f mousePos)
 {
     hdps::Bounds bounds = _scatterPlotWidget->getBounds();
 
-    // Loop over either all points or only the masked points and establish whether they are selected or not
-    std::vector<int> full(_dataStore.getNumPoints());
-    std::iota(full.begin(), full.end(), 0);
+    // Pick among all points or only the masked points, with a mask the position in the mask is returned
     QSizeF widgetDimensions(_scatterPlotWidget->width(), _scatterPlotWidget->height());
-    int selectedPoint = findClosestPointToMouse(_dataStore.getProjectionView(), bounds, widgetDimensions, mousePos, _mask.empty() ? full : _mask);
+    PickPosition pick = mapMouseToProjection(bounds, widgetDimensions, mousePos);
+    int selectedPoint = _pointGrid.findNearest(pick.x, pick.y, pick.scaleX, pick.scaleY, _maskPositions);
+
+    Vector2f lastPickPosition = _lastPickPosition;
+    bool hasLastPickPosition = _hasLastPickPosition;
+    _lastPickPosition.set(pick.x, pick.y);
+    _hasLastPickPosition = true;
 
     // Check if the selected point is the same as the previous, then dont update
-    if (selectedPoint == _selectedPoint)
+    if (selectedPoint < 0 || selectedPoint == _selectedPoint)
         return;
 
     _selectedPoint = selectedPoint;
@@ -120,7 +142,29 @@ void SpaceWalkerPlugin::mousePositionChanged(Vector2f mousePos)
     else
         _globalSelectedPoint = _mask.empty() ? _selectedPoint : _mask[_selectedPoint];
 
-    notifyNewSelectedPoint();
+    // Extrapolate the cursor path, the hover worker computes these selections when it is idle
+    _prefetchCandidates.clear();
+    if (hasLastPickPosition)
+    {
+        const std::vector<int>& viewIndices = _dataStore.getViewIndices();
+        float dx = pick.x - lastPickPosition.x;
+        float dy = pick.y - lastPickPosition.y;
+
+        for (int step = 1; step <= NUM_PREDICTED_SAMPLES; step++)
+        {
+            int candidate = _pointGrid.findNearest(pick.x + dx * step, pick.y + dy * step, pick.scaleX, pick.scaleY, _maskPositions);
+            if (candidate < 0 || candidate == _selectedPoint)
+                continue;
+            if (!_prefetchCandidates.empty() && _prefetchCandidates.back().selectedPoint == candidate)
+                continue;
+
+            _prefetchCandidates.push_back({ candidate, viewIndices.size() > 0 ? viewIndices[candidate] : candidate });
+        }
+    }
+
+    // Go straight to the hover pipeline instead of round-tripping through the core
+    submitHoverJob();
+    scheduleSelectionNotification();
 }
 
 bool SpaceWalkerPlugin::eventFilter(QObject* target, QEvent* event)
@@ -143,6 +187,7 @@ bool SpaceWalkerPlugin::eventFilter(QObject* target, QEvent* event)
         qDebug() << "Mouse button press" << mouseEvent->button();
 
         _mousePressed = true;
+        _hasLastPickPosition = false;
 
         _selectedViewIndex = 0;
         updateViewScalars();
@@ -156,6 +201,23 @@ bool SpaceWalkerPlugin::eventFilter(QObject* target, QEvent* event)
 
         _mousePressed = false;
 
+        // Finish the drag with the last mouse position
+        processPendingMousePosition();
+        _mouseFrameTimer->stop();
+
+        if (_selectionNotifyTimer->isActive())
+            flushSelectionNotification();
+
+        // Linked views get the final state of the interaction without waiting for the rate limit
+        _floodScalarPublisher.flush();
+
+        // Instrumentation is only printed while tracing is enabled
+        if (tracing::isEnabled())
+        {
+            reportPrefetchStats();
+            tracing::printStageStatistics();
+        }
+
         break;
     }
 
@@ -184,8 +246,7 @@ bool SpaceWalkerPlugin::eventFilter(QObject* target, QEvent* event)
 
         Vector2f mousePos = Vector2f(mouseEvent->position().x(), mouseEvent->position().y());
 
-        if (_positionDataset.isValid())
-            mousePositionChanged(mousePos);
+        scheduleMousePosition(mousePos);
 
         break;
     }
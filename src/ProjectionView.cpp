@@ -1,5 +1,7 @@
 #include "ProjectionView.h"
 
+#include "Tracing.h"
+
 #include "util/Exception.h"
 
 #include <vector>
@@ -218,6 +220,8 @@ namespace {
 
 void ProjectionView::paintGL()
 {
+    TRACE_SCOPE("Render projection view");
+
     try {
         QPainter painter;
 
@@ -1,5 +1,6 @@
 #include "ScatterplotWidget.h"
 #include "Application.h"
+#include "Tracing.h"
 
 #include "util/PixelSelectionTool.h"
 #include "util/Math.h"
@@ -228,12 +229,26 @@ void ScatterplotWidget::setHighlights(const std::vector<char>& highlights, const
 
 void ScatterplotWidget::setScalars(const std::vector<float>& scalars)
 {
+    _colorScalars = scalars;
+
     _pointRenderer.setColorChannelScalars(scalars);
     _cellRenderer.setColorChannelScalars(scalars);
     
     update();
 }
 
+void ScatterplotWidget::updateScalars(const std::vector<int>& indices, const std::vector<float>& scalars)
+{
+    for (int i = 0; i < indices.size(); i++)
+        _colorScalars[indices[i]] = scalars[i];
+
+    // The point renderer only accepts complete scalar channels, cells are updated in place
+    _pointRenderer.setColorChannelScalars(_colorScalars);
+    _cellRenderer.updateColorChannelScalars(indices, scalars);
+
+    update();
+}
+
 void ScatterplotWidget::setColors(const std::vector<Vector3f>& colors)
 {
     _pointRenderer.setColors(colors);
@@ -471,6 +486,8 @@ void ScatterplotWidget::resizeGL(int w, int h)
 
 void ScatterplotWidget::paintGL()
 {
+    TRACE_SCOPE("Render scatterplot");
+
     try {
         QPainter painter;
 
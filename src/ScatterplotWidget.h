@@ -68,6 +68,13 @@ public:
     void setHighlights(const std::vector<char>& highlights, const std::int32_t& numSelectedPoints);
     void setScalars(const std::vector<float>& scalars);
 
+    /**
+     * Change the color scalars of a few points, the scalars must have been set before
+     * @param indices Point indices, later entries overwrite earlier ones of the same point
+     * @param scalars New scalar of each point in indices
+     */
+    void updateScalars(const std::vector<int>& indices, const std::vector<float>& scalars);
+
     /**
      * Set colors for each individual data point
      * @param colors Vector of colors (size must match that of the loaded points dataset)
@@ -196,6 +203,7 @@ private:
     //PixelSelectionTool      _pixelSelectionTool;
     std::vector<std::vector<Vector2f>> _randomWalks;
     std::vector<Vector2f>   _directions;
+    std::vector<float>      _colorScalars;                      /** Color scalars of the points, kept for partial updates */
     bool                    _showRandomWalk;
     bool                    _showDirections;
     bool                    _showFilterCircles = true;
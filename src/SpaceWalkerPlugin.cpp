@@ -23,9 +23,12 @@
 #include "Compute/RandomWalks.h"
 #include "Compute/DataTransformations.h"
 #include "Compute/Directions.h"
+#include "Compute/TaskScheduler.h"
 #include "IO/RankingExport.h"
 #include "IO/FloodNodeExport.h"
-#include "Timer.h"
+#include "IO/HoverRecordingIO.h"
+#include "IO/KnnGraphIO.h"
+#include "Tracing.h"
 #include "Types.h"
 
 #include <QtCore>
@@ -36,10 +39,13 @@
 #include <QMetaType>
 #include <QVector>
 #include <QFileDialog>
+#include <QProgressDialog>
+#include <QThread>
 
 #include <algorithm>
 #include <functional>
 #include <limits>
+#include <memory>
 #include <set>
 #include <vector>
 #include <iostream>
@@ -53,6 +59,15 @@ using namespace hdps::util;
 
 namespace
 {
+    // Number of dimensions ranked per selection, covers the projection views and the graph highlights
+    constexpr int DEFAULT_NUM_RANKED_DIMENSIONS = 10;
+
+    // Number of bins of the flood node histograms in the graph view
+    constexpr int DEFAULT_NUM_GRAPH_BINS = 30;
+
+    // Number of recent and prefetched selections kept by the hover worker
+    constexpr int SELECTION_CACHE_SIZE = 32;
+
     void normalizeVector(std::vector<float>& v)
     {
         // Store scalars in floodfill dataset
@@ -71,11 +86,10 @@ namespace
         {
             float invScalarRange = 1.0f / (scalarMax - scalarMin);
             // Normalize the scalars
-#pragma omp parallel for
-            for (int i = 0; i < v.size(); i++)
+            tasks::parallelFor(0, (int) v.size(), [&](int i)
             {
                 v[i] = (v[i] - scalarMin) * invScalarRange;
-            }
+            });
         }
     }
 }
@@ -94,15 +108,28 @@ SpaceWalkerPlugin::SpaceWalkerPlugin(const PluginFactory* factory) :
     _settingsAction(this, "SettingsAction"),
     _graphView(new GraphView()),
     _selectedDimension(-1),
+    _floodScalarPublisher(_floodScalars, this),
+    _selectionCache(SELECTION_CACHE_SIZE),
     _floodFill(10),
     _filterType(filters::FilterType::SPATIAL_PEAK),
     _overlayType(OverlayType::NONE),
     _colorMapAction(this, "Color map", "RdYlBu"),
     _graphTimer(new QTimer(this)),
+    _knnBuildTimer(new QTimer(this)),
+    _dataPreparationTimer(new QTimer(this)),
+    _mouseFrameTimer(new QTimer(this)),
+    _selectionNotifyTimer(new QTimer(this)),
+    _numGraphBins(DEFAULT_NUM_GRAPH_BINS),
     _filterLabel(nullptr)
 {
     setObjectName("GradientExplorer");
 
+    _derivedDataCache.setDirectory(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("SpaceWalker/DerivedData").toStdString());
+
+    initDerivedData();
+
+    setNumRankedDimensions(DEFAULT_NUM_RANKED_DIMENSIONS);
+
     getWidget().setFocusPolicy(Qt::ClickFocus);
 
     _primaryToolbarAction.addAction(&_settingsAction.getRenderModeAction(), 4, GroupAction::Horizontal);
@@ -131,6 +158,10 @@ SpaceWalkerPlugin::SpaceWalkerPlugin(const PluginFactory* factory) :
     {
         getScatterplotWidget().setColorMap(_colorMapAction.getColorMapImage().mirrored(false, true));
         getScatterplotWidget().setScalarEffect(PointEffect::Color);
+
+        // Data dropped before the views were shown
+        if (_projectionDataPending)
+            updateProjectionData();
     });
     connect(_projectionViews[0], &ProjectionView::initialized, this, [this]() {_projectionViews[0]->setColorMap(_colorMapAction.getColorMapImage().mirrored(false, true)); });
     connect(_projectionViews[1], &ProjectionView::initialized, this, [this]() {_projectionViews[1]->setColorMap(_colorMapAction.getColorMapImage().mirrored(false, true)); });
@@ -140,6 +171,18 @@ SpaceWalkerPlugin::SpaceWalkerPlugin(const PluginFactory* factory) :
     _graphTimer->setSingleShot(true);
     connect(_graphTimer, &QTimer::timeout, this, &SpaceWalkerPlugin::computeGraphs);
 
+    _mouseFrameTimer->setSingleShot(true);
+    connect(_mouseFrameTimer, &QTimer::timeout, this, &SpaceWalkerPlugin::processPendingMousePosition);
+
+    _selectionNotifyTimer->setSingleShot(true);
+    connect(_selectionNotifyTimer, &QTimer::timeout, this, &SpaceWalkerPlugin::flushSelectionNotification);
+
+    _knnBuildTimer->setInterval(100);
+    connect(_knnBuildTimer, &QTimer::timeout, this, [this]() { _settingsAction.getOverlayAction().setKnnGraphBuildProgress(_knnBuildProgress.getProgress()); });
+
+    _dataPreparationTimer->setInterval(100);
+    connect(_dataPreparationTimer, &QTimer::timeout, this, [this]() { _settingsAction.getOverlayAction().setDataPreparationProgress(_dataPreparationProgress.getProgress()); });
+
     connect(_scatterPlotWidget, &ScatterplotWidget::customContextMenuRequested, this, [this](const QPoint& point) {
         if (!_positionDataset.isValid())
             return;
@@ -262,7 +305,19 @@ SpaceWalkerPlugin::SpaceWalkerPlugin(const PluginFactory* factory) :
 
 SpaceWalkerPlugin::~SpaceWalkerPlugin()
 {
+    _hoverWorker.stop();
 
+    QThread* dataPreparationThread = _dataPreparationThread;
+    stopDataPreparation();
+    delete dataPreparationThread;
+
+    QThread* knnBuildThread = _knnBuildThread;
+    stopKnnGraphBuild();
+    delete knnBuildThread;
+
+    QThread* rankingAtlasThread = _rankingAtlasThread;
+    stopRankingAtlasBuild();
+    delete rankingAtlasThread;
 }
 
 void SpaceWalkerPlugin::init()
@@ -330,6 +385,7 @@ void SpaceWalkerPlugin::init()
 
     //_eventListener.setEventCore(Application::core());
     _eventListener.addSupportedEventType(static_cast<std::uint32_t>(EventType::DatasetDataSelectionChanged));
+    _eventListener.addSupportedEventType(static_cast<std::uint32_t>(EventType::DatasetDataDimensionsChanged));
     _eventListener.registerDataEventByType(PointType, std::bind(&SpaceWalkerPlugin::onDataEvent, this, std::placeholders::_1));
 
     // Load points when the pointer to the position dataset changes
@@ -350,6 +406,9 @@ void SpaceWalkerPlugin::init()
 
 void SpaceWalkerPlugin::resetState()
 {
+    stopDataPreparation();
+    invalidateHoverInputs();
+
     _dataStore = DataStorage();
 
     _positionSourceDataset.reset();
@@ -357,22 +416,33 @@ void SpaceWalkerPlugin::resetState()
 
     _normalizedData.clear();
     _enabledDimNames.clear();
+    _dataDimensions.clear();
     _dataInitialized = false;
+    _dataPrepared = false;
+    _projectionDataPending = false;
 
     // Interaction
     _selectedPoint = 0;
     _globalSelectedPoint = 0;
     _selectedDimension = -1;
     _mousePressed = false;
+    _hasPendingMousePos = false;
+    _mouseFrameTimer->stop();
+    _selectionNotifyTimer->stop();
     _graphTimer->stop();
     _mask.clear();
+    _maskPositions.clear();
     _selectedViewIndex = 0;
     _colorScalars.clear();
+    _floodScalarPublisher.reset();
+    _coloredIndices.clear();
+    _viewColorScalarsValid = false;
 
     // Filters
     // ... Should be ok
 
     // KNN
+    stopKnnGraphBuild();
     _computeOnLoad = false;
     _graphAvailable = false;
     _knnIndex = knn::Index();
@@ -393,8 +463,15 @@ void SpaceWalkerPlugin::resetState()
     _maskedSourceKnnGraph = KnnGraph();
     _maskedKnn = false;
 
+    // Ranking atlas, the build was stopped with the hover jobs
+    _rankingAtlas = RankingAtlas();
+    _rankingAtlasInputsHash = 0;
+    _loadedRankingAtlas = RankingAtlas();
+    _loadedRankingAtlasInputsHash = 0;
+
     // Floodfill
     _floodFill = FloodFill(10);
+    _hoverState = HoverState();
 
     // Graph
     _graphView->reset();
@@ -471,97 +548,304 @@ void SpaceWalkerPlugin::computeStaticData()
         qWarning() << "!!! Shown dimension names may not be correct.";
     }
 
-    Timer timer;
-    timer.start();
+    // The data is replaced in place, so running preparations, kNN builds and selections have to stop reading it first
+    stopDataPreparation();
+    stopKnnGraphBuild();
+    invalidateHoverInputs();
+
+    // Everything is derived from the dataset, a new dataset starts out with the full data view
+    _dataViewIndices.clear();
+    _dataDimensions.clear();
+    _derivedData.invalidate(_sourceDataNode);
+    _derivedData.invalidate(_sourceProjectionNode);
+    _derivedData.invalidate(_dimensionNamesNode);
+    _derivedData.invalidate(_dataViewSelectionNode);
+    _derivedData.invalidate(_knnGraphNode);
+
+    updateDerivedData();
+}
+
+void SpaceWalkerPlugin::initDerivedData()
+{
+    // Inputs set from the GUI, invalidated when they change
+    _dataViewSelectionNode = _derivedData.addNode("Data view selection", {}, []() {});
+    _maskNode = _derivedData.addNode("Mask", {}, []() {});
 
+    _sourceDataNode = _derivedData.addNode("Data conversion", {}, [this]()
     {
-        logger() << "Converting data to internal format...";
+        std::vector<int> enabledDimensions = getEnabledDimensions(_positionSourceDataset);
+
+        // Standardization replaces the data in place, so the cache key is taken before it
+        _incrementalConversion = !_dataDimensions.empty();
+        if (_incrementalConversion)
+        {
+            _dimensionChange = DimensionChange(_dataDimensions, enabledDimensions);
+            convertDimensionsToEigenMatrix(_positionDataset, _positionSourceDataset, _dimensionChange.addedDimensions, _addedColumns);
+
+            std::vector<std::uint64_t> addedHashes = DerivedDataCache::hashColumns(_addedColumns);
+            applyDimensionChange(_dimensionChange, _columnHashes, addedHashes);
+        }
+        else
+        {
+            convertDimensionsToEigenMatrix(_positionDataset, _positionSourceDataset, enabledDimensions, _dataStore.getBaseData());
+            _columnHashes = DerivedDataCache::hashColumns(_dataStore.getBaseData());
+        }
 
-        convertToEigenMatrix(_positionDataset, _positionSourceDataset, _dataStore.getBaseData());
+        _dataDimensions = enabledDimensions;
+        _sourceDataHash = DerivedDataCache::combineColumnHashes(_dataStore.getBaseData().rows(), _columnHashes);
+    }, true);
+    _sourceProjectionNode = _derivedData.addNode("Projection conversion", {}, [this]()
+    {
         convertToEigenMatrixProjection(_positionDataset, _dataStore.getBaseFullProjection());
-    }
-    timer.mark("Data preparation");
+    }, true);
+    _dimensionNamesNode = _derivedData.addNode("Enabled dimension names", {}, [this]()
+    {
+        const auto& dimNames = _positionSourceDataset->getDimensionNames();
+        auto enabledDimensions = _positionSourceDataset->getDimensionsPickerAction().getEnabledDimensions();
 
+        _enabledDimNames.clear();
+        for (int i = 0; i < enabledDimensions.size(); i++)
+        {
+            if (enabledDimensions[i])
+                _enabledDimNames.push_back(dimNames[i]);
+        }
+    }, true);
+    _standardizedDataNode = _derivedData.addNode("Standardization", { _sourceDataNode }, [this]()
     {
-        logger() << "Standardizing data...";
-        standardizeData(_dataStore.getBaseData(), _dataStore.getVariances());
-    }
+        // An unchanged dataset loads the standardized and normalized data of an earlier session
+        _preprocessedFromCache = _derivedDataCache.readPreprocessed(_sourceDataHash, _dataStore.getBaseData(), _dataStore.getVariances(), _normalizedData);
+        if (_preprocessedFromCache)
+            return;
+
+        if (_incrementalConversion)
+        {
+            // Columns are standardized on their own, so the kept columns stay as they are
+            std::vector<float> addedVariances;
+            standardizeData(_addedColumns, addedVariances);
 
+            applyDimensionChange(_dimensionChange, _dataStore.getBaseData(), _addedColumns);
+            applyDimensionChange(_dimensionChange, _dataStore.getVariances(), addedVariances);
+        }
+        else
+            standardizeData(_dataStore.getBaseData(), _dataStore.getVariances());
+    });
+    _normalizedDataNode = _derivedData.addNode("Normalization", { _standardizedDataNode }, [this]()
     {
-        logger() << "Normalizing data...";
-        normalizeData(_dataStore.getBaseData(), _normalizedData);
-    }
+        if (!_preprocessedFromCache)
+        {
+            if (_incrementalConversion)
+            {
+                std::vector<std::vector<float>> addedNormalizedData;
+                normalizeData(_addedColumns, addedNormalizedData);
 
-    _dataStore.createDataView();
-    // Update projection matrix and views
-    updateProjectionData();
+                applyDimensionChange(_dimensionChange, _normalizedData, addedNormalizedData);
+            }
+            else
+                normalizeData(_dataStore.getBaseData(), _normalizedData);
 
-    timer.mark("Data transformations");
+            _derivedDataCache.writePreprocessed(_sourceDataHash, _dataStore.getBaseData(), _dataStore.getVariances(), _normalizedData);
+        }
+        _addedColumns = DataMatrix();
 
-    if (_computeOnLoad)
+        // Data was replaced in place, so cached flood sums are no longer valid
+        _hdFloodPeakFilter.invalidateWaveSums();
+        _hoverState.pipeline.invalidateData();
+    });
+    _pointViewNode = _derivedData.addNode("Point view", { _sourceProjectionNode, _dataViewSelectionNode }, [this]()
     {
-        logger() << "Computing KNN graph";
-        createKnnIndex();
-        timer.mark("Computing KNN index");
-        computeKnnGraph();
-        timer.mark("Computing KNN graph");
-        _largeKnnGraph.writeToFile();
-    }
+        if (_dataViewIndices.empty())
+            _dataStore.createPointView();
+        else
+            _dataStore.createPointView(_dataViewIndices);
+    });
+    _projectionViewNode = _derivedData.addNode("Projection view", { _pointViewNode }, [this]()
+    {
+        updateProjectionData();
+    }, true);
+    _dataViewNode = _derivedData.addNode("Data view", { _standardizedDataNode, _dataViewSelectionNode }, [this]()
+    {
+        if (_dataViewIndices.empty())
+            _dataStore.createDataView();
+        else
+            _dataStore.createDataView(_dataViewIndices);
+    });
+    _graphBinsNode = _derivedData.addNode("Graph bins", { _dataViewNode }, [this]()
+    {
+        _bins.assign(_dataStore.getNumDimensions(), std::vector<int>(_numGraphBins));
+    });
+    _knnGraphNode = _derivedData.addNode("kNN graph", { _standardizedDataNode }, [this]()
+    {
+        // Builds in the background, see startKnnGraphBuild(), graphs of the previous dimensions are refined instead
+        if (_incrementalConversion && _graphAvailable)
+            startKnnGraphBuild(true);
+        else if (_computeOnLoad)
+            computeKnnGraph();
+    }, true);
+    _maskedDataNode = _derivedData.addNode("Masked data", { _maskNode, _projectionViewNode, _dataViewNode }, [this]()
+    {
+        if (_mask.empty())
+        {
+            _maskedDataMatrix = DataMatrix();
+            _maskedProjMatrix = DataMatrix();
+            return;
+        }
 
+        _maskedDataMatrix = _dataStore.getDataView()(_mask, Eigen::all);
+        _maskedProjMatrix = _dataStore.getProjectionView()(_mask, Eigen::all);
+    });
+    _maskedKnnGraphNode = _derivedData.addNode("Masked kNN graph", { _maskedDataNode }, [this]()
     {
-        //compute::computePCAData(_dataStore.getData());
+        if (!_maskedKnn || _mask.empty())
+            return;
 
-        //_localSpatialDimensionality.clear();
-        //_localHighDimensionality.clear();
+        if (_maskedDataMatrix.rows() < 5000)
+            _maskedKnnIndex.create(_maskedDataMatrix.cols(), knn::Metric::MANHATTAN);
+        else
+            _maskedKnnIndex.create(_maskedDataMatrix.cols(), knn::Metric::EUCLIDEAN);
+        _maskedKnnIndex.addData(_maskedDataMatrix);
+
+        _largeKnnGraph.build(_maskedDataMatrix, _maskedKnnIndex, 30);
+
+        if (_maskedDataMatrix.rows() < 5000)
+        {
+            _maskedSourceKnnGraph.build(_maskedDataMatrix, _maskedKnnIndex, 100);
+            _maskedKnnGraph.build(_maskedSourceKnnGraph, 10, true);
+        }
+        else
+            _maskedKnnGraph.build(_maskedDataMatrix, _maskedKnnIndex, 10);
+    });
+}
+
+namespace
+{
+    /** Compute times are instrumentation, only printed while tracing is enabled */
+    void printComputeTimes(const DependencyGraph& graph)
+    {
+        if (!tracing::isEnabled())
+            return;
+
+        for (const DependencyGraph::ComputeTime& computeTime : graph.getLastComputeTimes())
+            std::cout << "Computed " << computeTime.name << " in " << computeTime.milliseconds << " ms" << std::endl;
+    }
+}
+
+void SpaceWalkerPlugin::updateDerivedData()
+{
+    if (!_positionDataset.isValid() || !_positionSourceDataset.isValid())
+        return;
 
-        //timer.mark("Local dimensionality");
+    // A running preparation owns the graph until it has stopped, it continues from where it was below
+    stopDataPreparation();
 
-        //compute::computeHDLocalDimensionality(_dataStore.getData(), _largeKnnGraph, _localHighDimensionality);
-        //getScatterplotWidget().setColorMap(_colorMapAction.getColorMapImage());
-        //getScatterplotWidget().setColorMapRange(0, 1);
-        //getScatterplotWidget().setScalars(_localHighDimensionality);
+    // Datasets and the dimension picker belong to the GUI thread, so the conversions from them run here. The positions
+    // only need the projection, so they are shown before the data is standardized in the background
+    _derivedData.update({ _projectionViewNode, _dimensionNamesNode, _sourceDataNode });
+    printComputeTimes(_derivedData);
 
-        //Dataset<Points> localDims = _core->addDataset("Points", "Dimensionality");
+    if (_derivedData.isDirty(_normalizedDataNode) || _derivedData.isDirty(_graphBinsNode) || _derivedData.isDirty(_dataViewNode))
+        startDataPreparation();
+    else
+        onDataPrepared();
+}
 
-        //localDims->setData(_localHighDimensionality.data(), _localHighDimensionality.size(), 1);
+void SpaceWalkerPlugin::startDataPreparation()
+{
+    // Selections are computed from the data that is about to change
+    invalidateHoverInputs();
+    _dataPrepared = false;
 
-        //_core->notifyDatasetAdded(localDims);
+    // The bins are resized by the preparation, a pending graph update would read them while it runs
+    _graphTimer->stop();
 
-        //computeDirection(_dataMatrix, _projMatrix, _knnGraph, _directions);
-        //getScatterplotWidget().setDirections(_directions);
-        timer.mark("Directions");
-    }
+    _dataPreparationProgress.reset();
 
-    // Get enabled dimension names
-    const auto& dimNames = _positionSourceDataset->getDimensionNames();
-    auto enabledDimensions = _positionSourceDataset->getDimensionsPickerAction().getEnabledDimensions();
+    DependencyGraph* graph = &_derivedData;
+    ComputeProgress* progress = &_dataPreparationProgress;
+    std::vector<DependencyGraph::NodeId> targets = { _normalizedDataNode, _graphBinsNode, _dataViewNode };
 
-    _enabledDimNames.clear();
-    for (int i = 0; i < enabledDimensions.size(); i++)
+    QThread* thread = QThread::create([graph, progress, targets]()
     {
-        if (enabledDimensions[i])
-            _enabledDimNames.push_back(dimNames[i]);
-    }
+        graph->update(targets, progress);
+    });
+
+    connect(thread, &QThread::finished, this, [this, thread]()
+    {
+        thread->deleteLater();
+
+        // Stopped because the inputs changed, the restarted preparation finishes instead
+        if (thread != _dataPreparationThread)
+            return;
+
+        _dataPreparationThread = nullptr;
+        _dataPreparationTimer->stop();
+        _settingsAction.getOverlayAction().setDataPreparationRunning(false);
+
+        printComputeTimes(_derivedData);
+
+        onDataPrepared();
+    });
+
+    _dataPreparationThread = thread;
+    _settingsAction.getOverlayAction().setDataPreparationRunning(true);
+    _dataPreparationTimer->start();
+
+    thread->start();
+}
+
+void SpaceWalkerPlugin::onDataPrepared()
+{
+    _dataPrepared = true;
+
+    // kNN graphs build in the background themselves, masked graphs are small enough to build here
+    _derivedData.update({ _knnGraphNode, _maskedKnnGraphNode });
+    printComputeTimes(_derivedData);
 
     std::cout << "Number of enabled dimensions in the dataset : " << _dataStore.getNumDimensions() << std::endl;
-    _bins.resize(_dataStore.getNumDimensions(), std::vector<int>(30));
 
-    timer.finish("Graph init");
+    if (_selectedViewIndex != 0)
+        updateViewScalars();
+
+    onPointSelection();
+}
+
+void SpaceWalkerPlugin::stopDataPreparation()
+{
+    if (_dataPreparationThread == nullptr)
+        return;
+
+    // The preparation stops before the next artifact, the ones it didn't compute stay dirty
+    _dataPreparationProgress.cancel();
+    _dataPreparationThread->wait();
+
+    // The queued finished handler still deletes the thread
+    _dataPreparationThread = nullptr;
+    _dataPreparationTimer->stop();
+    _settingsAction.getOverlayAction().setDataPreparationRunning(false);
+}
+
+void SpaceWalkerPlugin::onProjectionDimensionsChanged()
+{
+    stopDataPreparation();
+    _derivedData.invalidate(_projectionViewNode);
+    updateDerivedData();
 }
 
 // Is called when the x, y dimensions chosen by the user change, as well as once when dropping new data into the view
 void SpaceWalkerPlugin::updateProjectionData()
 {
-    // Check if the scatter plot is initialized, if not, don't do anything
+    // The views get the positions once they are initialized
     if (!_scatterPlotWidget->isInitialized())
     {
-        qCritical() << "Tried to update projection data while view widgets are uninitialized";
-        exit(1);
+        _projectionDataPending = true;
+        return;
     }
+    _projectionDataPending = false;
+
+    invalidateHoverData();
 
     // Subset the new projection matrix from the one with all the dimensions
     {
-        logger() << "Adjusting projection matrix...";
+        TRACE_SCOPE("Projection view subset");
 
         int xDim = _settingsAction.getPositionAction().getDimensionX();
         int yDim = _settingsAction.getPositionAction().getDimensionY();
@@ -571,7 +855,7 @@ void SpaceWalkerPlugin::updateProjectionData()
     // Convert projection data to 2D vector list
     std::vector<Vector2f> positions(_dataStore.getProjectionView().rows());
     {
-        logger() << "Convert projection data to 2D vector list...";
+        TRACE_SCOPE("Projection view positions");
         for (int i = 0; i < _dataStore.getProjectionView().rows(); i++)
             positions[i].set(_dataStore.getProjectionView()(i, 0), _dataStore.getProjectionView()(i, 1));
     }
@@ -588,8 +872,69 @@ void SpaceWalkerPlugin::updateProjectionData()
     std::cout << "Projection size: " << _dataStore.getProjectionSize() << std::endl;
 }
 
+void SpaceWalkerPlugin::applyColorScalars(HoverResult& result)
+{
+    const std::vector<int>& pointViewIndices = _dataStore.getPointViewIndices();
+    int numPoints = _positionDataset->getNumPoints();
+
+    // A changed background value or replaced view scalars touch every point, otherwise only
+    // the previously and newly colored points are updated
+    if (!_viewColorScalarsValid || _colorScalars.size() != numPoints || result.colors.background != _colorBackground)
+    {
+        _colorScalars.assign(numPoints, result.colors.background);
+        for (int i = 0; i < result.colors.indices.size(); i++)
+            _colorScalars[result.colors.indices[i]] = result.colors.scalars[i];
+        _floodScalarPublisher.setScalars(_colorScalars);
+
+        const std::vector<int>& viewIndices = _dataStore.getViewIndices();
+        if (viewIndices.size() > 0)
+        {
+            _viewScalars.resize(viewIndices.size());
+            for (int i = 0; i < viewIndices.size(); i++)
+                _viewScalars[i] = _colorScalars[viewIndices[i]];
+            getScatterplotWidget().setScalars(_viewScalars);
+        }
+        else
+            getScatterplotWidget().setScalars(_colorScalars);
+
+        _viewColorScalarsValid = true;
+    }
+    else
+    {
+        _changedViewIndices.clear();
+        _changedViewScalars.clear();
+
+        auto setScalar = [&](int index, float scalar)
+        {
+            _colorScalars[index] = scalar;
+            _floodScalarPublisher.setScalar(index, scalar);
+
+            int viewIndex = pointViewIndices.empty() ? index : pointViewIndices[index];
+            if (viewIndex < 0) return;
+            _changedViewIndices.push_back(viewIndex);
+            _changedViewScalars.push_back(scalar);
+        };
+
+        // Reset the previous flood, then color the new one, later updates win
+        for (const int& index : _coloredIndices)
+            setScalar(index, result.colors.background);
+        for (int i = 0; i < result.colors.indices.size(); i++)
+            setScalar(result.colors.indices[i], result.colors.scalars[i]);
+
+        getScatterplotWidget().updateScalars(_changedViewIndices, _changedViewScalars);
+    }
+
+    std::swap(_coloredIndices, result.colors.indices);
+    _colorBackground = result.colors.background;
+}
+
 void SpaceWalkerPlugin::updateViewData(std::vector<Vector2f>& positions)
 {
+    // The widgets get new points, their scalars have to be set in full again
+    _viewColorScalarsValid = false;
+
+    _pointGrid.build(_dataStore.getProjectionView());
+
     // TODO: Can save some time here only computing data bounds once
     // Pass the 2D points to the scatter plot widget
     _scatterPlotWidget->setData(&positions);
@@ -626,7 +971,8 @@ void SpaceWalkerPlugin::onDataEvent(hdps::DatasetEvent* dataEvent)
 {
     if (dataEvent->getType() == EventType::DatasetDataSelectionChanged)
     {
-        if (dataEvent->getDataset() == _positionDataset)
+        // Selections made by dragging in this view already went through the hover pipeline
+        if (dataEvent->getDataset() == _positionDataset && !_notifyingOwnSelection)
         {
             if (_positionDataset->isDerivedData())
             {
@@ -634,6 +980,36 @@ void SpaceWalkerPlugin::onDataEvent(hdps::DatasetEvent* dataEvent)
             }
         }
     }
+
+    if (dataEvent->getType() == EventType::DatasetDataDimensionsChanged)
+    {
+        if (_positionSourceDataset.isValid() && dataEvent->getDataset() == _positionSourceDataset)
+            onEnabledDimensionsChanged();
+    }
+}
+
+void SpaceWalkerPlugin::onEnabledDimensionsChanged()
+{
+    if (!_dataInitialized || getEnabledDimensions(_positionSourceDataset) == _dataDimensions)
+        return;
+
+    // The data is updated in place, so running preparations, kNN builds and selections have to stop reading it first
+    stopDataPreparation();
+    stopKnnGraphBuild();
+    invalidateHoverInputs();
+
+    // A previous change that was stopped halfway left the columns out of step, so those start over from the dataset
+    if (!_derivedData.isDirty(_sourceDataNode) && _derivedData.isDirty(_normalizedDataNode))
+        _dataDimensions.clear();
+
+    // Dimension indices refer to the old columns, and the index searched the old dimensions
+    _selectedDimension = -1;
+    _selectedViewIndex = 0;
+    _knnIndex = knn::Index();
+
+    _derivedData.invalidate(_sourceDataNode);
+    _derivedData.invalidate(_dimensionNamesNode);
+    updateDerivedData();
 }
 
 std::uint32_t SpaceWalkerPlugin::getNumberOfPoints() const
@@ -660,196 +1036,409 @@ void SpaceWalkerPlugin::createSubset(const bool& fromSourceData /*= false*/, con
 
 void SpaceWalkerPlugin::onPointSelection()
 {
-    Timer timer;
-
-    if (!_positionDataset.isValid() || !_positionSourceDataset.isValid() || !_dataInitialized)
+    if (!_positionDataset.isValid() || !_positionSourceDataset.isValid() || !_dataPrepared)
         return;
 
     hdps::Dataset<Points> selection = _positionSourceDataset->getSelection();
 
     if (selection->indices.size() > 0)
+        submitHoverJob();
+}
+
+void SpaceWalkerPlugin::submitHoverJob()
+{
+    if (!_positionDataset.isValid() || !_dataPrepared)
+        return;
+
+    TRACE_SCOPE("Submit hover job");
+
+    Vector2f center = Vector2f(_dataStore.getProjectionView()(_selectedPoint, 0), _dataStore.getProjectionView()(_selectedPoint, 1));
+    float projectionSize = _dataStore.getProjectionSize();
+
+    // The cursor and filter radii follow the mouse right away, the rest waits for the hover worker
+    getScatterplotWidget().setCurrentPosition(center);
+    getProjectionViews()[0]->setCurrentPosition(center);
+    getProjectionViews()[1]->setCurrentPosition(center);
+    _selectedView->setCurrentPosition(center);
+    getScatterplotWidget().setFilterRadii(Vector2f(_spatialPeakFilter.getInnerFilterRadius() * projectionSize, _spatialPeakFilter.getOuterFilterRadius() * projectionSize));
+
+    const std::vector<int>& viewIndices = _dataStore.getViewIndices();
+
+    HoverJob job;
+    job.selectedPoint = _selectedPoint;
+    job.globalSelectedPoint = _globalSelectedPoint;
+    job.seedPoint = viewIndices.size() > 0 ? viewIndices[_selectedPoint] : _selectedPoint;
+    job.selectedDimension = _selectedDimension;
+    job.filterType = _filterType;
+    job.overlayType = _overlayType;
+    job.restrictToFlood = _settingsAction.getFilterAction().getRestrictToFloodAction().isChecked();
+    job.graphAvailable = _graphAvailable;
+    job.numWaves = _floodFill.getTargetNumWaves();
+    job.numRankedDimensions = _spatialPeakFilter.getRanker().getTopK();
+    job.innerFilterRadius = _spatialPeakFilter.getInnerFilterRadius();
+    job.outerFilterRadius = _spatialPeakFilter.getOuterFilterRadius();
+    job.hdInnerFilterSize = _hdFloodPeakFilter.getInnerFilterSize();
+    job.projectionSize = projectionSize;
+    job.numOutputPoints = _positionDataset->getNumPoints();
+    job.numGraphBins = _numGraphBins;
+    job.inputVersions = _selectionCache.getVersions();
+    job.prefetchCandidates = std::move(_prefetchCandidates);
+    _prefetchCandidates.clear();
+
+    updateRankingAtlas(job);
+
+    if (_hoverRecording != nullptr)
     {
-timer.start();
-        Vector2f center = Vector2f(_dataStore.getProjectionView()(_selectedPoint, 0), _dataStore.getProjectionView()(_selectedPoint, 1));
-
-        KnnGraph& knnGraph = !_maskedKnn ? _knnGraph : _maskedKnnGraph;
-        DataMatrix& dataMatrix = _mask.empty() ? _dataStore.getDataView() : _maskedDataMatrix;
-        DataMatrix& projMatrix = _mask.empty() ? _dataStore.getProjectionView() : _maskedProjMatrix;
-        const std::vector<float>& variances = _dataStore.getVariances();
-
-        float projectionSize = _dataStore.getProjectionSize();
-        int numPoints = _dataStore.getNumPoints();
-        int numDimensions = _dataStore.getNumDimensions();
-
-        getScatterplotWidget().setCurrentPosition(center);
-        getProjectionViews()[0]->setCurrentPosition(center);
-        getProjectionViews()[1]->setCurrentPosition(center);
-        _selectedView->setCurrentPosition(center);
-        getScatterplotWidget().setFilterRadii(Vector2f(_spatialPeakFilter.getInnerFilterRadius() * projectionSize, _spatialPeakFilter.getOuterFilterRadius() * projectionSize));
-
-        //////////////////
-        // Do floodfill //
-        //////////////////
-        const std::vector<int>& viewIndices = _dataStore.getViewIndices();
-        int selectedPoint = viewIndices.size() > 0 ? viewIndices[_selectedPoint] : _selectedPoint;
-        if (_graphAvailable)
-            _floodFill.compute(knnGraph, selectedPoint);
+        HoverEvent event;
+        event.time = (tracing::now() - _hoverRecordingStart) * 1e-6;
+        event.selectedPoint = job.selectedPoint;
+        event.seedPoint = job.seedPoint;
+        event.cursorX = _lastPickPosition.x;
+        event.cursorY = _lastPickPosition.y;
+        event.selectedDimension = job.selectedDimension;
+        event.settings = job;
+        _hoverRecording->events.push_back(event);
+    }
 
-timer.mark("Floodfill");
+    _hoverWorker.submit([this, job](std::uint64_t generation) { runHoverJob(job, generation); });
+}
 
-        /////////////////////
-        // Gradient picker //
-        /////////////////////
-        std::vector<int> dimRanking;
-        switch (_filterType)
-        {
-        case filters::FilterType::SPATIAL_PEAK:
+void SpaceWalkerPlugin::runHoverJob(const HoverJob& job, std::uint64_t generation)
+{
+    // Keep at least this rate of results coming in while the mouse keeps moving
+    constexpr auto MAX_RESULT_INTERVAL = std::chrono::milliseconds(100);
+
+    TRACE_SCOPE("Hover job");
+
+    // The loops of the hover pipeline and the prefetching go ahead of exports and index builds
+    tasks::ScopedPriority priority(tasks::Priority::INTERACTIVE);
+
+    HoverState& state = _hoverState;
+    HoverPipeline& pipeline = state.pipeline;
+    HoverInputs inputs = getHoverInputs();
+
+    const auto shouldDrop = [this, &state, generation, MAX_RESULT_INTERVAL]()
+    {
+        if (_hoverWorker.isCancelled(generation))
+            return true;
+        return _hoverWorker.isSuperseded(generation) && std::chrono::steady_clock::now() - state.lastDelivery < MAX_RESULT_INTERVAL;
+    };
+
+    //////////////////
+    // Do floodfill //
+    //////////////////
+    TRACE_SPAN(floodSpan, "Hover flood fill");
+    FloodKey floodKey = pipeline.updateFlood(job, inputs, job.seedPoint, &_selectionCache);
+
+    floodSpan.end();
+    if (shouldDrop())
+        return;
+
+    /////////////////////
+    // Gradient picker //
+    /////////////////////
+    TRACE_SPAN(rankingSpan, "Hover ranking");
+    pipeline.updateRanking(job, inputs, floodKey, job.selectedPoint, &_selectionCache);
+
+    rankingSpan.end();
+    if (shouldDrop())
+        return;
+
+    TRACE_SPAN(colorSpan, "Hover color scalars");
+
+    std::shared_ptr<HoverResult> result = acquireHoverResult();
+    result->generation = generation;
+    result->globalSelectedPoint = job.globalSelectedPoint;
+    result->selectedDimension = job.selectedDimension;
+
+    const FloodFill& floodFill = pipeline.getFloodFill();
+    const std::vector<int>& dimRanking = pipeline.getDimRanking();
+
+    // Scalars of the gradient views, FIXME use colormap later
+    result->projectionScalars.resize(_projectionViews.size());
+    for (int pi = 0; pi < _projectionViews.size(); pi++)
+        HoverPipeline::copyDimensionValues(*inputs.data, dimRanking[pi], result->projectionScalars[pi]);
+    // Scalars of the selected gradient view
+    if (job.selectedDimension >= 0)
+        HoverPipeline::copyDimensionValues(*inputs.data, job.selectedDimension, result->selectedDimensionScalars);
+
+    /////////////////////
+    // Coloring        //
+    /////////////////////
+    pipeline.computeColors(job, inputs, result->colors);
+
+    if (job.graphAvailable)
+    {
+        switch (job.overlayType)
         {
-            if (_settingsAction.getFilterAction().getRestrictToFloodAction().isChecked())
-                _spatialPeakFilter.computeDimensionRanking(_selectedPoint, dataMatrix, variances, projMatrix, projectionSize, dimRanking, _floodFill.getAllNodes());
-            else
-                _spatialPeakFilter.computeDimensionRanking(_selectedPoint, dataMatrix, variances, projMatrix, projectionSize, dimRanking);
+        case OverlayType::NONE:
+            result->coloredBy = floodFill.getNumWaves() > 0 ? "Colored by - Flood fill step" : "Colored by - None";
             break;
-        }
-        case filters::FilterType::HD_PEAK:
+        case OverlayType::DIM_VALUES:
+            result->coloredBy = "Colored by - Dim: " + _enabledDimNames[dimRanking[0]];
+            break;
+        case OverlayType::LOCAL_DIMENSIONALITY:
+            result->coloredBy = "Colored by - Local Dimensionality";
+            break;
+        case OverlayType::DIRECTIONS:
         {
-            _hdFloodPeakFilter.computeDimensionRanking(_selectedPoint, _dataStore.getBaseData(), variances, _floodFill, dimRanking);
+            result->hasDirections = true;
+            result->directions.resize(floodFill.getTotalNumNodes() * 2);
+
+            for (int i = 0; i < floodFill.getTotalNumNodes(); i++)
+            {
+                int idx = floodFill.getAllNodes()[i];
+                result->directions[i * 2 + 0] = _directions[idx * 2 + 0];
+                result->directions[i * 2 + 1] = _directions[idx * 2 + 1];
+            }
+
             break;
         }
         }
-timer.mark("Ranking");
+    }
 
-        // Set appropriate coloring of gradient view, FIXME use colormap later
-        for (int pi = 0; pi < _projectionViews.size(); pi++)
-        {
-            const auto dimValues = dataMatrix(Eigen::all, dimRanking[pi]);
-            std::vector<float> dimV(dimValues.data(), dimValues.data() + dimValues.size());
-            _projectionViews[pi]->setShownDimension(dimRanking[pi]);
-            _projectionViews[pi]->setScalars(dimV, _globalSelectedPoint);
-            _projectionViews[pi]->setProjectionName(_enabledDimNames[dimRanking[pi]]);
-        }
-        // Set selected gradient view
-        if (_selectedDimension >= 0)
+    colorSpan.end();
+
+    /////////////////////
+    // Graphs          //
+    /////////////////////
+    TRACE_SPAN(histogramSpan, "Hover histograms");
+    pipeline.updateHistograms(job, inputs, floodKey, &_selectionCache, result->bins);
+
+    result->floodFill = floodFill;
+    result->dimRanking = dimRanking;
+
+    histogramSpan.end();
+    if (_hoverWorker.isCancelled(generation))
+    {
+        releaseHoverResult(std::move(result));
+        return;
+    }
+
+    state.lastDelivery = std::chrono::steady_clock::now();
+    QMetaObject::invokeMethod(this, [this, result]()
+    {
+        applyHoverResult(*result);
+        releaseHoverResult(result);
+    }, Qt::QueuedConnection);
+
+    // The worker is idle until the next selection comes in, use the time to compute the selections the cursor is heading for
+    if (job.graphAvailable)
+        prefetchSelections(job, generation);
+}
+
+std::shared_ptr<SpaceWalkerPlugin::HoverResult> SpaceWalkerPlugin::acquireHoverResult()
+{
+    {
+        std::lock_guard<std::mutex> lock(_hoverResultPoolMutex);
+        if (!_hoverResultPool.empty())
         {
-            qDebug() << "SEL DIM:" << _selectedDimension;
-            const auto dimValues = dataMatrix(Eigen::all, _selectedDimension);
-            std::vector<float> dimV(dimValues.data(), dimValues.data() + dimValues.size());
-            _selectedView->setShownDimension(_selectedDimension);
-            _selectedView->setScalars(dimV, _globalSelectedPoint);
-            _selectedView->setProjectionName(_enabledDimNames[_selectedDimension]);
+            std::shared_ptr<HoverResult> result = std::move(_hoverResultPool.back());
+            _hoverResultPool.pop_back();
+
+            // Buffers are overwritten by the stages, only the optional fields have to be reset
+            result->coloredBy.clear();
+            result->hasDirections = false;
+            result->directions.clear();
+            return result;
         }
+    }
+    return std::make_shared<HoverResult>();
+}
 
-        _graphView->setTopDimensions(dimRanking[0], dimRanking[1]);
+void SpaceWalkerPlugin::releaseHoverResult(std::shared_ptr<HoverResult> result)
+{
+    // A couple of results are in flight at most, more only happens when the GUI thread falls behind
+    constexpr size_t MAX_POOLED_RESULTS = 4;
 
-timer.mark("Filter");
+    std::lock_guard<std::mutex> lock(_hoverResultPoolMutex);
+    if (_hoverResultPool.size() < MAX_POOLED_RESULTS)
+        _hoverResultPool.push_back(std::move(result));
+}
 
-        /////////////////////
-        // Coloring        //
-        /////////////////////
-        _colorScalars.clear();
-        _colorScalars.resize(_positionDataset->getNumPoints(), 0);
+HoverInputs SpaceWalkerPlugin::getHoverInputs()
+{
+    DataStorage& dataStore = _dataStore;
+
+    HoverInputs inputs;
+    inputs.data = _mask.empty() ? &dataStore.getDataView() : &_maskedDataMatrix;
+    inputs.projection = _mask.empty() ? &dataStore.getProjectionView() : &_maskedProjMatrix;
+    inputs.baseData = &dataStore.getBaseData();
+    inputs.normalizedData = &_normalizedData;
+    inputs.variances = &dataStore.getVariances();
+    inputs.knnGraph = !_maskedKnn ? &_knnGraph : &_maskedKnnGraph;
+    inputs.mask = &_mask;
+    inputs.localHighDimensionality = &_localHighDimensionality;
+    inputs.rankingAtlas = &_rankingAtlas;
+    return inputs;
+}
 
-        if (_graphAvailable)
-        {
-            switch (_overlayType)
-            {
-            case OverlayType::NONE:
-            {
-                if (_floodFill.getNumWaves() > 0)
-                {
-                    _scatterPlotWidget->setColoredBy("Colored by - Flood fill step");
-                    for (int i = 0; i < _floodFill.getNumWaves(); i++)
-                    {
-                        for (int j = 0; j < _floodFill.getWaves()[i].size(); j++)
-                        {
-                            int index = _floodFill.getWaves()[i][j];
-                            _colorScalars[_mask.empty() ? index : _mask[index]] = 1 - (1.0f / _floodFill.getNumWaves()) * i;
-                        }
-                    }
-                }
-                else
-                    _scatterPlotWidget->setColoredBy("Colored by - None");
+void SpaceWalkerPlugin::prefetchSelections(const HoverJob& job, std::uint64_t generation)
+{
+    HoverState& state = _hoverState;
+    HoverInputs inputs = getHoverInputs();
 
-                break;
-            }
-            case OverlayType::DIM_VALUES:
-            {
-                _scatterPlotWidget->setColoredBy("Colored by - Dim: " + _enabledDimNames[dimRanking[0]]);
-                for (int i = 0; i < _floodFill.getTotalNumNodes(); i++)
-                {
-                    int node = _floodFill.getAllNodes()[i];
-                    int index = _mask.empty() ? node : _mask[node];
-                    _colorScalars[index] = _normalizedData[dimRanking[0]][index];
-                }
-                // TEMP
-                //const auto dimValues = _dataStore.getFullData()(Eigen::all, dimRanking[0]);
-                //std::vector<float> dimV(dimValues.data(), dimValues.data() + dimValues.size());
-                //_colorScalars.assign(dimV.begin(), dimV.end());
-                break;
-            }
-            case OverlayType::LOCAL_DIMENSIONALITY:
-            {
-                _scatterPlotWidget->setColoredBy("Colored by - Local Dimensionality");
-                if (_localHighDimensionality.empty()) break;
+    for (const SelectionCandidate& candidate : job.prefetchCandidates)
+    {
+        // Real selections always go first
+        if (_hoverWorker.isSuperseded(generation))
+            return;
 
-                for (int i = 0; i < _floodFill.getTotalNumNodes(); i++)
-                {
-                    int node = _floodFill.getAllNodes()[i];
-                    int index = _mask.empty() ? node : _mask[node];
-                    _colorScalars[index] = _localHighDimensionality[node];
-                }
-                break;
-            }
-            case OverlayType::DIRECTIONS:
-            {
-                std::vector<float> scalars(dataMatrix.rows(), 0);
-                std::vector<Vector2f> directions(_floodFill.getTotalNumNodes() * 2);
+        FloodKey floodKey = HoverPipeline::makeFloodKey(job, candidate.seedPoint);
+        RankingKey rankingKey = HoverPipeline::makeRankingKey(job, floodKey, candidate.selectedPoint);
+        if (_selectionCache.containsFlood(floodKey) && _selectionCache.containsRanking(rankingKey))
+            continue;
 
-                for (int i = 0; i < _floodFill.getTotalNumNodes(); i++)
-                {
-                    float idx = _floodFill.getAllNodes()[i];
-                    directions[i * 2 + 0] = _directions[idx * 2 + 0];
-                    directions[i * 2 + 1] = _directions[idx * 2 + 1];
-                    scalars[idx] = 0.5f;
-                }
-                getScatterplotWidget().setDirections(directions);
+        TRACE_SCOPE("Prefetch selection");
 
-                break;
-            }
-            }
-        }
+        state.pipeline.computeFlood(job, inputs, candidate.seedPoint, state.prefetchFloodFill, state.prefetchWorkingSet);
+        state.pipeline.computeRanking(job, inputs, candidate.selectedPoint, state.prefetchFloodFill, state.prefetchWorkingSet, state.prefetchRanking);
 
-        // Set color scalars in the main view, if we are looking at a data view, subset the scalars first
-        if (viewIndices.size() > 0)
-        {
-            std::vector<float> viewScalars(numPoints);
-#pragma omp parallel for
-            for (int i = 0; i < numPoints; i++)
-            {
-                viewScalars[i] = _colorScalars[viewIndices[i]];
-            }
-            getScatterplotWidget().setScalars(viewScalars);
-        }
-        else
-            getScatterplotWidget().setScalars(_colorScalars);
+        if (_hoverWorker.isSuperseded(generation))
+            return;
+
+        if (!_selectionCache.containsFlood(floodKey))
+            _selectionCache.insertFlood(floodKey, state.prefetchFloodFill, true);
+        _selectionCache.insertRanking(rankingKey, state.prefetchRanking);
+    }
+}
+
+void SpaceWalkerPlugin::reportPrefetchStats()
+{
+    SelectionCache::Stats stats = _selectionCache.getStats();
+    if (stats.lookups == 0)
+        return;
 
-        timer.mark("Compute color scalars");
+    std::cout << "Selection cache: " << stats.hits << "/" << stats.lookups << " stage hits (" << (100 * stats.hits / stats.lookups) << "%), "
+        << stats.prefetchHits << "/" << stats.prefetched << " prefetched selections used, " << stats.prefetchWasted << " wasted" << std::endl;
 
-        // Store scalars in floodfill dataset
-        normalizeVector(_colorScalars);
-        updateFloodScalarOutput(_colorScalars);
+    _selectionCache.resetStats();
+}
+
+void SpaceWalkerPlugin::applyHoverResult(HoverResult& result)
+{
+    // Computed from data that has changed since, or overtaken by a newer result
+    if (_hoverWorker.isCancelled(result.generation) || result.generation < _lastAppliedHoverGeneration)
+        return;
+
+    _lastAppliedHoverGeneration = result.generation;
+
+    TRACE_SCOPE("Apply hover result");
+
+    std::swap(_floodFill, result.floodFill);
+    std::swap(_dimRanking, result.dimRanking);
+    if (!result.bins.empty())
+        std::swap(_bins, result.bins);
+
+    for (int pi = 0; pi < _projectionViews.size(); pi++)
+    {
+        _projectionViews[pi]->setShownDimension(_dimRanking[pi]);
+        _projectionViews[pi]->setScalars(result.projectionScalars[pi], result.globalSelectedPoint);
+        _projectionViews[pi]->setProjectionName(_enabledDimNames[_dimRanking[pi]]);
+    }
+    if (result.selectedDimension >= 0)
+    {
+        _selectedView->setShownDimension(result.selectedDimension);
+        _selectedView->setScalars(result.selectedDimensionScalars, result.globalSelectedPoint);
+        _selectedView->setProjectionName(_enabledDimNames[result.selectedDimension]);
+    }
+
+    _graphView->setTopDimensions(_dimRanking[0], _dimRanking[1]);
+
+    if (!result.coloredBy.isEmpty())
+        _scatterPlotWidget->setColoredBy(result.coloredBy);
+    if (result.hasDirections)
+        getScatterplotWidget().setDirections(result.directions);
+
+    applyColorScalars(result);
+
+    // Coalesced with other selections, linked views don't need to keep up with the mouse
+    _floodScalarPublisher.publish();
+
+    /////////////////////
+    // Graphs          //
+    /////////////////////
+
+    // Start a timer to show the graphs in 100ms, if the timer is restarted before graphs are not updated
+    _graphTimer->start(100);
+}
+
+void SpaceWalkerPlugin::cancelHoverJobs()
+{
+    _hoverWorker.cancelAndWait();
+    stopRankingAtlasBuild();
+
+    // The recorded inputs are about to change
+    if (_hoverRecording != nullptr)
+        stopHoverRecording();
+}
+
+void SpaceWalkerPlugin::invalidateHoverData()
+{
+    cancelHoverJobs();
+    _selectionCache.invalidateData();
+}
 
-        timer.mark("Publish color scalars");
+void SpaceWalkerPlugin::invalidateHoverGraph()
+{
+    cancelHoverJobs();
+    _selectionCache.invalidateGraph();
+}
+
+void SpaceWalkerPlugin::invalidateHoverMask()
+{
+    cancelHoverJobs();
+    _selectionCache.invalidateMask();
+}
+
+void SpaceWalkerPlugin::invalidateHoverInputs()
+{
+    cancelHoverJobs();
+    _selectionCache.invalidateAll();
+}
+
+void SpaceWalkerPlugin::setNumRankedDimensions(int topK)
+{
+    // Never rank fewer dimensions than are shown in the projection views
+    topK = std::max(topK, (int) _projectionViews.size());
+
+    _spatialPeakFilter.setTopK(topK);
+    _hdFloodPeakFilter.setTopK(topK);
+}
+
+void SpaceWalkerPlugin::setRankingAtlasEnabled(bool enabled)
+{
+    _rankingAtlasEnabled = enabled;
+
+    if (enabled)
+    {
+        // The build starts with the next hover job
+        onPointSelection();
+        return;
+    }
 
-        /////////////////////
-        // Graphs          //
-        /////////////////////
+    stopRankingAtlasBuild();
+    _hoverWorker.cancelAndWait();
+    _rankingAtlas = RankingAtlas();
+}
 
-        // Start a timer to compute the graphs in 100ms, if the timer is restarted before graphs are not computed
-        _graphTimer->start(100);
+void SpaceWalkerPlugin::setNumGraphBins(int numBins)
+{
+    _numGraphBins = numBins;
 
-        timer.finish("Graphs");
+    // A running preparation may have sized the bins already, so they are sized again once it continues
+    if (_dataPreparationThread != nullptr)
+    {
+        stopDataPreparation();
+        _derivedData.invalidate(_graphBinsNode);
+        updateDerivedData();
+        return;
     }
+
+    for (std::vector<int>& bins : _bins)
+        bins.assign(numBins, 0);
+
+    onPointSelection();
 }
 
 void SpaceWalkerPlugin::onSliceIndexChanged()
@@ -899,10 +1488,15 @@ void SpaceWalkerPlugin::updateViewScalars()
     {
         selectedView->selectView(true);
 
+        // The dimension values are shown once the data is prepared
+        if (!_dataPrepared)
+            return;
+
         int selectedDimension = selectedView->getShownDimension();
         const auto dimValues = _dataStore.getDataView()(Eigen::all, selectedDimension);
         std::vector<float> dimV(dimValues.data(), dimValues.data() + dimValues.size());
         getScatterplotWidget().setScalars(dimV);
+        _viewColorScalarsValid = false;
         getScatterplotWidget().setProjectionName("Dimension View: " + _enabledDimNames[selectedDimension]);
         getScatterplotWidget().setColoredBy("");
 
@@ -922,10 +1516,8 @@ void SpaceWalkerPlugin::updateViewScalars()
 
 void SpaceWalkerPlugin::updateFloodScalarOutput(const std::vector<float>& scalars)
 {
-    std::cout << "Flood scalars: " << scalars[1000] << std::endl;
-
-    _floodScalars->setData<float>(scalars.data(), scalars.size(), 1);
-    events().notifyDatasetDataChanged(_floodScalars);
+    _floodScalarPublisher.setScalars(scalars);
+    _floodScalarPublisher.publish();
 }
 
 /******************************************************************************
@@ -934,27 +1526,10 @@ void SpaceWalkerPlugin::updateFloodScalarOutput(const std::vector<float>& scalar
 
 void SpaceWalkerPlugin::computeGraphs()
 {
-    // Binning
-    int numBins = (int)_bins.size();
-    int binSteps = (int)_bins[0].size();
-
-    for (int d = 0; d < numBins; d++)
-        std::fill(_bins[d].begin(), _bins[d].end(), 0);
-
-#pragma omp parallel for
-    for (int d = 0; d < numBins; d++)
-    {
-        int* const bins_d = &_bins[d][0];
-        float* const norm_d = &_normalizedData[d][0];
-
-        for (bigint i = 0; i < _floodFill.getTotalNumNodes(); i++)
-        {
-            const float& f = norm_d[_floodFill.getAllNodes()[i]];
-            bins_d[(bigint)(f * binSteps)]++;
-        }
-    }
-    qDebug() << "Graphs computed";
+    if (!_dataPrepared)
+        return;
 
+    // The bins of the current flood are computed by the hover pipeline
     _graphView->setBins(_bins);
 }
 
@@ -975,13 +1550,98 @@ void SpaceWalkerPlugin::onLineClicked(dint dim)
 
 void SpaceWalkerPlugin::exportDimRankings()
 {
+    if (!_dataPrepared)
+        return;
+
     bool restrictToFloodNodes = _settingsAction.getFilterAction().getRestrictToFloodAction().isChecked();
-    exportRankings(_dataStore, _floodFill, _knnGraph, _filterType, _spatialPeakFilter, _hdFloodPeakFilter, restrictToFloodNodes, _enabledDimNames);
+
+    RankingExportSettings settings;
+    settings.format = _settingsAction.getExportAction().getExportAsCsvAction().isChecked() ? RankingExportFormat::CSV : RankingExportFormat::BINARY;
+    settings.topK = _settingsAction.getExportAction().getExportTopKAction().getValue();
+
+    QProgressDialog progressDialog("Exporting dimension rankings...", "Cancel", 0, _dataStore.getNumPoints(), &getWidget());
+    progressDialog.setWindowModality(Qt::WindowModal);
+    progressDialog.setMinimumDuration(500);
+
+    auto progressCallback = [&progressDialog](int numProcessed, int numTotal)
+    {
+        progressDialog.setValue(numProcessed);
+        return !progressDialog.wasCanceled();
+    };
+
+    std::vector<std::string> names;
+    names.reserve(_enabledDimNames.size());
+    for (const QString& name : _enabledDimNames)
+        names.push_back(name.toStdString());
+
+    exportRankings(_dataStore, _floodFill, _knnGraph, _filterType, _spatialPeakFilter, _hdFloodPeakFilter, restrictToFloodNodes, names, settings, progressCallback);
+}
+
+void SpaceWalkerPlugin::exportTrace()
+{
+    tracing::printStageStatistics();
+    tracing::exportChromeTrace(createTimestampedFileName("trace", ".json"));
+}
+
+void SpaceWalkerPlugin::startHoverRecording()
+{
+    if (!_dataPrepared)
+    {
+        std::cout << "Can't record hover selections before the data is prepared" << std::endl;
+        _settingsAction.getExportAction().getRecordHoverAction().setChecked(false);
+        return;
+    }
+
+    // The worker must not be using the inputs while they are copied
+    _hoverWorker.cancelAndWait();
+
+    auto recording = std::make_unique<HoverRecording>();
+    recording->baseData = _dataStore.getBaseData();
+    recording->variances = _dataStore.getVariances();
+    recording->viewIndices = _dataStore.getViewIndices();
+    recording->projection = _dataStore.getProjectionView();
+    recording->mask = _mask;
+    recording->knnGraph = !_maskedKnn ? _knnGraph : _maskedKnnGraph;
+    recording->localHighDimensionality = _localHighDimensionality;
+    recording->numProjectionViews = (int) _projectionViews.size();
+
+    _hoverRecording = std::move(recording);
+    _hoverRecordingStart = tracing::now();
+
+    std::cout << "Recording hover selections" << std::endl;
+}
+
+void SpaceWalkerPlugin::stopHoverRecording()
+{
+    if (_hoverRecording == nullptr)
+        return;
+
+    std::unique_ptr<HoverRecording> recording = std::move(_hoverRecording);
+    HoverRecordingExporter::write(*recording);
+
+    _settingsAction.getExportAction().getRecordHoverAction().setChecked(false);
 }
 
 void SpaceWalkerPlugin::exportFloodnodes()
 {
-    exportFloodNodes(_dataStore.getNumPoints(), _floodFill, _knnGraph);
+    if (!_dataPrepared)
+        return;
+
+    FloodNodeExportSettings settings;
+    settings.format = _settingsAction.getExportAction().getExportAsCsvAction().isChecked() ? FloodNodeExportFormat::CSV : FloodNodeExportFormat::BINARY;
+    settings.deltaCompressed = _settingsAction.getExportAction().getDeltaCompressAction().isChecked();
+
+    QProgressDialog progressDialog("Exporting flood nodes...", "Cancel", 0, _dataStore.getNumPoints(), &getWidget());
+    progressDialog.setWindowModality(Qt::WindowModal);
+    progressDialog.setMinimumDuration(500);
+
+    auto progressCallback = [&progressDialog](int numProcessed, int numTotal)
+    {
+        progressDialog.setValue(numProcessed);
+        return !progressDialog.wasCanceled();
+    };
+
+    exportFloodNodes(_dataStore.getNumPoints(), _floodFill, _knnGraph, settings, progressCallback);
 }
 
 void SpaceWalkerPlugin::importKnnGraph()
@@ -989,7 +1649,11 @@ void SpaceWalkerPlugin::importKnnGraph()
     QString fileName = QFileDialog::getOpenFileName(&getWidget(),
         tr("Open Knn Graph"), "", tr("KNN Files (*.knn)"));
 
-    _largeKnnGraph.readFromFile(fileName);
+    // The imported graph replaces whatever a running build would produce
+    stopKnnGraphBuild();
+    invalidateHoverGraph();
+
+    _largeKnnGraph.readFromFile(fileName.toStdString());
     _knnGraph.build(_largeKnnGraph, 10);
 
     _graphAvailable = true;
@@ -999,41 +1663,269 @@ void SpaceWalkerPlugin::importKnnGraph()
  * Flooding
  ******************************************************************************/
 
-void SpaceWalkerPlugin::createKnnIndex()
+void SpaceWalkerPlugin::computeKnnGraph()
 {
-    qDebug() << "Creating index";
-    if (_dataStore.getNumDimensions() <= 200)
-        _knnIndex.create(_dataStore.getNumDimensions(), knn::Metric::MANHATTAN);
+    if (!_preloadedKnnGraph)
+    {
+        startKnnGraphBuild();
+        return;
+    }
+
+    invalidateHoverGraph();
+    _knnGraph.build(_largeKnnGraph, 10);
+
+    _graphAvailable = true;
+    qDebug() << "Done building KNN Graph! Ready for flood-fill.";
+}
+
+void SpaceWalkerPlugin::rebuildKnnGraph(int floodNeighbours)
+{
+    if (!_graphAvailable || !_dataPrepared)
+        return;
+
+    invalidateHoverGraph();
+
+    // Without shared distances the large graph holds the nearest neighbours in order, so no search is needed
+    if (_sourceKnnGraph.getNeighbours().empty() && _largeKnnGraph.getNumNeighbours() >= floodNeighbours)
+        _knnGraph.build(_largeKnnGraph, floodNeighbours);
     else
-        _knnIndex.create(_dataStore.getNumDimensions(), knn::Metric::COSINE);
-    qDebug() << "Adding data";
-    _knnIndex.addData(_dataStore.getBaseData());
-    qDebug() << "Done creating index";
+    {
+        // Graphs loaded from the cache or the project come without their index
+        if (!_knnIndex.isCreated())
+            createKnnIndex(_dataStore.getBaseData(), _knnIndex);
+
+        _knnGraph.build(_dataStore.getBaseData(), _knnIndex, floodNeighbours);
+    }
 }
 
-void SpaceWalkerPlugin::computeKnnGraph()
+void SpaceWalkerPlugin::startKnnGraphBuild(bool refine)
 {
-    qDebug() << "Building KNN Graph..";
-    if (!_preloadedKnnGraph)
+    if (_knnBuildThread != nullptr || !_dataPrepared || _dataStore.getBaseData().rows() == 0)
+        return;
+
+    qDebug() << (refine ? "Refining KNN Graph to the changed dimensions.." : "Building KNN Graph in the background..");
+
+    _knnBuildProgress.reset();
+
+    // Build into separate graphs, hovering keeps using the current ones until the build is done
+    auto build = std::make_shared<KnnGraphBuild>();
+    const DataMatrix* data = &_dataStore.getBaseData();
+    bool useSharedDistances = _useSharedDistances;
+    ComputeProgress* progress = &_knnBuildProgress;
+    DerivedDataCache* cache = &_derivedDataCache;
+    std::uint64_t dataHash = _sourceDataHash;
+
+    // Graphs loaded from a project come without their source graph, those are refined without shared distances
+    bool refineShared = useSharedDistances && !_sourceKnnGraph.getNeighbours().empty();
+    std::shared_ptr<KnnGraph> seedGraph;
+    if (refine)
+        seedGraph = std::make_shared<KnnGraph>(refineShared ? _sourceKnnGraph : _largeKnnGraph);
+
+    QThread* thread = QThread::create([data, useSharedDistances, build, progress, cache, dataHash, refineShared, seedGraph]()
     {
-        if (_useSharedDistances)
+        // An unchanged dataset reuses the graphs of an earlier build, the index is only created when a rebuild needs it
+        if (cache->readKnnGraphs(dataHash, useSharedDistances, *build))
+            return;
+
+        // Refined graphs are approximate, so they aren't cached in place of an exact build
+        if (seedGraph)
         {
-            _sourceKnnGraph.build(_dataStore.getBaseData(), _knnIndex, 100);
-            _largeKnnGraph.build(_sourceKnnGraph, 30, true);
-            _knnGraph.build(_sourceKnnGraph, 10, true);
+            refineKnnGraphs(*data, refineShared, *seedGraph, *build, progress);
+            return;
         }
-        else
+
+        if (buildKnnGraphs(*data, useSharedDistances, *build, progress))
+            cache->writeKnnGraphs(dataHash, useSharedDistances, *build);
+    });
+
+    connect(thread, &QThread::finished, this, [this, thread, build]()
+    {
+        thread->deleteLater();
+
+        // Stopped by a reset or new data, the results are stale
+        if (thread != _knnBuildThread)
+            return;
+
+        _knnBuildThread = nullptr;
+        _knnBuildTimer->stop();
+        _settingsAction.getOverlayAction().setKnnGraphBuildRunning(false);
+
+        if (_knnBuildProgress.isCancelled())
         {
-            _largeKnnGraph.build(_dataStore.getBaseData(), _knnIndex, 30);
-            _knnGraph.build(_largeKnnGraph, 10);
+            qDebug() << "KNN graph build cancelled";
+            return;
+        }
+
+        // Swap in the finished graphs once the hover worker has stopped reading the old ones
+        invalidateHoverGraph();
+        _knnIndex = std::move(build->index);
+        _sourceKnnGraph = std::move(build->sourceGraph);
+        _largeKnnGraph = std::move(build->largeGraph);
+        _knnGraph = std::move(build->graph);
+
+        _graphAvailable = true;
+        qDebug() << "Done building KNN Graph! Ready for flood-fill.";
+
+        // Graphs computed on load are kept as a timestamped .knn file, so they can be imported later
+        if (_computeOnLoad)
+            KnnGraphExporter::write(_largeKnnGraph);
+
+        onPointSelection();
+    });
+
+    _knnBuildThread = thread;
+    _settingsAction.getOverlayAction().setKnnGraphBuildRunning(true);
+    _knnBuildTimer->start();
+
+    thread->start(QThread::LowPriority);
+}
+
+void SpaceWalkerPlugin::cancelKnnGraphBuild()
+{
+    if (_knnBuildThread == nullptr)
+        return;
+
+    // The build notices the cancel between search chunks and finishes through the regular path
+    _knnBuildProgress.cancel();
+}
+
+void SpaceWalkerPlugin::stopKnnGraphBuild()
+{
+    if (_knnBuildThread == nullptr)
+        return;
+
+    _knnBuildProgress.cancel();
+    _knnBuildThread->wait();
+
+    // The queued finished handler still deletes the thread
+    _knnBuildThread = nullptr;
+    _knnBuildTimer->stop();
+    _settingsAction.getOverlayAction().setKnnGraphBuildRunning(false);
+}
+
+void SpaceWalkerPlugin::updateRankingAtlas(const HoverSettings& settings)
+{
+    if (!_rankingAtlasEnabled || _rankingAtlas.matches(settings))
+        return;
+
+    HoverInputs inputs = getHoverInputs();
+    if (!RankingAtlas::isSupported(settings, inputs))
+        return;
+
+    // The atlas of the project is checked once, against the first settings it could serve
+    if (!_loadedRankingAtlas.isEmpty())
+    {
+        RankingAtlas loadedAtlas = std::move(_loadedRankingAtlas);
+        _loadedRankingAtlas = RankingAtlas();
+        loadedAtlas.setInputVersions(settings.inputVersions);
+
+        if (loadedAtlas.matches(settings) && loadedAtlas.getNumPoints() == inputs.data->rows() && loadedAtlas.getNumDimensions() == inputs.data->cols() &&
+            hashRankingAtlasInputs(RankingAtlas::needsFlood(settings)) == _loadedRankingAtlasInputsHash)
+        {
+            stopRankingAtlasBuild();
+            _hoverWorker.cancelAndWait();
+            _rankingAtlas = std::move(loadedAtlas);
+            _rankingAtlasInputsHash = _loadedRankingAtlasInputsHash;
+
+            qDebug() << "Using the ranking atlas of the project";
+            return;
         }
     }
-    else
-        _knnGraph.build(_largeKnnGraph, 10);
 
-    _graphAvailable = true;
-    qDebug() << "Done building KNN Graph! Ready for flood-fill.";
-    //_largeKnnGraph.writeToFile();
+    if (_rankingAtlasThread != nullptr)
+    {
+        const HoverSettings& buildSettings = _rankingAtlasBuildSettings;
+        bool sameVersions = buildSettings.inputVersions.data == settings.inputVersions.data && buildSettings.inputVersions.graph == settings.inputVersions.graph &&
+            buildSettings.inputVersions.mask == settings.inputVersions.mask;
+
+        // Still building for these settings
+        if (sameVersions && RankingAtlas::makeSettings(buildSettings) == RankingAtlas::makeSettings(settings) &&
+            settings.numRankedDimensions <= std::max(buildSettings.numRankedDimensions, RankingAtlas::DEFAULT_TOP_K))
+            return;
+
+        stopRankingAtlasBuild();
+    }
+
+    startRankingAtlasBuild(settings);
+}
+
+void SpaceWalkerPlugin::startRankingAtlasBuild(const HoverSettings& settings)
+{
+    _rankingAtlasProgress.reset();
+    _rankingAtlasBuildSettings = settings;
+
+    // Built into a separate atlas, hovering keeps using the current one until the build is done
+    auto atlas = std::make_shared<RankingAtlas>();
+    HoverInputs inputs = getHoverInputs();
+    inputs.rankingAtlas = nullptr;
+    const std::vector<int>* seedPoints = &_dataStore.getViewIndices();
+    int topK = std::max(settings.numRankedDimensions, RankingAtlas::DEFAULT_TOP_K);
+    ComputeProgress* progress = &_rankingAtlasProgress;
+
+    QThread* thread = QThread::create([atlas, settings, inputs, seedPoints, topK, progress]()
+    {
+        atlas->build(settings, inputs, *seedPoints, topK, progress);
+    });
+
+    connect(thread, &QThread::finished, this, [this, thread, atlas]()
+    {
+        thread->deleteLater();
+
+        // Stopped because the inputs or settings changed, the atlas is stale
+        if (thread != _rankingAtlasThread)
+            return;
+
+        _rankingAtlasThread = nullptr;
+
+        if (_rankingAtlasProgress.isCancelled() || atlas->isEmpty())
+            return;
+
+        // Swap in the atlas once the hover worker has stopped reading the old one
+        _hoverWorker.cancelAndWait();
+        _rankingAtlas = std::move(*atlas);
+        _rankingAtlasInputsHash = hashRankingAtlasInputs(RankingAtlas::needsFlood(_rankingAtlasBuildSettings));
+
+        qDebug() << "Ranking atlas of" << _rankingAtlas.getNumPoints() << "points ready";
+
+        onPointSelection();
+    });
+
+    _rankingAtlasThread = thread;
+
+    thread->start(QThread::LowPriority);
+}
+
+void SpaceWalkerPlugin::stopRankingAtlasBuild()
+{
+    if (_rankingAtlasThread == nullptr)
+        return;
+
+    _rankingAtlasProgress.cancel();
+    _rankingAtlasThread->wait();
+
+    // The queued finished handler still deletes the thread
+    _rankingAtlasThread = nullptr;
+}
+
+std::uint64_t SpaceWalkerPlugin::hashRankingAtlasInputs(bool needsFlood)
+{
+    // The source data hash covers the enabled dimensions, the positions and indices cover the view and mask
+    const DataMatrix& projection = _mask.empty() ? _dataStore.getProjectionView() : _maskedProjMatrix;
+    const std::vector<int>& viewIndices = _dataStore.getViewIndices();
+
+    std::uint64_t hash = _sourceDataHash;
+    hash = DerivedDataCache::hashValues(projection.data(), projection.size() * sizeof(float), hash);
+    hash = DerivedDataCache::hashValues(viewIndices.data(), viewIndices.size() * sizeof(int), hash);
+    hash = DerivedDataCache::hashValues(_mask.data(), _mask.size() * sizeof(nint), hash);
+
+    if (needsFlood)
+    {
+        const KnnGraph& graph = !_maskedKnn ? _knnGraph : _maskedKnnGraph;
+        for (const std::vector<nint>& neighbours : graph.getNeighbours())
+            hash = DerivedDataCache::hashValues(neighbours.data(), neighbours.size() * sizeof(nint), hash);
+    }
+
+    return hash;
 }
 
 /******************************************************************************
@@ -1081,6 +1973,7 @@ void SpaceWalkerPlugin::fromVariantMap(const QVariantMap& variantMap)
             }
         }
 
+        invalidateHoverInputs();
         _largeKnnGraph._neighbours = neighbours;
         _largeKnnGraph._numNeighbours = numNeighbours;
 
@@ -1089,6 +1982,33 @@ void SpaceWalkerPlugin::fromVariantMap(const QVariantMap& variantMap)
         computeKnnGraph();
     }
 
+    // Load potential ranking atlas from project, it is used once the data it was built from is prepared
+    if (variantMap.contains("rankingAtlas"))
+    {
+        const auto qrankingAtlas = variantMap["rankingAtlas"].toMap();
+
+        int numPoints = qrankingAtlas["numPoints"].toInt();
+        int numDimensions = qrankingAtlas["numDimensions"].toInt();
+        int topK = qrankingAtlas["topK"].toInt();
+
+        RankingAtlas::Settings settings;
+        settings.filterType = static_cast<filters::FilterType>(qrankingAtlas["filterType"].toInt());
+        settings.restrictToFlood = qrankingAtlas["restrictToFlood"].toBool();
+        settings.numWaves = qrankingAtlas["numWaves"].toInt();
+        settings.innerFilterRadius = qrankingAtlas["innerFilterRadius"].toFloat();
+        settings.outerFilterRadius = qrankingAtlas["outerFilterRadius"].toFloat();
+        settings.hdInnerFilterSize = qrankingAtlas["hdInnerFilterSize"].toInt();
+        settings.projectionSize = qrankingAtlas["projectionSize"].toFloat();
+
+        std::vector<std::uint16_t> dimensions((size_t) std::max(numPoints, 0) * std::max(topK, 0));
+        std::vector<std::uint16_t> scores(dimensions.size());
+        populateDataBufferFromVariantMap(qrankingAtlas["dimensions"].toMap(), (char*)dimensions.data());
+        populateDataBufferFromVariantMap(qrankingAtlas["scores"].toMap(), (char*)scores.data());
+
+        if (_loadedRankingAtlas.restore(settings, SelectionInputVersions(), numPoints, numDimensions, topK, std::move(dimensions), std::move(scores)))
+            _loadedRankingAtlasInputsHash = qrankingAtlas["inputsHash"].toString().toULongLong();
+    }
+
     // Load slice index from project if slice dataset has been set
     if (_sliceDataset.isValid())
     {
@@ -1139,6 +2059,31 @@ QVariantMap SpaceWalkerPlugin::toVariantMap() const
         variantMap.insert("numNeighbours", QVariant::fromValue(neighbours[0].size()));
     }
 
+    // Store the ranking atlas while it belongs to the current data, hashed so it is only used with the same data again
+    if (!_rankingAtlas.isEmpty() && _rankingAtlas.isCurrent(_selectionCache.getVersions()))
+    {
+        const RankingAtlas::Settings& settings = _rankingAtlas.getSettings();
+        const std::vector<std::uint16_t>& dimensions = _rankingAtlas.getDimensions();
+        const std::vector<std::uint16_t>& scores = _rankingAtlas.getScores();
+
+        QVariantMap qrankingAtlas;
+        qrankingAtlas.insert("dimensions", rawDataToVariantMap((char*)dimensions.data(), dimensions.size() * sizeof(std::uint16_t), true));
+        qrankingAtlas.insert("scores", rawDataToVariantMap((char*)scores.data(), scores.size() * sizeof(std::uint16_t), true));
+        qrankingAtlas.insert("numPoints", _rankingAtlas.getNumPoints());
+        qrankingAtlas.insert("numDimensions", _rankingAtlas.getNumDimensions());
+        qrankingAtlas.insert("topK", _rankingAtlas.getTopK());
+        qrankingAtlas.insert("inputsHash", QString::number(_rankingAtlasInputsHash));
+        qrankingAtlas.insert("filterType", static_cast<int>(settings.filterType));
+        qrankingAtlas.insert("restrictToFlood", settings.restrictToFlood);
+        qrankingAtlas.insert("numWaves", settings.numWaves);
+        qrankingAtlas.insert("innerFilterRadius", settings.innerFilterRadius);
+        qrankingAtlas.insert("outerFilterRadius", settings.outerFilterRadius);
+        qrankingAtlas.insert("hdInnerFilterSize", settings.hdInnerFilterSize);
+        qrankingAtlas.insert("projectionSize", settings.projectionSize);
+
+        variantMap.insert("rankingAtlas", qrankingAtlas);
+    }
+
     // Store current slice in project, if slice dataset is valid
     if (_sliceDataset.isValid())
     {
@@ -1169,7 +2114,13 @@ bool SpaceWalkerPlugin::hasMaskApplied()
 
 void SpaceWalkerPlugin::clearMask()
 {
+    invalidateHoverMask();
     _mask.clear();
+    _maskPositions.clear();
+
+    stopDataPreparation();
+    _derivedData.invalidate(_maskNode);
+    updateDerivedData();
 
     // Set point opacity
     std::vector<float> opacityScalars(_dataStore.getNumPoints(), 1.0f);
@@ -1178,6 +2129,8 @@ void SpaceWalkerPlugin::clearMask()
 
 void SpaceWalkerPlugin::useSelectionAsMask()
 {
+    invalidateHoverMask();
+
     // Get current selection
     // Compute the indices that are selected in this local dataset
     std::vector<uint32_t> localSelectionIndices;
@@ -1185,33 +2138,20 @@ void SpaceWalkerPlugin::useSelectionAsMask()
 
     _mask.assign(localSelectionIndices.begin(), localSelectionIndices.end());
 
+    _maskPositions.assign(_dataStore.getNumPoints(), -1);
+    for (int i = 0; i < _mask.size(); i++)
+        _maskPositions[_mask[i]] = i;
+
     // Set point opacity
     std::vector<float> opacityScalars(_dataStore.getNumPoints(), 0.2f);
     for (const int maskIndex : _mask)
         opacityScalars[maskIndex] = 1.0f;
     getScatterplotWidget().setPointOpacityScalars(opacityScalars);
 
-    _maskedDataMatrix = _dataStore.getDataView()(_mask, Eigen::all);
-    _maskedProjMatrix = _dataStore.getProjectionView()(_mask, Eigen::all);
-
-    if (_maskedKnn)
-    {
-        if (_maskedDataMatrix.rows() < 5000)
-            _maskedKnnIndex.create(_maskedDataMatrix.cols(), knn::Metric::MANHATTAN);
-        else
-            _maskedKnnIndex.create(_maskedDataMatrix.cols(), knn::Metric::EUCLIDEAN);
-        _maskedKnnIndex.addData(_maskedDataMatrix);
-
-        _largeKnnGraph.build(_maskedDataMatrix, _maskedKnnIndex, 30);
-
-        if (_maskedDataMatrix.rows() < 5000)
-        {
-            _maskedSourceKnnGraph.build(_maskedDataMatrix, _maskedKnnIndex, 100);
-            _maskedKnnGraph.build(_maskedSourceKnnGraph, 10, true);
-        }
-        else
-            _maskedKnnGraph.build(_maskedDataMatrix, _maskedKnnIndex, 10);
-    }
+    // Subsets the data and builds the masked graphs if enabled
+    stopDataPreparation();
+    _derivedData.invalidate(_maskNode);
+    updateDerivedData();
 }
 
 void SpaceWalkerPlugin::useSelectionAsDataView(std::vector<int>& indices)
@@ -1223,23 +2163,13 @@ void SpaceWalkerPlugin::useSelectionAsDataView(std::vector<int>& indices)
     //std::vector<int> indices;
     //indices.assign(localSelectionIndices.begin(), localSelectionIndices.end());
 
-    _dataStore.createDataView(indices);
-
-    int xDim = _settingsAction.getPositionAction().getDimensionX();
-    int yDim = _settingsAction.getPositionAction().getDimensionY();
-    qDebug() << "Selected dimensions: " << xDim << yDim;
-    _dataStore.createProjectionView(xDim, yDim);
+    invalidateHoverInputs();
 
-    // Convert projection data to 2D vector list
-    std::vector<Vector2f> positions(_dataStore.getProjectionView().rows());
-    {
-        logger() << "Convert projection data to 2D vector list...";
-        for (int i = 0; i < _dataStore.getProjectionView().rows(); i++)
-            positions[i].set(_dataStore.getProjectionView()(i, 0), _dataStore.getProjectionView()(i, 1));
-    }
-
-    // Update the views with the new data
-    updateViewData(positions);
+    // Recomputes the data view, the projection view and the views showing it
+    stopDataPreparation();
+    _dataViewIndices = indices;
+    _derivedData.invalidate(_dataViewSelectionNode);
+    updateDerivedData();
 
     // Update the color of the points
     if (_colorScalars.size() == _positionDataset->getNumPoints())
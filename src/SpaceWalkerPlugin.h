@@ -12,8 +12,8 @@
 #include "graphics/Vector3f.h"
 #include "Graph/GraphView.h"
 
-#include "DataMatrix.h"
-#include "Logging.h"
+#include "DataConversion.h"
+#include "FloodScalarPublisher.h"
 
 #include <actions/HorizontalToolbarAction.h>
 #include <actions/ColorMap1DAction.h>
@@ -22,9 +22,27 @@
 #include "Compute/KnnIndex.h"
 #include "Compute/KnnGraph.h"
 #include "Compute/Filters.h"
+#include "Compute/ComputeProgress.h"
+#include "Compute/LatestJobWorker.h"
+#include "Compute/FloodWorkingSet.h"
+#include "Compute/HistogramEngine.h"
+#include "Compute/PointGrid.h"
+#include "Compute/SelectionCache.h"
+#include "Compute/DependencyGraph.h"
+#include "Compute/DataTransformations.h"
+#include "Compute/HoverPipeline.h"
+#include "Compute/HoverReplay.h"
+#include "Compute/RankingAtlas.h"
+#include "IO/DerivedDataCache.h"
 
 #include <QPoint>
 
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+class QThread;
+
 using namespace hdps::plugin;
 using namespace hdps::util;
 
@@ -44,14 +62,6 @@ namespace hdps
     }
 }
 
-enum class OverlayType
-{
-    NONE,
-    DIM_VALUES,
-    LOCAL_DIMENSIONALITY,
-    DIRECTIONS
-};
-
 class SpaceWalkerPlugin : public ViewPlugin
 {
     Q_OBJECT
@@ -61,17 +71,44 @@ public:
     ~SpaceWalkerPlugin() override;
 
     bool isDataInitialized() { return _dataInitialized; }
+    bool isDataPrepared() { return _dataPrepared; }
 
     void init() override;
     void resetState();
 
     void onDataEvent(hdps::DatasetEvent* dataEvent);
+
+    /** Update the data to the dimensions enabled in the source dataset, only the added dimensions are converted */
+    void onEnabledDimensionsChanged();
     void onPointSelection();
 
+    /** Start the hover pipeline for the current selected point */
+    void submitHoverJob();
+
     void computeGraphs();
 
     void computeStaticData();
 
+private: // Derived data
+    /** Declare the artifacts derived from the dataset and what they depend on */
+    void initDerivedData();
+
+    /** Compute the derived artifacts that are out of date, the positions right away and the rest in the background */
+    void updateDerivedData();
+
+    /** Compute the artifacts the positions don't depend on in the background, flooding starts once they are ready */
+    void startDataPreparation();
+
+    /** Compute the artifacts that depend on the prepared data */
+    void onDataPrepared();
+
+    /** Cancel a running data preparation and wait until it has stopped using the data, the rest stays out of date */
+    void stopDataPreparation();
+
+    void onProjectionDimensionsChanged();
+
+public:
+
     /**
      * Load one (or more datasets in the view)
      * @param datasets Dataset(s) to load
@@ -85,8 +122,8 @@ public:
     void createSubset(const bool& fromSourceData = false, const QString& name = "");
 
 public: // Dimension picking
-    void setXDimension(const std::int32_t& dimensionIndex) { updateProjectionData(); }
-    void setYDimension(const std::int32_t& dimensionIndex) { updateProjectionData(); }
+    void setXDimension(const std::int32_t& dimensionIndex) { onProjectionDimensionsChanged(); }
+    void setYDimension(const std::int32_t& dimensionIndex) { onProjectionDimensionsChanged(); }
 
 public: // Data loading
 
@@ -126,14 +163,23 @@ public:
 
     filters::SpatialPeakFilter& getSpatialPeakFilter()  { return _spatialPeakFilter; }
     filters::HDFloodPeakFilter& getHDPeakFilter()       { return _hdFloodPeakFilter; }
+
+    /** Set the number of top dimensions the filters rank on each selection */
+    void setNumRankedDimensions(int topK);
+
+    /** Rank all points in the background for the current filter settings, so hovering looks the rankings up */
+    void setRankingAtlasEnabled(bool enabled);
     
     DataStorage& getDataStore()                         { return _dataStore; }
     float getProjectionSize()                           { return _dataStore.getProjectionSize(); }
 
 public: // Flood fill
-    void createKnnIndex();
+    /** Build the kNN graphs in the background, or slice them from a graph loaded with the project */
     void computeKnnGraph();
-    void rebuildKnnGraph(int floodNeighbours) { _knnGraph.build(_dataStore.getBaseData(), _knnIndex, floodNeighbours); }
+    void rebuildKnnGraph(int floodNeighbours);
+
+    void cancelKnnGraphBuild();
+    bool isBuildingKnnGraph() const { return _knnBuildThread != nullptr; }
 
     FloodFill& getFloodFill() { return _floodFill; }
 
@@ -145,9 +191,104 @@ public: // Flood fill
 
     void useSharedDistances(bool useSharedDistances) { _useSharedDistances = useSharedDistances; }
 
+    /** Set the number of bins of the flood node histograms in the graph view */
+    void setNumGraphBins(int numBins);
+
 public: // Slicing
     void onSliceIndexChanged();
 
+private: // Hover pipeline
+    /** Point the cursor is expected to select soon */
+    struct SelectionCandidate
+    {
+        nint                selectedPoint;
+        nint                seedPoint;
+    };
+
+    /** Settings of a single selection, copied on the GUI thread so the worker never reads them while they change */
+    struct HoverJob : HoverSettings
+    {
+        nint                selectedPoint;
+        nint                globalSelectedPoint;
+        nint                seedPoint;
+        dint                selectedDimension;
+        std::vector<SelectionCandidate> prefetchCandidates;
+    };
+
+    /** Everything the widgets need from a selection, applied in one go on the GUI thread */
+    struct HoverResult
+    {
+        std::uint64_t                   generation = 0;
+        nint                            globalSelectedPoint = 0;
+        dint                            selectedDimension = -1;
+        FloodFill                       floodFill = FloodFill(0);
+        std::vector<int>                dimRanking;
+        std::vector<std::vector<float>> projectionScalars;
+        std::vector<float>              selectedDimensionScalars;
+        QString                         coloredBy;
+        bool                            hasDirections = false;
+        std::vector<Vector2f>           directions;
+        HoverColors                     colors;
+        std::vector<std::vector<int>>   bins;
+    };
+
+    /** Pipeline state only touched by the hover worker, filters keep their caches between selections */
+    struct HoverState
+    {
+        HoverPipeline                   pipeline;
+        std::chrono::steady_clock::time_point lastDelivery;
+
+        // Scratch buffers for prefetched selections, kept apart from the shown selection
+        FloodFill                       prefetchFloodFill = FloodFill(0);
+        FloodWorkingSet                 prefetchWorkingSet;
+        std::vector<int>                prefetchRanking;
+    };
+
+    /** Runs on the hover worker, drops out at stage boundaries when a newer selection came in */
+    void runHoverJob(const HoverJob& job, std::uint64_t generation);
+
+    /** Reuse an applied result, so its buffers keep their capacity between selections */
+    std::shared_ptr<HoverResult> acquireHoverResult();
+    void releaseHoverResult(std::shared_ptr<HoverResult> result);
+
+    /** Data the hover worker reads, only valid while no data is changed */
+    HoverInputs getHoverInputs();
+
+    /** Compute the candidate selections of the job ahead of time, stops as soon as a new job comes in */
+    void prefetchSelections(const HoverJob& job, std::uint64_t generation);
+
+    /** Print the selection cache hit rate and prefetching statistics since the last report */
+    void reportPrefetchStats();
+    void applyHoverResult(HoverResult& result);
+    void applyColorScalars(HoverResult& result);
+
+    /** Drop pending selections and wait for the hover worker, required before changing any data it reads */
+    void cancelHoverJobs();
+
+    /** Cancel the hover jobs and drop the cached results that depend on the data, graphs, mask or all of them */
+    void invalidateHoverData();
+    void invalidateHoverGraph();
+    void invalidateHoverMask();
+    void invalidateHoverInputs();
+
+private: // Flood fill
+    /** @param refine Refine the current graphs to the changed data instead of building new ones */
+    void startKnnGraphBuild(bool refine = false);
+
+    /** Cancel a running kNN build and wait until it has stopped using the data */
+    void stopKnnGraphBuild();
+
+private: // Ranking atlas
+    /** Use or build an atlas for the settings of a hover job, unless the current atlas or running build matches them */
+    void updateRankingAtlas(const HoverSettings& settings);
+    void startRankingAtlasBuild(const HoverSettings& settings);
+
+    /** Cancel a running atlas build and wait until it has stopped reading the hover inputs */
+    void stopRankingAtlasBuild();
+
+    /** Hash of the inputs the rankings are computed from, identifies the data an atlas of a project belongs to */
+    std::uint64_t hashRankingAtlasInputs(bool needsFlood);
+
 private: // Updating functions
     void updateProjectionData();
     void updateSelection();
@@ -159,6 +300,14 @@ private: // Updating functions
 private: // Mouse Interaction
     void notifyNewSelectedPoint();
     void mousePositionChanged(Vector2f mousePos);
+
+    /** Collapse mouse samples to the latest one per display frame */
+    void scheduleMousePosition(Vector2f mousePos);
+    void processPendingMousePosition();
+
+    /** Notify the core of the selected point at a limited rate while dragging, or right away */
+    void scheduleSelectionNotification();
+    void flushSelectionNotification();
     bool eventFilter(QObject* target, QEvent* event);
 
 public: // Import / Export
@@ -166,6 +315,16 @@ public: // Import / Export
     void exportFloodnodes();
     void importKnnGraph();
 
+    /** Print the latency statistics of the traced stages and write the recorded spans as Chrome trace JSON */
+    void exportTrace();
+
+    /**
+     * Record the selections of the hover pipeline together with its inputs, to replay them with
+     * SpaceWalkerReplay. Recording stops and the file is written when the inputs change.
+     */
+    void startHoverRecording();
+    void stopHoverRecording();
+
 private slots: // Graph
     void onLineClicked(dint dim);
 
@@ -198,9 +357,53 @@ private:
 
     std::vector<std::vector<float>> _normalizedData;
     std::vector<QString>            _enabledDimNames;
-    bool                            _dataInitialized = false;
+    bool                            _dataInitialized = false;   /** Whether the positions are shown */
+    bool                            _dataPrepared = false;      /** Whether the data the selections are computed from is ready */
+    bool                            _projectionDataPending = false; /** Whether the positions wait for the views to initialize */
+
+    // Preprocessed data and kNN graphs of earlier sessions, keyed by the converted data
+    DerivedDataCache                _derivedDataCache;
+    std::uint64_t                   _sourceDataHash = 0;        /** Hash of the converted data before standardization */
+    bool                            _preprocessedFromCache = false;
+
+    // Dimensions that are enabled or disabled only convert, standardize and normalize the added columns
+    std::vector<int>                _dataDimensions;            /** Dimensions of the converted columns, empty to convert all of them */
+    std::vector<std::uint64_t>      _columnHashes;              /** Hashes of the converted columns, combined into _sourceDataHash */
+    DimensionChange                 _dimensionChange;           /** Change of the last conversion if it only converted the added dimensions */
+    DataMatrix                      _addedColumns;              /** Added columns, until they are standardized and normalized */
+    bool                            _incrementalConversion = false;
+
+    // Artifacts derived from the dataset, recomputed when the inputs they depend on change
+    DependencyGraph                 _derivedData;
+    DependencyGraph::NodeId         _sourceDataNode;
+    DependencyGraph::NodeId         _sourceProjectionNode;
+    DependencyGraph::NodeId         _dimensionNamesNode;
+    DependencyGraph::NodeId         _standardizedDataNode;
+    DependencyGraph::NodeId         _normalizedDataNode;
+    DependencyGraph::NodeId         _graphBinsNode;
+    DependencyGraph::NodeId         _dataViewSelectionNode;     /** Input node, invalidated when _dataViewIndices changes */
+    DependencyGraph::NodeId         _pointViewNode;
+    DependencyGraph::NodeId         _dataViewNode;
+    DependencyGraph::NodeId         _projectionViewNode;
+    DependencyGraph::NodeId         _knnGraphNode;
+    DependencyGraph::NodeId         _maskNode;                  /** Input node, invalidated when _mask changes */
+    DependencyGraph::NodeId         _maskedDataNode;
+    DependencyGraph::NodeId         _maskedKnnGraphNode;
+    QThread*                        _dataPreparationThread = nullptr;
+    ComputeProgress                 _dataPreparationProgress;
+    QTimer*                         _dataPreparationTimer;
+
     std::vector<nint>               _mask;
+    std::vector<int>                _dataViewIndices;           /** Points in the data view, empty for all points */
+    std::vector<int>                _maskPositions;             /** Position of each point in the mask, -1 for points outside of it */
+    PointGrid                       _pointGrid;                 /** Projection view positions for picking */
     std::vector<float>              _colorScalars;
+    std::vector<int>                _coloredIndices;            /** Points colored by the last selection */
+    float                           _colorBackground = 0;       /** Normalized color scalar of the points outside the flood */
+    bool                            _viewColorScalarsValid = false; /** Whether the scatterplot still shows _colorScalars */
+    std::vector<int>                _changedViewIndices;
+    std::vector<float>              _changedViewScalars;
+    std::vector<float>              _viewScalars;
 
     // Interaction
     nint                            _selectedPoint = 0;
@@ -208,6 +411,11 @@ private:
     dint                            _selectedDimension;
 
     bool                            _mousePressed = false;
+    QTimer*                         _mouseFrameTimer;           /** Runs for one display frame after a mouse sample was processed */
+    QTimer*                         _selectionNotifyTimer;      /** Delays notifying the core of the selection during a drag */
+    Vector2f                        _pendingMousePos;
+    bool                            _hasPendingMousePos = false;
+    bool                            _notifyingOwnSelection = false;
     int                             _selectedViewIndex = 0;
     bool                            _loadingFromProject = false;
 
@@ -216,6 +424,7 @@ private:
     filters::FilterType             _filterType;
     filters::SpatialPeakFilter      _spatialPeakFilter;
     filters::HDFloodPeakFilter      _hdFloodPeakFilter;
+    std::vector<int>                _dimRanking;
 
     // KNN
     bool                            _computeOnLoad = false;
@@ -226,6 +435,19 @@ private:
     KnnGraph                        _sourceKnnGraph;
     bool                            _useSharedDistances = false;
     bool                            _preloadedKnnGraph = false;
+    QThread*                        _knnBuildThread = nullptr;
+    ComputeProgress                 _knnBuildProgress;
+    QTimer*                         _knnBuildTimer;
+
+    // Ranking atlas
+    bool                            _rankingAtlasEnabled = false;
+    RankingAtlas                    _rankingAtlas;              /** Read by the hover worker, only replaced while it is idle */
+    std::uint64_t                   _rankingAtlasInputsHash = 0;
+    RankingAtlas                    _loadedRankingAtlas;        /** Atlas of the project, used once the data it was built from is prepared */
+    std::uint64_t                   _loadedRankingAtlasInputsHash = 0;
+    QThread*                        _rankingAtlasThread = nullptr;
+    ComputeProgress                 _rankingAtlasProgress;
+    HoverSettings                   _rankingAtlasBuildSettings; /** Settings of the running build */
 
     // Slicing
     Dataset<Clusters>               _sliceDataset;
@@ -241,11 +463,26 @@ private:
 
     // Floodfill
     Dataset<Points>                 _floodScalars;
+    FloodScalarPublisher            _floodScalarPublisher;
     FloodFill                       _floodFill;
 
+    // Hover pipeline
+    LatestJobWorker                 _hoverWorker;
+    HoverState                      _hoverState;
+    SelectionCache                  _selectionCache;            /** Only used by the hover worker, or while it is idle */
+    std::vector<SelectionCandidate> _prefetchCandidates;        /** Predicted selections for the next job */
+    Vector2f                        _lastPickPosition;          /** Last mouse position in projection coordinates */
+    bool                            _hasLastPickPosition = false;
+    std::uint64_t                   _lastAppliedHoverGeneration = 0;
+    std::vector<std::shared_ptr<HoverResult>> _hoverResultPool; /** Applied results, handed back from the GUI thread */
+    std::mutex                      _hoverResultPoolMutex;
+    std::unique_ptr<HoverRecording> _hoverRecording;            /** Session being recorded, nullptr when not recording */
+    std::uint64_t                   _hoverRecordingStart = 0;
+
     // Graph
     GraphView*                      _graphView;
     std::vector<std::vector<int>>   _bins;
+    int                             _numGraphBins;
     QTimer*                         _graphTimer;
 
     // Local dimensionality
@@ -0,0 +1,392 @@
+#include "Tracing.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace tracing
+{
+    namespace detail
+    {
+        std::atomic<bool> enabled(false);
+    }
+
+    namespace
+    {
+        constexpr std::uint64_t RING_CAPACITY = 1 << 14;
+
+        /**
+         * Span in a ring buffer. Fields are atomic so that exporting while the owning thread keeps
+         * tracing is well defined, slots overwritten during an export are discarded by the reader.
+         */
+        struct Event
+        {
+            std::atomic<const Stage*>   stage;
+            std::atomic<std::uint64_t>  begin;
+            std::atomic<std::uint64_t>  end;
+            std::atomic<std::uint64_t>  allocations;
+            std::atomic<std::uint64_t>  allocatedBytes;
+        };
+
+        /** Spans of a single thread, only that thread writes to it */
+        struct ThreadBuffer
+        {
+            explicit ThreadBuffer(int threadId) :
+                threadId(threadId),
+                events(RING_CAPACITY),
+                head(0),
+                start(0)
+            {
+
+            }
+
+            const int                   threadId;
+            std::vector<Event>          events;
+            std::atomic<std::uint64_t>  head;       /** Number of spans ever written */
+            std::atomic<std::uint64_t>  start;      /** Spans before this one were cleared by reset() */
+        };
+
+        struct Registry
+        {
+            std::mutex                                      mutex;
+            std::map<std::string, std::unique_ptr<Stage>>   stages;
+            std::vector<std::shared_ptr<ThreadBuffer>>      buffers;    /** Kept after their thread exits so its spans can still be exported */
+        };
+
+        // Never destroyed, threads may still trace during static destruction
+        Registry& registry()
+        {
+            static Registry* instance = new Registry();
+            return *instance;
+        }
+
+        ThreadBuffer& threadBuffer()
+        {
+            thread_local std::shared_ptr<ThreadBuffer> buffer = []()
+            {
+                Registry& reg = registry();
+                std::lock_guard<std::mutex> lock(reg.mutex);
+
+                auto newBuffer = std::make_shared<ThreadBuffer>((int) reg.buffers.size() + 1);
+                reg.buffers.push_back(newBuffer);
+                return newBuffer;
+            }();
+            return *buffer;
+        }
+
+        double toMilliseconds(std::uint64_t nanoseconds)
+        {
+            return nanoseconds / 1e6;
+        }
+
+        void writeJsonString(std::ostream& out, const std::string& str)
+        {
+            out << '"';
+            for (char c : str)
+            {
+                if (c == '"' || c == '\\')
+                    out << '\\' << c;
+                else if ((unsigned char) c < 0x20)
+                    out << ' ';
+                else
+                    out << c;
+            }
+            out << '"';
+        }
+    }
+
+    void setEnabled(bool enabled)
+    {
+        detail::enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    std::uint64_t now()
+    {
+        return (std::uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /******************************************************************************
+     * StageHistogram
+     ******************************************************************************/
+
+    StageHistogram::StageHistogram() :
+        _total(0),
+        _max(0)
+    {
+        reset();
+    }
+
+    int StageHistogram::bucketIndex(std::uint64_t nanoseconds)
+    {
+        if (nanoseconds < 4)
+            return (int) nanoseconds;
+
+        // Octave from the highest set bit, sub-bucket from the two bits below it
+        int octave = 63;
+        while ((nanoseconds >> octave) == 0)
+            octave--;
+        int subBucket = (int) ((nanoseconds >> (octave - 2)) & 3);
+
+        return std::min(octave * 4 + subBucket, NUM_BUCKETS - 1);
+    }
+
+    std::uint64_t StageHistogram::bucketUpperBound(int bucket)
+    {
+        if (bucket < 4)
+            return (std::uint64_t) bucket;
+
+        int octave = bucket / 4;
+        int subBucket = bucket % 4;
+        if (octave >= 63)
+            return UINT64_MAX;
+        return ((std::uint64_t) (4 + subBucket + 1) << (octave - 2)) - 1;
+    }
+
+    void StageHistogram::record(std::uint64_t nanoseconds)
+    {
+        _buckets[bucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        _total.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+        std::uint64_t max = _max.load(std::memory_order_relaxed);
+        while (nanoseconds > max && !_max.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed));
+    }
+
+    void StageHistogram::reset()
+    {
+        for (auto& bucket : _buckets)
+            bucket.store(0, std::memory_order_relaxed);
+        _total.store(0, std::memory_order_relaxed);
+        _max.store(0, std::memory_order_relaxed);
+    }
+
+    std::uint64_t StageHistogram::getCount() const
+    {
+        std::uint64_t count = 0;
+        for (const auto& bucket : _buckets)
+            count += bucket.load(std::memory_order_relaxed);
+        return count;
+    }
+
+    double StageHistogram::getMean() const
+    {
+        std::uint64_t count = getCount();
+        return count == 0 ? 0 : (double) _total.load(std::memory_order_relaxed) / count;
+    }
+
+    std::uint64_t StageHistogram::getQuantile(double quantile) const
+    {
+        std::uint64_t count = getCount();
+        if (count == 0)
+            return 0;
+
+        std::uint64_t rank = (std::uint64_t) std::max(1.0, quantile * count + 0.5);
+
+        std::uint64_t cumulative = 0;
+        for (int b = 0; b < NUM_BUCKETS; b++)
+        {
+            cumulative += _buckets[b].load(std::memory_order_relaxed);
+            if (cumulative >= rank)
+                return std::min(bucketUpperBound(b), getMax());
+        }
+        return getMax();
+    }
+
+    /******************************************************************************
+     * Recording
+     ******************************************************************************/
+
+    Stage& registerStage(const std::string& name)
+    {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+
+        std::unique_ptr<Stage>& stage = reg.stages[name];
+        if (!stage)
+            stage = std::make_unique<Stage>(name);
+        return *stage;
+    }
+
+    void record(Stage& stage, std::uint64_t begin, std::uint64_t end, const allocations::Counts& allocated)
+    {
+        stage.histogram.record(end - begin);
+        stage.allocations.fetch_add(allocated.allocations, std::memory_order_relaxed);
+        stage.allocatedBytes.fetch_add(allocated.bytes, std::memory_order_relaxed);
+
+        ThreadBuffer& buffer = threadBuffer();
+        std::uint64_t head = buffer.head.load(std::memory_order_relaxed);
+
+        Event& event = buffer.events[head % RING_CAPACITY];
+        event.stage.store(&stage, std::memory_order_relaxed);
+        event.begin.store(begin, std::memory_order_relaxed);
+        event.end.store(end, std::memory_order_relaxed);
+        event.allocations.store(allocated.allocations, std::memory_order_relaxed);
+        event.allocatedBytes.store(allocated.bytes, std::memory_order_relaxed);
+
+        buffer.head.store(head + 1, std::memory_order_release);
+    }
+
+    /******************************************************************************
+     * Reporting
+     ******************************************************************************/
+
+    std::vector<StageStatistics> getStageStatistics()
+    {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+
+        std::vector<StageStatistics> statistics;
+        for (const auto& [name, stage] : reg.stages)
+        {
+            const StageHistogram& histogram = stage->histogram;
+
+            std::uint64_t count = histogram.getCount();
+            if (count == 0)
+                continue;
+
+            StageStatistics stats;
+            stats.name = name;
+            stats.count = count;
+            stats.meanMs = histogram.getMean() / 1e6;
+            stats.p50Ms = toMilliseconds(histogram.getQuantile(0.5));
+            stats.p90Ms = toMilliseconds(histogram.getQuantile(0.9));
+            stats.p99Ms = toMilliseconds(histogram.getQuantile(0.99));
+            stats.maxMs = toMilliseconds(histogram.getMax());
+            stats.meanAllocations = (double) stage->allocations.load(std::memory_order_relaxed) / count;
+            stats.meanAllocatedBytes = (double) stage->allocatedBytes.load(std::memory_order_relaxed) / count;
+            statistics.push_back(stats);
+        }
+        return statistics;
+    }
+
+    void printStageStatistics()
+    {
+        std::vector<StageStatistics> statistics = getStageStatistics();
+        if (statistics.empty())
+            return;
+
+        bool counting = allocations::isCounting();
+
+        std::cout << std::left << std::setw(40) << "Stage" << std::right
+            << std::setw(10) << "Count" << std::setw(12) << "Mean ms" << std::setw(12) << "p50 ms"
+            << std::setw(12) << "p90 ms" << std::setw(12) << "p99 ms" << std::setw(12) << "Max ms";
+        if (counting)
+            std::cout << std::setw(12) << "Allocs" << std::setw(12) << "KiB";
+        std::cout << std::endl;
+
+        std::cout << std::fixed << std::setprecision(3);
+        for (const StageStatistics& stats : statistics)
+        {
+            std::cout << std::left << std::setw(40) << stats.name << std::right
+                << std::setw(10) << stats.count << std::setw(12) << stats.meanMs << std::setw(12) << stats.p50Ms
+                << std::setw(12) << stats.p90Ms << std::setw(12) << stats.p99Ms << std::setw(12) << stats.maxMs;
+            if (counting)
+                std::cout << std::setw(12) << stats.meanAllocations << std::setw(12) << stats.meanAllocatedBytes / 1024;
+            std::cout << std::endl;
+        }
+        std::cout << std::defaultfloat << std::setprecision(6);
+    }
+
+    bool exportChromeTrace(const std::string& fileName)
+    {
+        std::ofstream file(fileName);
+        if (!file)
+        {
+            std::cout << "Cannot open file for writing the trace!" << std::endl;
+            return false;
+        }
+
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            buffers = reg.buffers;
+        }
+
+        struct ExportedEvent
+        {
+            const Stage*    stage;
+            std::uint64_t   begin;
+            std::uint64_t   end;
+            std::uint64_t   allocations;
+            std::uint64_t   allocatedBytes;
+            int             threadId;
+        };
+
+        std::vector<ExportedEvent> events;
+        for (const auto& buffer : buffers)
+        {
+            std::uint64_t head = buffer->head.load(std::memory_order_acquire);
+            std::uint64_t first = std::max(head > RING_CAPACITY ? head - RING_CAPACITY : 0, buffer->start.load(std::memory_order_relaxed));
+
+            size_t bufferStart = events.size();
+            for (std::uint64_t i = first; i < head; i++)
+            {
+                const Event& event = buffer->events[i % RING_CAPACITY];
+                events.push_back({ event.stage.load(std::memory_order_relaxed), event.begin.load(std::memory_order_relaxed), event.end.load(std::memory_order_relaxed),
+                    event.allocations.load(std::memory_order_relaxed), event.allocatedBytes.load(std::memory_order_relaxed), buffer->threadId });
+            }
+
+            // Drop the slots the thread overwrote while they were being read
+            std::uint64_t newHead = buffer->head.load(std::memory_order_acquire);
+            std::uint64_t firstValid = newHead > RING_CAPACITY ? newHead - RING_CAPACITY : 0;
+            if (firstValid > first)
+            {
+                size_t numOverwritten = (size_t) (std::min(firstValid, head) - first);
+                events.erase(events.begin() + bufferStart, events.begin() + bufferStart + numOverwritten);
+            }
+        }
+
+        std::uint64_t origin = UINT64_MAX;
+        for (const ExportedEvent& event : events)
+            origin = std::min(origin, event.begin);
+
+        bool counting = allocations::isCounting();
+
+        file << std::fixed << std::setprecision(3);
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        for (size_t i = 0; i < events.size(); i++)
+        {
+            const ExportedEvent& event = events[i];
+
+            if (i != 0) file << ',';
+            file << "\n{\"name\":";
+            writeJsonString(file, event.stage->name);
+            file << ",\"cat\":\"SpaceWalker\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.threadId
+                << ",\"ts\":" << (event.begin - origin) / 1e3 << ",\"dur\":" << (event.end - event.begin) / 1e3;
+            if (counting)
+                file << ",\"args\":{\"allocations\":" << event.allocations << ",\"bytes\":" << event.allocatedBytes << '}';
+            file << '}';
+        }
+        file << "\n]}\n";
+
+        if (!file)
+        {
+            std::cout << "Failed writing the trace to file!" << std::endl;
+            return false;
+        }
+
+        std::cout << "Trace with " << events.size() << " spans written to file: " << fileName << std::endl;
+        return true;
+    }
+
+    void reset()
+    {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+
+        for (auto& [name, stage] : reg.stages)
+        {
+            stage->histogram.reset();
+            stage->allocations.store(0, std::memory_order_relaxed);
+            stage->allocatedBytes.store(0, std::memory_order_relaxed);
+        }
+
+        // Spans are skipped rather than cleared, the owning threads keep writing without locks
+        for (auto& buffer : reg.buffers)
+            buffer->start.store(buffer->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "Allocations.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Low overhead tracing of the compute and render stages.
+ *
+ * Spans are recorded into a fixed size ring buffer per thread without locking, and their
+ * durations are added to a latency histogram of their stage. Recorded spans can be exported
+ * as Chrome trace JSON (chrome://tracing, Perfetto). Tracing is off by default, a disabled
+ * span costs a single relaxed atomic load.
+ *
+ * When the executable counts allocations (see Allocations.h), spans also record the allocations
+ * made while they were open. The counters are shared by all threads, so the allocations of
+ * threads running alongside a span are attributed to it as well.
+ *
+ *   void compute()
+ *   {
+ *       TRACE_SCOPE("Compute");
+ *       ...
+ *   }
+ */
+namespace tracing
+{
+    namespace detail
+    {
+        extern std::atomic<bool> enabled;
+    }
+
+    inline bool isEnabled() { return detail::enabled.load(std::memory_order_relaxed); }
+    void setEnabled(bool enabled);
+
+    /** Nanoseconds since the start of the process */
+    std::uint64_t now();
+
+    /** Latency histogram with four logarithmic buckets per power of two nanoseconds */
+    class StageHistogram
+    {
+    public:
+        static constexpr int NUM_BUCKETS = 64 * 4;
+
+        StageHistogram();
+
+        void record(std::uint64_t nanoseconds);
+        void reset();
+
+        std::uint64_t getCount() const;
+        std::uint64_t getMax() const { return _max.load(std::memory_order_relaxed); }
+        double getMean() const;
+
+        /** Upper bound of the bucket holding the given quantile in [0, 1], in nanoseconds */
+        std::uint64_t getQuantile(double quantile) const;
+
+    private:
+        static int bucketIndex(std::uint64_t nanoseconds);
+        static std::uint64_t bucketUpperBound(int bucket);
+
+        std::atomic<std::uint64_t> _buckets[NUM_BUCKETS];
+        std::atomic<std::uint64_t> _total;
+        std::atomic<std::uint64_t> _max;
+    };
+
+    /** A traced stage, registered once per distinct name and never destroyed */
+    struct Stage
+    {
+        explicit Stage(const std::string& name) : name(name), allocations(0), allocatedBytes(0) { }
+
+        const std::string           name;
+        StageHistogram              histogram;
+        std::atomic<std::uint64_t>  allocations;        /** Totals over all spans, zero unless allocations are counted */
+        std::atomic<std::uint64_t>  allocatedBytes;
+    };
+
+    /** Find or register the stage with the given name, call sites cache the result */
+    Stage& registerStage(const std::string& name);
+
+    /** Record the span of a stage, prefer the TRACE_SCOPE and TRACE_SPAN macros */
+    void record(Stage& stage, std::uint64_t begin, std::uint64_t end, const allocations::Counts& allocated = allocations::Counts());
+
+    /** Times the enclosing scope, or until end() is called */
+    class Span
+    {
+    public:
+        explicit Span(Stage& stage) :
+            _stage(stage),
+            _begin(isEnabled() ? now() : 0)
+        {
+            if (_begin != 0 && allocations::isCounting())
+                _allocationsBegin = allocations::getCounts();
+        }
+
+        ~Span() { end(); }
+
+        void end()
+        {
+            if (_begin == 0)
+                return;
+
+            allocations::Counts allocated;
+            if (allocations::isCounting())
+                allocated = allocations::getCounts() - _allocationsBegin;
+
+            record(_stage, _begin, now(), allocated);
+            _begin = 0;
+        }
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+    private:
+        Stage&                  _stage;
+        std::uint64_t           _begin;                 /** Zero if tracing was disabled at the start of the span, or the span has ended */
+        allocations::Counts     _allocationsBegin;
+    };
+
+    struct StageStatistics
+    {
+        std::string     name;
+        std::uint64_t   count;
+        double          meanMs;
+        double          p50Ms;
+        double          p90Ms;
+        double          p99Ms;
+        double          maxMs;
+        double          meanAllocations;        /** Per span, zero unless allocations are counted */
+        double          meanAllocatedBytes;
+    };
+
+    /** Latency statistics of all stages that recorded at least one span, sorted by name */
+    std::vector<StageStatistics> getStageStatistics();
+
+    /** Print the latency statistics of all stages to stdout */
+    void printStageStatistics();
+
+    /**
+     * Write the spans still held by the ring buffers as Chrome trace JSON.
+     * @return False if the file could not be written
+     */
+    bool exportChromeTrace(const std::string& fileName);
+
+    /** Clear the recorded spans, the stage histograms and allocation totals */
+    void reset();
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+/** Trace the enclosing scope as a stage with the given name */
+#define TRACE_SCOPE(name) \
+    static tracing::Stage& TRACE_CONCAT(traceStage, __LINE__) = tracing::registerStage(name); \
+    tracing::Span TRACE_CONCAT(traceSpan, __LINE__)(TRACE_CONCAT(traceStage, __LINE__))
+
+/** Declare a span variable that can be ended before the scope closes with variable.end() */
+#define TRACE_SPAN(variable, name) \
+    static tracing::Stage& TRACE_CONCAT(variable, Stage) = tracing::registerStage(name); \
+    tracing::Span variable(TRACE_CONCAT(variable, Stage))
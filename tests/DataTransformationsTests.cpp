@@ -0,0 +1,91 @@
+#include "TestSuite.h"
+#include "TestData.h"
+
+#include "Compute/DataTransformations.h"
+#include "IO/DerivedDataCache.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    DataMatrix selectColumns(const DataMatrix& data, const std::vector<int>& columns)
+    {
+        return data(Eigen::all, columns);
+    }
+}
+
+TEST_CASE(DataTransformations, DimensionChange)
+{
+    DimensionChange change({ 1, 3, 4, 7 }, { 0, 3, 5, 7, 8 });
+
+    CHECK(change.sourceColumns == std::vector<int>({ -1, 1, -1, 3, -1 }));
+    CHECK(change.addedDimensions == std::vector<int>({ 0, 5, 8 }));
+
+    DimensionChange unchanged({ 2, 4 }, { 2, 4 });
+    CHECK(unchanged.sourceColumns == std::vector<int>({ 0, 1 }));
+    CHECK(unchanged.addedDimensions.empty());
+}
+
+TEST_CASE(DataTransformations, ApplyDimensionChange)
+{
+    DataMatrix full = TestData::makeClusteredData(300, 12, 4, 2);
+
+    std::vector<int> oldDimensions = { 0, 1, 2, 4, 5, 9 };
+    std::vector<int> newDimensions = { 1, 3, 4, 6, 7, 9, 11 };
+    DimensionChange change(oldDimensions, newDimensions);
+
+    DataMatrix data = selectColumns(full, oldDimensions);
+    applyDimensionChange(change, data, selectColumns(full, change.addedDimensions));
+    CHECK(data == selectColumns(full, newDimensions));
+
+    std::vector<int> values = oldDimensions;
+    std::vector<int> addedValues = change.addedDimensions;
+    applyDimensionChange(change, values, addedValues);
+    CHECK(values == newDimensions);
+}
+
+TEST_CASE(DataTransformations, IncrementalMatchesFullConversion)
+{
+    DataMatrix full = TestData::makeClusteredData(400, 16, 5, 3);
+
+    std::vector<int> oldDimensions = { 0, 2, 3, 5, 8, 9, 10, 15 };
+    std::vector<int> newDimensions = { 0, 1, 3, 5, 6, 9, 10, 13, 14 };
+
+    // Full conversion of the new dimensions
+    DataMatrix expectedData = selectColumns(full, newDimensions);
+    std::uint64_t expectedHash = DerivedDataCache::hashData(expectedData);
+    std::vector<float> expectedVariances;
+    std::vector<std::vector<float>> expectedNormalized;
+    standardizeData(expectedData, expectedVariances);
+    normalizeData(expectedData, expectedNormalized);
+
+    // Conversion of the old dimensions, changed by only converting the added columns
+    DataMatrix data = selectColumns(full, oldDimensions);
+    std::vector<std::uint64_t> columnHashes = DerivedDataCache::hashColumns(data);
+    std::vector<float> variances;
+    std::vector<std::vector<float>> normalized;
+    standardizeData(data, variances);
+    normalizeData(data, normalized);
+
+    DimensionChange change(oldDimensions, newDimensions);
+    DataMatrix addedColumns = selectColumns(full, change.addedDimensions);
+
+    std::vector<std::uint64_t> addedHashes = DerivedDataCache::hashColumns(addedColumns);
+    applyDimensionChange(change, columnHashes, addedHashes);
+
+    std::vector<float> addedVariances;
+    std::vector<std::vector<float>> addedNormalized;
+    standardizeData(addedColumns, addedVariances);
+    normalizeData(addedColumns, addedNormalized);
+
+    applyDimensionChange(change, data, addedColumns);
+    applyDimensionChange(change, variances, addedVariances);
+    applyDimensionChange(change, normalized, addedNormalized);
+
+    // Columns are transformed independently, so the results are identical, not just close
+    CHECK_EQUAL(DerivedDataCache::combineColumnHashes((int) data.rows(), columnHashes), expectedHash);
+    CHECK(data == expectedData);
+    CHECK(variances == expectedVariances);
+    CHECK(normalized == expectedNormalized);
+}
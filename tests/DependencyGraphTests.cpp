@@ -0,0 +1,125 @@
+#include "TestSuite.h"
+
+#include "Compute/ComputeProgress.h"
+#include "Compute/DependencyGraph.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    /**
+     *   a   b
+     *    \ / \
+     *     c   d
+     *      \ /
+     *       e
+     */
+    struct DiamondGraph
+    {
+        DependencyGraph                 graph;
+        std::vector<std::atomic<int>>   counts = std::vector<std::atomic<int>>(5);  /** Computations of a to e */
+        DependencyGraph::NodeId         a, b, c, d, e;
+
+        DiamondGraph()
+        {
+            a = graph.addNode("a", {}, [this]() { counts[0]++; });
+            b = graph.addNode("b", {}, [this]() { counts[1]++; });
+            c = graph.addNode("c", { a, b }, [this]() { counts[2]++; });
+            d = graph.addNode("d", { b }, [this]() { counts[3]++; });
+            e = graph.addNode("e", { c, d }, [this]() { counts[4]++; });
+        }
+
+        std::vector<int> getCounts() const
+        {
+            std::vector<int> values;
+            for (const std::atomic<int>& count : counts)
+                values.push_back(count.load());
+            return values;
+        }
+    };
+}
+
+TEST_CASE(DependencyGraph, ComputesEachNodeOnce)
+{
+    DiamondGraph diamond;
+    diamond.graph.update(diamond.e);
+    CHECK(diamond.getCounts() == std::vector<int>({ 1, 1, 1, 1, 1 }));
+    CHECK(!diamond.graph.isDirty(diamond.e));
+
+    // Clean nodes aren't computed again
+    diamond.graph.update(diamond.e);
+    CHECK(diamond.getCounts() == std::vector<int>({ 1, 1, 1, 1, 1 }));
+}
+
+TEST_CASE(DependencyGraph, InvalidatePropagates)
+{
+    DiamondGraph diamond;
+    diamond.graph.update(diamond.e);
+
+    diamond.graph.invalidate(diamond.a);
+    CHECK(diamond.graph.isDirty(diamond.a));
+    CHECK(!diamond.graph.isDirty(diamond.b));
+    CHECK(diamond.graph.isDirty(diamond.c));
+    CHECK(!diamond.graph.isDirty(diamond.d));
+    CHECK(diamond.graph.isDirty(diamond.e));
+
+    // Only the targets and their dirty inputs are computed
+    diamond.graph.update(diamond.c);
+    CHECK(diamond.getCounts() == std::vector<int>({ 2, 1, 2, 1, 1 }));
+    CHECK(diamond.graph.isDirty(diamond.e));
+
+    diamond.graph.update(diamond.e);
+    CHECK(diamond.getCounts() == std::vector<int>({ 2, 1, 2, 1, 2 }));
+}
+
+TEST_CASE(DependencyGraph, CallingThreadOnly)
+{
+    DependencyGraph graph;
+    std::thread::id callingThread = std::this_thread::get_id();
+    std::atomic<int> numOnCallingThread(0);
+
+    std::vector<DependencyGraph::NodeId> nodes;
+    for (int i = 0; i < 4; i++)
+    {
+        nodes.push_back(graph.addNode("node", {}, [&]()
+        {
+            if (std::this_thread::get_id() == callingThread)
+                numOnCallingThread++;
+        }, true));
+    }
+
+    graph.update(nodes);
+    CHECK_EQUAL(numOnCallingThread.load(), 4);
+}
+
+TEST_CASE(DependencyGraph, CancelAndResume)
+{
+    DiamondGraph diamond;
+    ComputeProgress progress;
+
+    // Cancelled while the first level is computed, the levels after it are left dirty
+    diamond.graph.invalidate(diamond.a);
+    diamond.graph.invalidate(diamond.b);
+    DependencyGraph::NodeId cancel = diamond.graph.addNode("cancel", {}, [&progress]() { progress.cancel(); });
+    DependencyGraph::NodeId target = diamond.graph.addNode("target", { diamond.e, cancel }, []() {});
+
+    diamond.graph.update({ target }, &progress);
+    CHECK(diamond.getCounts() == std::vector<int>({ 1, 1, 0, 0, 0 }));
+    CHECK(!diamond.graph.isDirty(diamond.a));
+    CHECK(!diamond.graph.isDirty(diamond.b));
+    CHECK(!diamond.graph.isDirty(cancel));
+    CHECK(diamond.graph.isDirty(diamond.c));
+    CHECK(diamond.graph.isDirty(diamond.d));
+    CHECK(diamond.graph.isDirty(diamond.e));
+    CHECK(diamond.graph.isDirty(target));
+    CHECK(progress.getProgress() < 1);
+
+    // Resuming only computes what was left
+    progress.reset();
+    diamond.graph.update({ target }, &progress);
+    CHECK(diamond.getCounts() == std::vector<int>({ 1, 1, 1, 1, 1 }));
+    CHECK(!diamond.graph.isDirty(target));
+    CHECK_EQUAL(progress.getProgress(), 1.0f);
+}
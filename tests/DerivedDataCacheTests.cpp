@@ -0,0 +1,106 @@
+#include "TestSuite.h"
+#include "TestData.h"
+
+#include "Compute/DataTransformations.h"
+#include "Compute/FloodWorkingSet.h"
+#include "Compute/KnnGraph.h"
+#include "IO/DerivedDataCache.h"
+
+#include <cstdint>
+#include <vector>
+
+TEST_CASE(DerivedDataCache, HashData)
+{
+    DataMatrix data = TestData::makeClusteredData(200, 10, 3, 4);
+    std::uint64_t hash = DerivedDataCache::hashData(data);
+    CHECK_EQUAL(DerivedDataCache::hashData(data), hash);
+
+    // Column hashes combine to the hash of the matrix, so changed columns can be hashed on their own
+    CHECK_EQUAL(DerivedDataCache::combineColumnHashes((int) data.rows(), DerivedDataCache::hashColumns(data)), hash);
+
+    DataMatrix changed = data;
+    changed(5, 5) += 1e-6f;
+    CHECK(DerivedDataCache::hashData(changed) != hash);
+
+    // Same values in another shape are other data
+    DataMatrix reshaped = Eigen::Map<DataMatrix>(data.data(), 100, 20);
+    CHECK(DerivedDataCache::hashData(reshaped) != hash);
+}
+
+TEST_CASE(DerivedDataCache, PreprocessedRoundTrip)
+{
+    DataMatrix data = TestData::makeClusteredData(1003, 37, 6, 5);
+    std::uint64_t hash = DerivedDataCache::hashData(data);
+
+    std::vector<float> variances;
+    std::vector<std::vector<float>> normalized;
+    standardizeData(data, variances);
+    normalizeData(data, normalized);
+
+    DerivedDataCache cache;
+    cache.setDirectory(TestData::makeTemporaryDirectory("SpaceWalkerTests_Preprocessed"));
+
+    DataMatrix readData;
+    std::vector<float> readVariances;
+    std::vector<std::vector<float>> readNormalized;
+    CHECK(!cache.readPreprocessed(hash, readData, readVariances, readNormalized));
+    CHECK_EQUAL(readData.size(), 0);
+
+    cache.writePreprocessed(hash, data, variances, normalized);
+    CHECK(cache.readPreprocessed(hash, readData, readVariances, readNormalized));
+    CHECK(readData == data);
+    CHECK(readVariances == variances);
+
+    // Normalized data is stored quantized, so only the levels the working set uses survive
+    CHECK_EQUAL(readNormalized.size(), normalized.size());
+    bool sameLevels = readNormalized.size() == normalized.size();
+    for (size_t d = 0; sameLevels && d < normalized.size(); d++)
+    {
+        sameLevels = readNormalized[d].size() == normalized[d].size();
+        for (size_t i = 0; sameLevels && i < normalized[d].size(); i++)
+            sameLevels = FloodWorkingSet::toLevel(readNormalized[d][i]) == FloodWorkingSet::toLevel(normalized[d][i]);
+    }
+    CHECK(sameLevels);
+
+    CHECK(!cache.readPreprocessed(hash + 1, readData, readVariances, readNormalized));
+}
+
+TEST_CASE(DerivedDataCache, KnnGraphRoundTrip)
+{
+    DataMatrix data = TestData::makeClusteredData(400, 6, 4, 6);
+    std::uint64_t hash = DerivedDataCache::hashData(data);
+
+    KnnGraphBuild build;
+    TestData::buildKnnGraph(data, 12, build.largeGraph);
+    build.graph.build(build.largeGraph, 5);
+
+    DerivedDataCache cache;
+    cache.setDirectory(TestData::makeTemporaryDirectory("SpaceWalkerTests_KnnGraphs"));
+    cache.writeKnnGraphs(hash, false, build);
+
+    // Graphs built with shared distances are other entries
+    KnnGraphBuild readBuild;
+    CHECK(!cache.readKnnGraphs(hash, true, readBuild));
+
+    CHECK(cache.readKnnGraphs(hash, false, readBuild));
+    CHECK(readBuild.largeGraph.getNeighbours() == build.largeGraph.getNeighbours());
+    CHECK_EQUAL(readBuild.largeGraph.getNumNeighbours(), 12);
+    CHECK(readBuild.graph.getNeighbours() == build.graph.getNeighbours());
+    CHECK_EQUAL(readBuild.graph.getNumNeighbours(), 5);
+    CHECK(readBuild.sourceGraph.getNeighbours().empty());
+}
+
+TEST_CASE(DerivedDataCache, Disabled)
+{
+    DataMatrix data = TestData::makeClusteredData(50, 4, 2, 7);
+    std::vector<float> variances;
+    std::vector<std::vector<float>> normalized;
+    standardizeData(data, variances);
+    normalizeData(data, normalized);
+
+    // Without a directory nothing is written or read
+    DerivedDataCache cache;
+    CHECK(!cache.isEnabled());
+    cache.writePreprocessed(1, data, variances, normalized);
+    CHECK(!cache.readPreprocessed(1, data, variances, normalized));
+}
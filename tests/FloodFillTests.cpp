@@ -0,0 +1,113 @@
+#include "TestSuite.h"
+#include "TestData.h"
+
+#include "Compute/FloodFill.h"
+#include "Compute/KnnGraph.h"
+#include "Compute/MonotonicArena.h"
+
+#include <vector>
+
+namespace
+{
+    /** The original flood fill, expands the not yet visited nodes of the previous wave in full */
+    std::vector<std::vector<nint>> computeBaselineWaves(const KnnGraph& knnGraph, nint selectedPoint, int numWaves)
+    {
+        const auto& neighbours = knnGraph.getNeighbours();
+
+        std::vector<std::vector<nint>> waves(numWaves);
+        std::vector<nint> currentNodes = neighbours[selectedPoint];
+        std::vector<bool> visitedNodes(neighbours.size(), false);
+
+        visitedNodes[selectedPoint] = true;
+        waves[0].push_back(selectedPoint);
+
+        for (int w = 1; w < numWaves; w++)
+        {
+            std::vector<nint> newNodes;
+            for (nint node : currentNodes)
+            {
+                if (visitedNodes[node])
+                    continue;
+
+                visitedNodes[node] = true;
+                waves[w].push_back(node);
+                newNodes.insert(newNodes.end(), neighbours[node].begin(), neighbours[node].end());
+            }
+            currentNodes = newNodes;
+        }
+
+        return waves;
+    }
+
+    std::vector<nint> flatten(const std::vector<std::vector<nint>>& waves)
+    {
+        std::vector<nint> nodes;
+        for (const std::vector<nint>& wave : waves)
+            nodes.insert(nodes.end(), wave.begin(), wave.end());
+        return nodes;
+    }
+
+    const KnnGraph& getTestGraph()
+    {
+        static KnnGraph knnGraph;
+        if (knnGraph.getNeighbours().empty())
+            TestData::buildKnnGraph(TestData::makeClusteredData(500, 8, 5, 1), 6, knnGraph);
+        return knnGraph;
+    }
+}
+
+TEST_CASE(FloodFill, MatchesBaseline)
+{
+    const KnnGraph& knnGraph = getTestGraph();
+
+    for (int numWaves : { 1, 2, 5, 12 })
+    {
+        FloodFill floodFill(numWaves);
+        for (nint seed : { 0, 17, 250, 499 })
+        {
+            floodFill.compute(knnGraph, seed);
+
+            std::vector<std::vector<nint>> expectedWaves = computeBaselineWaves(knnGraph, seed, numWaves);
+            CHECK(floodFill.getWaves() == expectedWaves);
+            CHECK(floodFill.getAllNodes() == flatten(expectedWaves));
+            CHECK_EQUAL(floodFill.getTotalNumNodes(), (bigint) flatten(expectedWaves).size());
+        }
+    }
+}
+
+TEST_CASE(FloodFill, ArenaMatchesHeap)
+{
+    const KnnGraph& knnGraph = getTestGraph();
+
+    MonotonicArena arena;
+    FloodFill heapFlood(8);
+    FloodFill arenaFlood(8);
+    for (nint seed = 0; seed < 500; seed += 37)
+    {
+        arena.reset();
+        heapFlood.compute(knnGraph, seed);
+        arenaFlood.compute(knnGraph, seed, &arena);
+
+        CHECK(arenaFlood.getWaves() == heapFlood.getWaves());
+    }
+}
+
+TEST_CASE(FloodFill, ChangeNumWaves)
+{
+    const KnnGraph& knnGraph = getTestGraph();
+
+    FloodFill floodFill(10);
+    floodFill.compute(knnGraph, 42);
+    std::uint64_t version = floodFill.getVersion();
+
+    // Fewer waves keep the flood, so results cached under its version stay valid
+    floodFill.setNumWaves(4);
+    CHECK_EQUAL(floodFill.getNumWaves(), 4);
+    CHECK(floodFill.getWaves() == computeBaselineWaves(knnGraph, 42, 4));
+    CHECK_EQUAL(floodFill.getVersion(), version);
+
+    floodFill.setNumWaves(7);
+    CHECK(floodFill.getWaves() == computeBaselineWaves(knnGraph, 42, 7));
+    CHECK(floodFill.getAllNodes() == flatten(computeBaselineWaves(knnGraph, 42, 7)));
+    CHECK(floodFill.getVersion() != version);
+}
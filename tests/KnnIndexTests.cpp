@@ -0,0 +1,89 @@
+#include "TestSuite.h"
+
+#include "Compute/KnnIndex.h"
+#include "TestData.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    constexpr int NUM_POINTS = 1000;
+    constexpr int NUM_NEIGHBOURS = 10;
+
+    void search(const DataMatrix& data, bool preciseKnn, knn::Metric metric, std::vector<int>& indices, std::vector<float>& distances)
+    {
+        knn::Index index;
+        index.setPreciseKnn(preciseKnn);
+        index.create((int) data.cols(), metric);
+        index.addData(data);
+        index.search(data, NUM_NEIGHBOURS, indices, distances);
+    }
+
+    /** Fraction of the neighbours in the exact results that were also found */
+    float computeRecall(const std::vector<int>& indices, const std::vector<int>& exactIndices)
+    {
+        int numFound = 0;
+        for (size_t i = 0; i < exactIndices.size(); i += NUM_NEIGHBOURS)
+        {
+            for (int k = 0; k < NUM_NEIGHBOURS; k++)
+            {
+                if (std::find(indices.begin() + i, indices.begin() + i + NUM_NEIGHBOURS, exactIndices[i + k]) != indices.begin() + i + NUM_NEIGHBOURS)
+                    numFound++;
+            }
+        }
+        return (float) numFound / exactIndices.size();
+    }
+}
+
+TEST_CASE(KnnIndex, ExactSearch)
+{
+    DataMatrix data = TestData::makeClusteredData(NUM_POINTS, 8, 5, 7);
+
+    std::vector<int> indices;
+    std::vector<float> distances;
+    search(data, true, knn::Metric::EUCLIDEAN, indices, distances);
+    CHECK_EQUAL(indices.size(), (size_t) NUM_POINTS * NUM_NEIGHBOURS);
+    CHECK_EQUAL(distances.size(), (size_t) NUM_POINTS * NUM_NEIGHBOURS);
+
+    // Every point finds itself first, followed by its neighbours from near to far
+    int numErrors = 0;
+    for (int i = 0; i < NUM_POINTS; i++)
+    {
+        const int* row = &indices[i * NUM_NEIGHBOURS];
+        if (row[0] != i || !std::is_sorted(distances.begin() + i * NUM_NEIGHBOURS, distances.begin() + (i + 1) * NUM_NEIGHBOURS))
+            numErrors++;
+    }
+    CHECK_EQUAL(numErrors, 0);
+}
+
+TEST_CASE(KnnIndex, ApproximateSearch)
+{
+    DataMatrix data = TestData::makeClusteredData(NUM_POINTS, 8, 5, 7);
+
+    std::vector<int> indices;
+    std::vector<float> distances;
+    search(data, false, knn::Metric::ANGULAR, indices, distances);
+    CHECK_EQUAL(indices.size(), (size_t) NUM_POINTS * NUM_NEIGHBOURS);
+    CHECK_EQUAL(distances.size(), (size_t) NUM_POINTS * NUM_NEIGHBOURS);
+
+    // Every result of annoy is a valid point, and each point finds itself
+    int numErrors = 0;
+    for (int i = 0; i < NUM_POINTS; i++)
+    {
+        auto rowBegin = indices.begin() + i * NUM_NEIGHBOURS;
+        auto rowEnd = rowBegin + NUM_NEIGHBOURS;
+        bool valid = std::all_of(rowBegin, rowEnd, [](int index) { return index >= 0 && index < NUM_POINTS; });
+        if (!valid || std::find(rowBegin, rowEnd, i) == rowEnd)
+            numErrors++;
+    }
+    CHECK_EQUAL(numErrors, 0);
+
+    // Angular distances order neighbours like Euclidean distances between normalized points
+    DataMatrix normalizedData = data.rowwise().normalized();
+    std::vector<int> exactIndices;
+    std::vector<float> exactDistances;
+    search(normalizedData, true, knn::Metric::EUCLIDEAN, exactIndices, exactDistances);
+
+    CHECK(computeRecall(indices, exactIndices) > 0.9f);
+}
@@ -0,0 +1,232 @@
+#include "TestSuite.h"
+#include "TestData.h"
+#include "SyntheticData.h"
+
+#include "Compute/ComputeProgress.h"
+#include "Compute/DataTransformations.h"
+#include "Compute/HoverPipeline.h"
+#include "Compute/KnnGraph.h"
+#include "Compute/RankingAtlas.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    constexpr int TOP_K = 8;
+
+    /** Inputs of the hover pipeline for a small synthetic tissue */
+    struct AtlasInputs
+    {
+        DataMatrix                      data;
+        DataMatrix                      projection;
+        std::vector<float>              variances;
+        std::vector<std::vector<float>> normalizedData;
+        KnnGraph                        knnGraph;
+        std::vector<nint>               mask;
+        std::vector<float>              localHighDimensionality;
+        HoverInputs                     inputs;
+
+        AtlasInputs()
+        {
+            SyntheticDataSettings settings;
+            settings.numPoints = 600;
+            settings.numDimensions = 24;
+            settings.layout = TissueLayout::CLUSTERED;
+
+            SyntheticData synthetic;
+            generateSyntheticData(settings, synthetic);
+
+            data = synthetic.data;
+            projection = synthetic.projection;
+            standardizeData(data, variances);
+            normalizeData(data, normalizedData);
+            TestData::buildKnnGraph(data, 10, knnGraph);
+
+            inputs.data = &data;
+            inputs.projection = &projection;
+            inputs.baseData = &data;
+            inputs.normalizedData = &normalizedData;
+            inputs.variances = &variances;
+            inputs.knnGraph = &knnGraph;
+            inputs.mask = &mask;
+            inputs.localHighDimensionality = &localHighDimensionality;
+        }
+    };
+
+    const AtlasInputs& getAtlasInputs()
+    {
+        static AtlasInputs atlasInputs;
+        return atlasInputs;
+    }
+
+    HoverSettings makeSettings(filters::FilterType filterType, bool restrictToFlood)
+    {
+        const DataMatrix& projection = getAtlasInputs().projection;
+
+        HoverSettings settings;
+        settings.filterType = filterType;
+        settings.restrictToFlood = restrictToFlood;
+        settings.numWaves = 6;
+        settings.numRankedDimensions = 3;
+        settings.innerFilterRadius = 0.025f;
+        settings.outerFilterRadius = 0.05f;
+        settings.hdInnerFilterSize = 2;
+        settings.projectionSize = std::max(projection.col(0).maxCoeff() - projection.col(0).minCoeff(), projection.col(1).maxCoeff() - projection.col(1).minCoeff());
+        return settings;
+    }
+
+    /** Compare the atlas with rankings computed by the hover pipeline for every point */
+    void checkAgainstPipeline(const HoverSettings& settings)
+    {
+        const HoverInputs& inputs = getAtlasInputs().inputs;
+
+        RankingAtlas atlas;
+        ComputeProgress progress;
+        CHECK(RankingAtlas::isSupported(settings, inputs));
+        CHECK(atlas.build(settings, inputs, {}, TOP_K, &progress));
+        CHECK_EQUAL(atlas.getNumPoints(), (int) inputs.data->rows());
+        CHECK_EQUAL(atlas.getTopK(), TOP_K);
+        CHECK_EQUAL(progress.getProgress(), 1.0f);
+        CHECK(atlas.matches(settings));
+
+        HoverSettings topKSettings = settings;
+        topKSettings.numRankedDimensions = TOP_K;
+
+        HoverPipeline pipeline;
+        FloodFill floodFill(0);
+        FloodWorkingSet workingSet;
+        std::vector<int> dimRanking;
+        std::vector<int> atlasRanking;
+
+        int numMismatches = 0;
+        double maxScoreError = 0;
+        for (nint point = 0; point < atlas.getNumPoints(); point++)
+        {
+            if (RankingAtlas::needsFlood(settings))
+                pipeline.computeFlood(topKSettings, inputs, point, floodFill, workingSet);
+            pipeline.computeRanking(topKSettings, inputs, point, floodFill, workingSet, dimRanking);
+
+            atlas.getRanking(point, TOP_K, atlasRanking);
+            if (atlasRanking != dimRanking)
+                numMismatches++;
+
+            // Scores are stored as half floats, with 11 bits of precision
+            const std::vector<float>& scores = pipeline.getRankingScores(settings.filterType);
+            for (int k = 0; k < TOP_K; k++)
+            {
+                double score = scores[dimRanking[k]];
+                double error = std::abs(atlas.getScore(point, k) - score) / std::max(std::abs(score), 1e-3);
+                maxScoreError = std::max(maxScoreError, error);
+            }
+        }
+
+        CHECK_EQUAL(numMismatches, 0);
+        CHECK(maxScoreError < 1e-3);
+
+        // Fewer ranked dimensions are a prefix of the stored ones
+        atlas.getRanking(17, 3, atlasRanking);
+        CHECK_EQUAL(atlasRanking.size(), 3u);
+    }
+}
+
+TEST_CASE(RankingAtlas, MatchesSpatialRanking)
+{
+    checkAgainstPipeline(makeSettings(filters::FilterType::SPATIAL_PEAK, false));
+}
+
+TEST_CASE(RankingAtlas, MatchesRestrictedSpatialRanking)
+{
+    checkAgainstPipeline(makeSettings(filters::FilterType::SPATIAL_PEAK, true));
+}
+
+TEST_CASE(RankingAtlas, MatchesHDRanking)
+{
+    checkAgainstPipeline(makeSettings(filters::FilterType::HD_PEAK, false));
+}
+
+TEST_CASE(RankingAtlas, MatchesSettingsAndVersions)
+{
+    const HoverInputs& inputs = getAtlasInputs().inputs;
+
+    HoverSettings spatialSettings = makeSettings(filters::FilterType::SPATIAL_PEAK, false);
+    RankingAtlas atlas;
+    CHECK(atlas.build(spatialSettings, inputs, {}, TOP_K, nullptr));
+
+    HoverSettings settings = spatialSettings;
+    settings.numRankedDimensions = TOP_K + 1;
+    CHECK(!atlas.matches(settings));
+
+    settings = spatialSettings;
+    settings.numRankedDimensions = filters::FULL_RANKING;
+    CHECK(!atlas.matches(settings));
+
+    settings = spatialSettings;
+    settings.innerFilterRadius += 0.01f;
+    CHECK(!atlas.matches(settings));
+
+    settings = spatialSettings;
+    settings.filterType = filters::FilterType::HD_PEAK;
+    CHECK(!atlas.matches(settings));
+
+    settings = spatialSettings;
+    settings.inputVersions.data++;
+    CHECK(!atlas.matches(settings));
+
+    settings = spatialSettings;
+    settings.inputVersions.mask++;
+    CHECK(!atlas.matches(settings));
+
+    // Settings that don't affect the ranking, and the graph when no flood is involved, still match
+    settings = spatialSettings;
+    settings.inputVersions.graph++;
+    settings.numWaves++;
+    settings.hdInnerFilterSize++;
+    CHECK(atlas.matches(settings));
+
+    HoverSettings hdSettings = makeSettings(filters::FilterType::HD_PEAK, false);
+    CHECK(atlas.build(hdSettings, inputs, {}, TOP_K, nullptr));
+
+    settings = hdSettings;
+    settings.inputVersions.graph++;
+    CHECK(!atlas.matches(settings));
+
+    settings = hdSettings;
+    settings.numWaves++;
+    CHECK(!atlas.matches(settings));
+
+    settings = hdSettings;
+    settings.innerFilterRadius += 0.01f;
+    CHECK(atlas.matches(settings));
+}
+
+TEST_CASE(RankingAtlas, Unsupported)
+{
+    const HoverInputs& inputs = getAtlasInputs().inputs;
+
+    // Floods can't be precomputed without a graph
+    HoverSettings settings = makeSettings(filters::FilterType::HD_PEAK, false);
+    settings.graphAvailable = false;
+    CHECK(!RankingAtlas::isSupported(settings, inputs));
+
+    settings = makeSettings(filters::FilterType::SPATIAL_PEAK, false);
+    settings.graphAvailable = false;
+    CHECK(RankingAtlas::isSupported(settings, inputs));
+}
+
+TEST_CASE(RankingAtlas, Cancel)
+{
+    const HoverInputs& inputs = getAtlasInputs().inputs;
+    HoverSettings settings = makeSettings(filters::FilterType::SPATIAL_PEAK, false);
+
+    RankingAtlas atlas;
+    CHECK(atlas.build(settings, inputs, {}, TOP_K, nullptr));
+
+    // A cancelled build leaves the atlas empty rather than partially filled
+    ComputeProgress progress;
+    progress.cancel();
+    CHECK(!atlas.build(settings, inputs, {}, TOP_K, &progress));
+    CHECK(atlas.isEmpty());
+    CHECK(!atlas.matches(settings));
+}
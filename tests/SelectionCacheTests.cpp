@@ -0,0 +1,166 @@
+#include "TestSuite.h"
+#include "TestData.h"
+
+#include "Compute/FloodFill.h"
+#include "Compute/HoverPipeline.h"
+#include "Compute/KnnGraph.h"
+#include "Compute/LruCache.h"
+#include "Compute/SelectionCache.h"
+
+#include <string>
+#include <vector>
+
+TEST_CASE(LruCache, EvictsLeastRecentlyUsed)
+{
+    std::vector<int> evicted;
+    LruCache<int, std::string> cache(3);
+    cache.setEvictionHandler([&evicted](const int& key, const std::string&) { evicted.push_back(key); });
+
+    cache.insert(1, "one");
+    cache.insert(2, "two");
+    cache.insert(3, "three");
+
+    // Finding an entry makes it the most recently used, containment checks don't
+    CHECK(cache.find(1) != nullptr);
+    CHECK(cache.contains(2));
+    cache.insert(4, "four");
+
+    CHECK(evicted == std::vector<int>({ 2 }));
+    CHECK(!cache.contains(2));
+    CHECK_EQUAL(cache.size(), 3u);
+    CHECK_EQUAL(*cache.find(1), "one");
+    CHECK_EQUAL(*cache.find(4), "four");
+
+    // Replacing an entry doesn't evict
+    cache.insert(3, "drei");
+    CHECK_EQUAL(*cache.find(3), "drei");
+    CHECK(evicted.size() == 1);
+
+    cache.setCapacity(1);
+    CHECK_EQUAL(cache.size(), 1u);
+    CHECK(cache.contains(3));
+
+    cache.erase(3);
+    CHECK(cache.find(3) == nullptr);
+    CHECK(evicted == std::vector<int>({ 2, 1, 4 }));
+}
+
+TEST_CASE(LruCache, ClearCallsEvictionHandler)
+{
+    int numEvicted = 0;
+    LruCache<int, int> cache(4);
+    cache.setEvictionHandler([&numEvicted](const int&, const int&) { numEvicted++; });
+
+    for (int i = 0; i < 3; i++)
+        cache.insert(i, i);
+    cache.clear();
+
+    CHECK_EQUAL(numEvicted, 3);
+    CHECK_EQUAL(cache.size(), 0u);
+    CHECK(!cache.contains(0));
+}
+
+TEST_CASE(LruCache, OverwriteReusesEvictedValue)
+{
+    LruCache<int, std::vector<int>> cache(1);
+    cache.insertForOverwrite(1).assign(100, 1);
+    const int* storage = cache.find(1)->data();
+
+    // The evicted buffer is handed out again, the caller overwrites it
+    std::vector<int>& value = cache.insertForOverwrite(2);
+    CHECK(!cache.contains(1));
+    CHECK(value.data() == storage);
+    CHECK_EQUAL(value.size(), 100u);
+}
+
+TEST_CASE(SelectionCache, Invalidation)
+{
+    KnnGraph knnGraph;
+    TestData::buildKnnGraph(TestData::makeClusteredData(100, 4, 2, 8), 4, knnGraph);
+
+    FloodFill floodFill(3);
+    floodFill.compute(knnGraph, 7);
+
+    SelectionCache cache(8);
+    HoverSettings settings;
+
+    const auto insert = [&]()
+    {
+        settings.inputVersions = cache.getVersions();
+        FloodKey floodKey = HoverPipeline::makeFloodKey(settings, 7);
+        cache.insertFlood(floodKey, floodFill, false);
+        cache.insertRanking(HoverPipeline::makeRankingKey(settings, floodKey, 7), { 1, 0 });
+        cache.insertHistograms(HoverPipeline::makeHistogramKey(settings, floodKey), { { 1, 2 } });
+    };
+
+    insert();
+    FloodKey floodKey = HoverPipeline::makeFloodKey(settings, 7);
+    RankingKey rankingKey = HoverPipeline::makeRankingKey(settings, floodKey, 7);
+    HistogramKey histogramKey = HoverPipeline::makeHistogramKey(settings, floodKey);
+
+    const FloodFill* cachedFlood = cache.findFlood(floodKey);
+    CHECK(cachedFlood != nullptr && cachedFlood->getWaves() == floodFill.getWaves());
+    CHECK(cache.findRanking(rankingKey) != nullptr && *cache.findRanking(rankingKey) == std::vector<int>({ 1, 0 }));
+    CHECK(cache.findHistograms(histogramKey) != nullptr);
+
+    // Floods don't depend on the data
+    cache.invalidateData();
+    CHECK_EQUAL(cache.getVersions().data, 1u);
+    CHECK(cache.containsFlood(floodKey));
+    CHECK(!cache.containsRanking(rankingKey));
+    CHECK(cache.findHistograms(histogramKey) == nullptr);
+
+    // Keys made with the new versions miss until the stages are computed again
+    settings.inputVersions = cache.getVersions();
+    CHECK(cache.findRanking(HoverPipeline::makeRankingKey(settings, floodKey, 7)) == nullptr);
+
+    insert();
+    cache.invalidateGraph();
+    CHECK_EQUAL(cache.getVersions().graph, 1u);
+    CHECK(!cache.containsFlood(HoverPipeline::makeFloodKey(settings, 7)));
+
+    insert();
+    cache.invalidateMask();
+    CHECK_EQUAL(cache.getVersions().mask, 1u);
+    CHECK(!cache.containsFlood(HoverPipeline::makeFloodKey(settings, 7)));
+
+    insert();
+    cache.invalidateAll();
+    CHECK_EQUAL(cache.getVersions().data, 2u);
+    CHECK_EQUAL(cache.getVersions().graph, 2u);
+    CHECK_EQUAL(cache.getVersions().mask, 2u);
+    CHECK(!cache.containsFlood(HoverPipeline::makeFloodKey(settings, 7)));
+    CHECK(!cache.containsRanking(HoverPipeline::makeRankingKey(settings, HoverPipeline::makeFloodKey(settings, 7), 7)));
+}
+
+TEST_CASE(SelectionCache, PrefetchStats)
+{
+    KnnGraph knnGraph;
+    TestData::buildKnnGraph(TestData::makeClusteredData(100, 4, 2, 9), 4, knnGraph);
+
+    SelectionCache cache(2);
+    HoverSettings settings;
+    FloodFill floodFill(3);
+
+    for (nint seed : { 1, 2, 3 })
+    {
+        floodFill.compute(knnGraph, seed);
+        cache.insertFlood(HoverPipeline::makeFloodKey(settings, seed), floodFill, true);
+    }
+
+    // The first speculative flood was evicted before use, the second one is used
+    CHECK(cache.findFlood(HoverPipeline::makeFloodKey(settings, 1)) == nullptr);
+    CHECK(cache.findFlood(HoverPipeline::makeFloodKey(settings, 2)) != nullptr);
+    CHECK(cache.findFlood(HoverPipeline::makeFloodKey(settings, 2)) != nullptr);
+
+    SelectionCache::Stats stats = cache.getStats();
+    CHECK_EQUAL(stats.prefetched, 3u);
+    CHECK_EQUAL(stats.prefetchHits, 1u);
+    CHECK_EQUAL(stats.prefetchWasted, 1u);
+    CHECK_EQUAL(stats.lookups, 3u);
+    CHECK_EQUAL(stats.hits, 2u);
+
+    // Clearing drops the speculative flood that was never used
+    cache.invalidateGraph();
+    CHECK_EQUAL(cache.getStats().prefetchWasted, 2u);
+}
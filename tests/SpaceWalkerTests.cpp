@@ -0,0 +1,24 @@
+#include "TestSuite.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Runs the tests of the compute library: all of them, or the suites given as arguments.
+ * Returns non-zero when a test failed or a suite doesn't exist.
+ */
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> suites(argv + 1, argv + argc);
+    for (const std::string& suite : suites)
+    {
+        if (!TestSuite::instance().hasSuite(suite))
+        {
+            std::cout << "Unknown test suite: " << suite << std::endl;
+            return 1;
+        }
+    }
+
+    return TestSuite::instance().run(suites) == 0 ? 0 : 1;
+}
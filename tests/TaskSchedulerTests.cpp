@@ -0,0 +1,212 @@
+#include "TestSuite.h"
+
+#include "Compute/TaskScheduler.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+    constexpr int NUM_WORKERS = 4;
+
+    /** Run function(begin, end, slot) over chunks of [begin, end) on the given scheduler */
+    template<typename Function>
+    void parallelForRanges(tasks::Scheduler& scheduler, int begin, int end, int grainSize, Function&& function)
+    {
+        using FunctionType = std::remove_reference_t<Function>;
+
+        scheduler.parallelFor(begin, end, grainSize, [](void* context, int rangeBegin, int rangeEnd, int slot)
+        {
+            (*static_cast<FunctionType*>(context))(rangeBegin, rangeEnd, slot);
+        }, (void*) &function);
+    }
+
+    /** Counts the visits of every index of a loop and the slots its chunks run on */
+    class LoopCheck
+    {
+    public:
+        LoopCheck(int begin, int end) :
+            _begin(begin),
+            _counts(std::make_unique<std::atomic<int>[]>(end - begin)),
+            _numIndices(end - begin),
+            _slotsInUse(std::make_unique<std::atomic<bool>[]>(tasks::Scheduler::MAX_SLOTS)),
+            _slotErrors(0)
+        {
+            for (int i = 0; i < _numIndices; i++)
+                _counts[i] = 0;
+            for (int s = 0; s < tasks::Scheduler::MAX_SLOTS; s++)
+                _slotsInUse[s] = false;
+        }
+
+        void visit(int begin, int end, int slot, int numSlots)
+        {
+            // Chunks running at the same time have different slots
+            if (slot < 0 || slot >= numSlots || _slotsInUse[slot].exchange(true))
+            {
+                _slotErrors++;
+                return;
+            }
+
+            count(begin, end);
+
+            _slotsInUse[slot] = false;
+        }
+
+        /** Count the visits of [begin, end) without checking the slot */
+        void count(int begin, int end)
+        {
+            for (int i = begin; i < end; i++)
+                _counts[i - _begin]++;
+        }
+
+        bool isEveryIndexOnce() const
+        {
+            for (int i = 0; i < _numIndices; i++)
+            {
+                if (_counts[i] != 1)
+                    return false;
+            }
+            return true;
+        }
+
+        int getSlotErrors() const { return _slotErrors; }
+
+    private:
+        int                                     _begin;
+        std::unique_ptr<std::atomic<int>[]>     _counts;
+        int                                     _numIndices;
+        std::unique_ptr<std::atomic<bool>[]>    _slotsInUse;
+        std::atomic<int>                        _slotErrors;
+    };
+}
+
+TEST_CASE(TaskScheduler, EveryIndexOnce)
+{
+    tasks::Scheduler scheduler(NUM_WORKERS);
+    CHECK_EQUAL(scheduler.getNumWorkers(), NUM_WORKERS);
+
+    for (int begin : { 0, -50 })
+    {
+        for (int count : { 1, 7, 1000, 100003 })
+        {
+            for (int grainSize : { 0, 1, 13, 4096 })
+            {
+                LoopCheck check(begin, begin + count);
+                int numSlots = scheduler.getNumSlots();
+                parallelForRanges(scheduler, begin, begin + count, grainSize, [&](int rangeBegin, int rangeEnd, int slot)
+                {
+                    check.visit(rangeBegin, rangeEnd, slot, numSlots);
+                });
+
+                CHECK(check.isEveryIndexOnce());
+                CHECK_EQUAL(check.getSlotErrors(), 0);
+            }
+        }
+    }
+}
+
+TEST_CASE(TaskScheduler, EmptyRange)
+{
+    tasks::Scheduler scheduler(NUM_WORKERS);
+
+    int numCalls = 0;
+    parallelForRanges(scheduler, 5, 5, 0, [&numCalls](int, int, int) { numCalls++; });
+    parallelForRanges(scheduler, 5, 3, 0, [&numCalls](int, int, int) { numCalls++; });
+    CHECK_EQUAL(numCalls, 0);
+}
+
+TEST_CASE(TaskScheduler, NestedLoops)
+{
+    constexpr int NUM_OUTER = 64;
+    constexpr int NUM_INNER = 257;
+
+    for (int maxNesting : { 1, 2 })
+    {
+        tasks::Scheduler scheduler(NUM_WORKERS);
+        scheduler.setMaxNesting(maxNesting);
+
+        LoopCheck check(0, NUM_OUTER * NUM_INNER);
+        std::atomic<int> numSerialInnerLoops(0);
+        parallelForRanges(scheduler, 0, NUM_OUTER, 1, [&](int outerBegin, int outerEnd, int)
+        {
+            for (int outer = outerBegin; outer < outerEnd; outer++)
+            {
+                // Inner loops run serially once the nesting limit is reached
+                int numInnerSlots = scheduler.getNumSlots();
+                if (numInnerSlots == 1)
+                    numSerialInnerLoops++;
+
+                // Each inner loop counts its own slots, they are only unique within the loop
+                LoopCheck innerCheck(0, NUM_INNER);
+                parallelForRanges(scheduler, 0, NUM_INNER, 16, [&](int innerBegin, int innerEnd, int slot)
+                {
+                    innerCheck.visit(innerBegin, innerEnd, slot, numInnerSlots);
+                    check.count(outer * NUM_INNER + innerBegin, outer * NUM_INNER + innerEnd);
+                });
+                CHECK(innerCheck.isEveryIndexOnce());
+                CHECK_EQUAL(innerCheck.getSlotErrors(), 0);
+            }
+        });
+
+        CHECK(check.isEveryIndexOnce());
+        if (maxNesting == 1)
+            CHECK_EQUAL(numSerialInnerLoops.load(), NUM_OUTER);
+    }
+}
+
+TEST_CASE(TaskScheduler, ConcurrentPriorities)
+{
+    constexpr int COUNT = 20000;
+
+    tasks::Scheduler scheduler(NUM_WORKERS);
+
+    // A background loop keeps the workers busy while interactive loops start and preempt it
+    LoopCheck backgroundCheck(0, COUNT);
+    std::thread backgroundThread([&]()
+    {
+        int numSlots = scheduler.getNumSlots();
+        parallelForRanges(scheduler, 0, COUNT, 1, [&](int begin, int end, int slot)
+        {
+            backgroundCheck.visit(begin, end, slot, numSlots);
+            std::this_thread::yield();
+        });
+    });
+
+    for (int i = 0; i < 20; i++)
+    {
+        tasks::ScopedPriority priority(tasks::Priority::INTERACTIVE);
+
+        LoopCheck interactiveCheck(0, COUNT);
+        int numSlots = scheduler.getNumSlots();
+        parallelForRanges(scheduler, 0, COUNT, 64, [&](int begin, int end, int slot)
+        {
+            interactiveCheck.visit(begin, end, slot, numSlots);
+        });
+
+        CHECK(interactiveCheck.isEveryIndexOnce());
+        CHECK_EQUAL(interactiveCheck.getSlotErrors(), 0);
+    }
+
+    backgroundThread.join();
+    CHECK(backgroundCheck.isEveryIndexOnce());
+    CHECK_EQUAL(backgroundCheck.getSlotErrors(), 0);
+}
+
+TEST_CASE(TaskScheduler, ThreadBudget)
+{
+    tasks::Scheduler scheduler(NUM_WORKERS);
+    scheduler.setThreadBudget(tasks::Priority::BACKGROUND, 2);
+    CHECK_EQUAL(scheduler.getNumSlots(), 2);
+
+    LoopCheck check(0, 10000);
+    parallelForRanges(scheduler, 0, 10000, 1, [&](int begin, int end, int slot)
+    {
+        check.visit(begin, end, slot, 2);
+    });
+
+    CHECK(check.isEveryIndexOnce());
+    CHECK_EQUAL(check.getSlotErrors(), 0);
+}
@@ -0,0 +1,64 @@
+#include "TestData.h"
+
+#include "Compute/KnnGraph.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <utility>
+
+DataMatrix TestData::makeClusteredData(int numPoints, int numDimensions, int numClusters, std::uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> normal;
+
+    DataMatrix centers(numClusters, numDimensions);
+    for (int c = 0; c < numClusters; c++)
+        for (int d = 0; d < numDimensions; d++)
+            centers(c, d) = normal(rng) * 4;
+
+    DataMatrix data(numPoints, numDimensions);
+    for (int i = 0; i < numPoints; i++)
+        for (int d = 0; d < numDimensions; d++)
+            data(i, d) = centers(i % numClusters, d) + normal(rng);
+
+    return data;
+}
+
+void TestData::buildKnnGraph(const DataMatrix& data, int numNeighbours, KnnGraph& graph)
+{
+    int numPoints = (int) data.rows();
+
+    std::vector<std::vector<nint>> neighbours(numPoints);
+    std::vector<std::pair<float, nint>> distances;
+    for (int i = 0; i < numPoints; i++)
+    {
+        distances.clear();
+        for (int j = 0; j < numPoints; j++)
+        {
+            if (j != i)
+                distances.emplace_back((data.row(i) - data.row(j)).squaredNorm(), j);
+        }
+
+        // Ties are broken by index, so the graph doesn't depend on the sort implementation
+        std::partial_sort(distances.begin(), distances.begin() + numNeighbours, distances.end());
+        for (int k = 0; k < numNeighbours; k++)
+            neighbours[i].push_back(distances[k].second);
+    }
+
+    setNeighbours(graph, std::move(neighbours), numNeighbours);
+}
+
+void TestData::setNeighbours(KnnGraph& graph, std::vector<std::vector<nint>> neighbours, int numNeighbours)
+{
+    graph._neighbours = std::move(neighbours);
+    graph._numNeighbours = numNeighbours;
+}
+
+std::string TestData::makeTemporaryDirectory(const std::string& name)
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    return directory.string();
+}
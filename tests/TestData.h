@@ -0,0 +1,29 @@
+#pragma once
+
+#include "DataMatrix.h"
+#include "Types.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class KnnGraph;
+
+/**
+ * Small inputs for the tests, generated deterministically so failures can be reproduced.
+ * Graphs are built by brute force, so the tests don't depend on a kNN library.
+ */
+class TestData
+{
+public:
+    /** Points scattered around numClusters random centers */
+    static DataMatrix makeClusteredData(int numPoints, int numDimensions, int numClusters, std::uint32_t seed);
+
+    /** Exact Euclidean k nearest neighbours of every point, without the point itself */
+    static void buildKnnGraph(const DataMatrix& data, int numNeighbours, KnnGraph& graph);
+
+    static void setNeighbours(KnnGraph& graph, std::vector<std::vector<nint>> neighbours, int numNeighbours);
+
+    /** Empty directory under the temporary directory, removed first if it exists */
+    static std::string makeTemporaryDirectory(const std::string& name);
+};
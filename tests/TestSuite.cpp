@@ -0,0 +1,59 @@
+#include "TestSuite.h"
+
+#include "Tracing.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+TestSuite& TestSuite::instance()
+{
+    static TestSuite suite;
+    return suite;
+}
+
+void TestSuite::add(const std::string& suite, const std::string& name, TestFunction function)
+{
+    _tests.push_back({ suite, name, function });
+}
+
+void TestSuite::fail(const char* file, int line, const std::string& message)
+{
+    _numFailures++;
+
+    std::lock_guard<std::mutex> lock(_outputMutex);
+    std::cout << "    " << file << ":" << line << ": check failed: " << message << std::endl;
+}
+
+int TestSuite::run(const std::vector<std::string>& suites)
+{
+    int numRun = 0;
+    int numFailed = 0;
+    for (const Test& test : _tests)
+    {
+        if (!suites.empty() && std::find(suites.begin(), suites.end(), test.suite) == suites.end())
+            continue;
+
+        std::cout << "[ RUN  ] " << test.suite << "." << test.name << std::endl;
+
+        _numFailures = 0;
+        std::uint64_t start = tracing::now();
+        test.function();
+        double milliseconds = (double) (tracing::now() - start) * 1e-6;
+
+        std::cout << (_numFailures == 0 ? "[   OK ] " : "[ FAIL ] ") << test.suite << "." << test.name
+            << " (" << std::fixed << std::setprecision(1) << milliseconds << " ms)" << std::endl;
+
+        numRun++;
+        if (_numFailures > 0)
+            numFailed++;
+    }
+
+    std::cout << numRun - numFailed << " of " << numRun << " tests passed" << std::endl;
+    return numFailed;
+}
+
+bool TestSuite::hasSuite(const std::string& suite) const
+{
+    return std::any_of(_tests.begin(), _tests.end(), [&suite](const Test& test) { return test.suite == suite; });
+}
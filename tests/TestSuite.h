@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Minimal test runner of the compute library.
+ *
+ * Tests are registered per suite with TEST_CASE and run by SpaceWalkerTests, either all of them
+ * or the suites named on the command line, so CTest can run every suite as its own test. A failed
+ * check is reported with its location and the test goes on, the run fails if any check failed.
+ *
+ *   TEST_CASE(FloodFill, MatchesBaseline)
+ *   {
+ *       CHECK(floodFill.getWaves() == expectedWaves);
+ *   }
+ */
+class TestSuite
+{
+public:
+    using TestFunction = void (*)();
+
+    struct Test
+    {
+        std::string     suite;
+        std::string     name;
+        TestFunction    function;
+    };
+
+    static TestSuite& instance();
+
+    void add(const std::string& suite, const std::string& name, TestFunction function);
+
+    /** Record a failed check of the running test, checks may run on the threads of the test */
+    void fail(const char* file, int line, const std::string& message);
+
+    /**
+     * Run the tests of the given suites, all tests if empty
+     * @return Number of failed tests
+     */
+    int run(const std::vector<std::string>& suites);
+
+    bool hasSuite(const std::string& suite) const;
+
+private:
+    std::vector<Test>   _tests;
+    std::atomic<int>    _numFailures{ 0 };  /** Failed checks of the running test */
+    std::mutex          _outputMutex;
+};
+
+/** Registers a test function while static objects are constructed */
+struct TestRegistration
+{
+    TestRegistration(const char* suite, const char* name, TestSuite::TestFunction function)
+    {
+        TestSuite::instance().add(suite, name, function);
+    }
+};
+
+#define TEST_CASE(suite, name) \
+    static void suite##_##name(); \
+    static TestRegistration suite##_##name##_registration(#suite, #name, suite##_##name); \
+    static void suite##_##name()
+
+#define CHECK(condition) \
+    do { if (!(condition)) TestSuite::instance().fail(__FILE__, __LINE__, #condition); } while (false)
+
+#define CHECK_EQUAL(actual, expected) \
+    do \
+    { \
+        const auto& actualValue = (actual); \
+        const auto& expectedValue = (expected); \
+        if (!(actualValue == expectedValue)) \
+        { \
+            std::ostringstream message; \
+            message << #actual " == " #expected " (" << actualValue << " != " << expectedValue << ")"; \
+            TestSuite::instance().fail(__FILE__, __LINE__, message.str()); \
+        } \
+    } while (false)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+    do \
+    { \
+        double actualValue = (actual); \
+        double expectedValue = (expected); \
+        if (!(std::abs(actualValue - expectedValue) <= (tolerance))) \
+        { \
+            std::ostringstream message; \
+            message << #actual " ~ " #expected " (" << actualValue << " != " << expectedValue << ")"; \
+            TestSuite::instance().fail(__FILE__, __LINE__, message.str()); \
+        } \
+    } while (false)